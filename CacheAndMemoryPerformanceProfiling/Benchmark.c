@@ -1,5 +1,6 @@
-// clang++ Benchmark.cpp -O3 -std=c11 -march=native -o Benchmark.out -lpthread
-// Uses clock_gettime(CLOCK_MONOTONIC). Ensure -O3 for best results
+// clang -O3 -std=c11 -march=native -o Benchmark.out Benchmark.c -lpthread -lm
+// Times with the shared TSC clock (Common/BenchResult.h), calibrated against
+// CLOCK_MONOTONIC. Ensure -O3 for best results
 // Made with help from ChatGPT
 
 #define _GNU_SOURCE
@@ -11,14 +12,25 @@
 #include <string.h>
 #include <errno.h>
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <assert.h>
+#include <math.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+#include "../Common/BenchResult.h"
+#include "../Common/PerfCounters.h"
+#include "StreamKernels.h"
 
 static inline uint64_t now_ns(void){
-    struct timespec ts ;
-    clock_gettime(CLOCK_MONOTONIC, &ts) ;
-    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec ;
+    return benchClockNs() ;
 }
 
 
@@ -34,41 +46,248 @@ void *alignedAllocPages(size_t alignment, size_t size){
     return ptr ;
 }
 
+// ---------------------- Backing store (--pages) ----------------------
+// MALLOC is the original posix_memalign path. The rest mmap the buffer:
+// 4K forces base pages (MADV_NOHUGEPAGE), THP aligns to 2 MiB and asks for
+// MADV_HUGEPAGE, HUGE2M/HUGE1G need pages reserved in nr_hugepages, and
+// POPULATE pre-faults 4K pages so no timed access takes a page fault.
+typedef enum { BACKING_MALLOC, BACKING_4K, BACKING_THP, BACKING_HUGE2M, BACKING_HUGE1G, BACKING_POPULATE, BACKING_COUNT } backing_t ;
+
+const char *backingNames[BACKING_COUNT] = {"malloc", "4k", "thp", "2m", "1g", "populate"} ;
+
+backing_t backing = BACKING_MALLOC ;
+
+#define HUGE_2M (2ull << 20)
+#define HUGE_1G (1ull << 30)
+
+size_t roundUp(size_t size, size_t unit){
+    return (size + unit - 1) / unit * unit ;
+}
+
+// Every benchmark buffer comes from here; release with freeBuffer(ptr, size)
+void *allocBuffer(size_t size){
+    if(backing == BACKING_MALLOC) return alignedAllocPages(64, size) ;
+#ifdef __linux__
+    void *p = MAP_FAILED ;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS ;
+    switch(backing){
+        case BACKING_4K:
+            p = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0) ;
+            if(p != MAP_FAILED) madvise(p, size, MADV_NOHUGEPAGE) ;
+            break ;
+        case BACKING_THP: {
+            // Over-map by 2 MiB and trim so the region starts on a huge page
+            size_t len = roundUp(size, HUGE_2M) ;
+            uint8_t *raw = mmap(NULL, len + HUGE_2M, PROT_READ | PROT_WRITE, flags, -1, 0) ;
+            if(raw == MAP_FAILED) break ;
+            uint8_t *aligned = (uint8_t *)roundUp((size_t)raw, HUGE_2M) ;
+            if(aligned > raw) munmap(raw, (size_t)(aligned - raw)) ;
+            if(aligned + len < raw + len + HUGE_2M) munmap(aligned + len, (size_t)(raw + len + HUGE_2M - (aligned + len))) ;
+            madvise(aligned, len, MADV_HUGEPAGE) ;
+            p = aligned ;
+            break ;
+        }
+        case BACKING_HUGE2M:
+        case BACKING_HUGE1G: {
+            size_t page = backing == BACKING_HUGE2M ? HUGE_2M : HUGE_1G ;
+            int shift = backing == BACKING_HUGE2M ? 21 : 30 ;
+            p = mmap(NULL, roundUp(size, page), PROT_READ | PROT_WRITE, flags | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0) ;
+            if(p == MAP_FAILED){
+                fprintf(stderr, "MAP_HUGETLB %s failed (%s); reserve pages via /sys/kernel/mm/hugepages/hugepages-%zukB/nr_hugepages\n",
+                    backingNames[backing], strerror(errno), page >> 10) ;
+            }
+            break ;
+        }
+        case BACKING_POPULATE:
+            p = mmap(NULL, size, PROT_READ | PROT_WRITE, flags | MAP_POPULATE, -1, 0) ;
+            if(p != MAP_FAILED) madvise(p, size, MADV_NOHUGEPAGE) ;
+            break ;
+        default:
+            break ;
+    }
+    return p == MAP_FAILED ? NULL : p ;
+#else
+    // Only posix_memalign exists off Linux; --pages is rejected in main
+    return alignedAllocPages(64, size) ;
+#endif
+}
+
+void freeBuffer(void *ptr, size_t size){
+    if(!ptr) return ;
+    if(backing == BACKING_MALLOC){ free(ptr) ; return ; }
+#ifdef __linux__
+    size_t len = size ;
+    if(backing == BACKING_THP || backing == BACKING_HUGE2M) len = roundUp(size, HUGE_2M) ;
+    if(backing == BACKING_HUGE1G) len = roundUp(size, HUGE_1G) ;
+    munmap(ptr, len) ;
+#else
+    (void)size ;
+    free(ptr) ;
+#endif
+}
+
+// Bytes of the mapping holding ptr that are really backed by huge pages
+// (AnonHugePages for THP, *_Hugetlb for MAP_HUGETLB), from /proc/self/smaps.
+// Call after the buffer has been written; 0 where smaps is unavailable.
+size_t hugeBackedBytes(const void *ptr){
+    size_t total = 0 ;
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/smaps", "r") ;
+    if(!f) return 0 ;
+    char line[512] ;
+    int inside = 0 ;
+    uintptr_t addr = (uintptr_t)ptr ;
+    while(fgets(line, sizeof(line), f)){
+        unsigned long lo, hi ;
+        char c ;
+        if(sscanf(line, "%lx-%lx %c", &lo, &hi, &c) == 3){
+            inside = addr >= lo && addr < hi ;
+            continue ;
+        }
+        if(!inside) continue ;
+        size_t kb = 0 ;
+        if(sscanf(line, "AnonHugePages: %zu kB", &kb) == 1 ||
+           sscanf(line, "Private_Hugetlb: %zu kB", &kb) == 1 ||
+           sscanf(line, "Shared_Hugetlb: %zu kB", &kb) == 1){
+            total += kb * 1024 ;
+        }
+    }
+    fclose(f) ;
+#else
+    (void)ptr ;
+#endif
+    return total ;
+}
+
 // Prevent the compiler from optimizing away results
 volatile uint64_t blackhole __attribute__((visibility("default"))) ;
 
+// Hardware counters around every timed repeat (--counters). Disabled, they
+// add nothing to the output; enabled but unavailable, their columns are empty.
+perf_counters_t counters ;
+char countersCsv[256] ;
+
+// Per-repeat samples in the shared result schema (--results). Zeroed, the
+// calls below write nothing.
+bench_results_t results ;
+
+static void resultBegin(const char *benchmark, const char *unit, int lowerIsBetter){
+    benchResultBegin(&results, benchmark, unit, lowerIsBetter) ;
+    benchResultParam(&results, "pages", backingNames[backing]) ;
+}
+
 // -----------------Pointer-Chase-Latency------------------------------
-// Make list to chase down
-size_t makeChaseList(size_t N, size_t strideBytes, uint64_t **out_arr){
+// Chase orders. STRIDE is the old fixed-stride ring, which the prefetcher
+// learns. LINE links one node per stride (a cache line by default) into a
+// single random cycle, defeating both prefetch and TLB locality. PAGE
+// visits pages in a random cycle but walks each page's nodes in order, so
+// the difference to LINE is the cost of leaving the page every access.
+typedef enum { CHASE_STRIDE, CHASE_LINE, CHASE_PAGE } chase_order_t ;
+
+const char *chaseOrderName(chase_order_t order){
+    switch(order){
+        case CHASE_STRIDE: return "stride" ;
+        case CHASE_LINE: return "line" ;
+        case CHASE_PAGE: return "page" ;
+    }
+    return "?" ;
+}
+
+// xorshift64*: fixed seed so every run chases the same permutation
+static inline uint64_t chaseRandom(uint64_t *state){
+    uint64_t x = *state ;
+    x ^= x >> 12 ; x ^= x << 25 ; x ^= x >> 27 ;
+    *state = x ;
+    return x * 0x2545F4914F6CDD1Dull ;
+}
+
+// Sattolo's algorithm: perm[] becomes one cycle through all n entries, so
+// following next = perm[i] from anywhere visits every node exactly once
+void sattoloCycle(size_t *perm, size_t n, uint64_t seed){
+    uint64_t state = seed ;
+    for(size_t i = 0; i < n; i++) perm[i] = i ;
+    for(size_t i = n - 1; i > 0; i--){
+        size_t j = (size_t)(chaseRandom(&state) % i) ;
+        size_t t = perm[i] ; perm[i] = perm[j] ; perm[j] = t ;
+    }
+}
+
+// Link the N bytes at arr into a chase list; -1 if scratch allocation fails
+int buildChaseList(uint64_t *arr, size_t N, size_t strideBytes, chase_order_t order){
     size_t elements = N / sizeof(uint64_t) ;
-    uint64_t *arr = alignedAllocPages(64, N) ;
-    if(!arr) return 0 ;
-    
     size_t strideElems = (strideBytes + sizeof(uint64_t) - 1)/sizeof(uint64_t) ;
     if(strideElems == 0) strideElems = 1 ;
     
-    for(size_t i = 0; i < elements; i++){
-        size_t next = (i + strideElems)%elements ;
-        arr[i] = (uint64_t)next ;
+    if(order == CHASE_STRIDE){
+        for(size_t i = 0; i < elements; i++){
+            size_t next = (i + strideElems)%elements ;
+            arr[i] = (uint64_t)next ;
+        }
+        return 0 ;
     }
-    
+
+    // Nodes sit strideElems apart; slots in between are never visited
+    memset(arr, 0, elements * sizeof(uint64_t)) ;
+    size_t nodes = elements / strideElems ;
+    if(nodes < 2){
+        arr[0] = 0 ;
+        return 0 ;
+    }
+    size_t *perm = malloc(nodes * sizeof(size_t)) ;
+    if(!perm) return -1 ;
+
+    if(order == CHASE_LINE){
+        sattoloCycle(perm, nodes, 0x9E3779B97F4A7C15ull) ;
+        for(size_t i = 0; i < nodes; i++) arr[i * strideElems] = (uint64_t)(perm[i] * strideElems) ;
+    }else{
+        size_t pageNodes = (size_t)sysconf(_SC_PAGESIZE) / (strideElems * sizeof(uint64_t)) ;
+        if(pageNodes < 1) pageNodes = 1 ;
+        size_t pages = (nodes + pageNodes - 1) / pageNodes ;
+        if(pages < 2){
+            for(size_t i = 0; i < nodes; i++) arr[i * strideElems] = (uint64_t)(((i + 1) % nodes) * strideElems) ;
+        }else{
+            sattoloCycle(perm, pages, 0x9E3779B97F4A7C15ull) ;
+            // Walk the page cycle from page 0, linking each node to the next
+            size_t page = 0 ;
+            size_t prev = SIZE_MAX ;
+            for(size_t p = 0; p < pages; p++, page = perm[page]){
+                size_t first = page * pageNodes ;
+                size_t last = first + pageNodes < nodes ? first + pageNodes : nodes ;
+                for(size_t node = first; node < last; node++){
+                    if(prev != SIZE_MAX) arr[prev * strideElems] = (uint64_t)(node * strideElems) ;
+                    prev = node ;
+                }
+            }
+            arr[prev * strideElems] = 0 ;
+        }
+    }
+    free(perm) ;
+    return 0 ;
+}
+
+// Make list to chase down
+size_t makeChaseList(size_t N, size_t strideBytes, chase_order_t order, uint64_t **out_arr){
+    uint64_t *arr = allocBuffer(N) ;
+    if(!arr) return 0 ;
+    if(buildChaseList(arr, N, strideBytes, order) != 0){ freeBuffer(arr, N) ; return 0 ; }
     *out_arr = arr ;
-    return elements ;
+    return N / sizeof(uint64_t) ;
 }
 
 
-// iter jump chases
-uint64_t chaseOnce(uint64_t *arr, size_t elements, uint64_t iters){
-    uint64_t idx = 0 ;
+// iter jump chases from start; returns where it stopped so the next repeat
+// continues onto lines the previous one has not pulled into cache
+uint64_t chaseOnce(uint64_t *arr, uint64_t start, uint64_t iters){
+    uint64_t idx = start ;
     for(uint64_t i = 0; i < iters; ++i){
         idx = arr[idx] ;
     }
     return idx ;
 }
 
-void benchmarkPointerChase(size_t sizeBytes, size_t stride, uint64_t iters, int repeats){
+void benchmarkPointerChase(size_t sizeBytes, size_t stride, chase_order_t order, uint64_t iters, int repeats){
     uint64_t *arr = NULL ;
-    size_t elements = makeChaseList(sizeBytes, stride, &arr) ;
+    size_t elements = makeChaseList(sizeBytes, stride, order, &arr) ;
     if(!arr){
         fprintf(stderr, "alloc failed for pointer chase\n") ;
         return ;
@@ -78,32 +297,147 @@ void benchmarkPointerChase(size_t sizeBytes, size_t stride, uint64_t iters, int
     madvise(arr, elements * sizeof(uint64_t), MADV_WILLNEED) ;
     
     // Warmup
-    for(int w = 0; w < DEFAULT_WARMUP; ++w) chaseOnce(arr, elements, iters/10) ;
+    uint64_t idx = 0 ;
+    for(int w = 0; w < DEFAULT_WARMUP; ++w) idx = chaseOnce(arr, idx, iters/10) ;
     
-    printf("#pointer_chase,sizeBytes=%zu,stride=%zu,iters=%" PRIu64 "\n", sizeBytes, stride, iters) ;
+    printf("#pointer_chase,sizeBytes=%zu,stride=%zu,order=%s,iters=%" PRIu64 "\n", sizeBytes, stride, chaseOrderName(order), iters) ;
+    resultBegin("memory.pointer_chase", "ns_per_access", 1) ;
+    benchResultParamNum(&results, "size", (double)sizeBytes) ;
+    benchResultParamNum(&results, "stride", (double)stride) ;
+    benchResultParam(&results, "order", chaseOrderName(order)) ;
+    benchResultParamNum(&results, "iters", (double)iters) ;
     
     for(int r = 0; r < repeats; ++r){
+        perfCountersStart(&counters) ;
         uint64_t t0 = now_ns() ;
-        uint64_t idx = chaseOnce(arr, elements, iters) ;
+        idx = chaseOnce(arr, idx, iters) ;
         uint64_t t1 = now_ns() ;
+        perfCountersStop(&counters) ;
         uint64_t dt = t1 - t0 ;
         double nsPerAccess = (double)dt / (double)iters ;
         blackhole = idx ;
-        printf("pc_repeat,%d,%zu,%zu,%" PRIu64 ",%f\n", r, sizeBytes, stride, dt, nsPerAccess) ;
+        benchResultSample(&results, nsPerAccess) ;
+        printf("pc_repeat,%d,%zu,%zu,%" PRIu64 ",%f%s\n", r, sizeBytes, stride, dt, nsPerAccess,
+            perfCountersCsv(&counters, 1.0, 0, countersCsv, sizeof(countersCsv))) ;
         fflush(stdout) ;
     }
-    free(arr) ;
+    benchResultEnd(&results) ;
+    freeBuffer(arr, sizeBytes) ;
+}
+
+// ---------------Memory-Level Parallelism-----------------
+#define MAX_CHAINS 32
+
+// K independent chases interleaved; K is a constant at each call site so
+// the cursors stay in registers as far as the ISA allows. Cursors are
+// advanced in place, like chaseOnce's return value.
+static inline __attribute__((always_inline)) uint64_t chaseMultiK(const uint64_t *arr, uint64_t *cursors, int K, uint64_t iters){
+    uint64_t idx[MAX_CHAINS] ;
+    for(int k = 0; k < K; k++) idx[k] = cursors[k] ;
+    for(uint64_t i = 0; i < iters; ++i){
+        for(int k = 0; k < K; k++) idx[k] = arr[idx[k]] ;
+    }
+    uint64_t sum = 0 ;
+    for(int k = 0; k < K; k++){
+        cursors[k] = idx[k] ;
+        sum += idx[k] ;
+    }
+    return sum ;
+}
+
+#define CHASE_CASE(k) case k: return chaseMultiK(arr, cursors, k, iters) ;
+uint64_t chaseMulti(const uint64_t *arr, uint64_t *cursors, int K, uint64_t iters){
+    switch(K){
+        CHASE_CASE(1) CHASE_CASE(2) CHASE_CASE(3) CHASE_CASE(4) CHASE_CASE(5) CHASE_CASE(6) CHASE_CASE(7) CHASE_CASE(8)
+        CHASE_CASE(9) CHASE_CASE(10) CHASE_CASE(11) CHASE_CASE(12) CHASE_CASE(13) CHASE_CASE(14) CHASE_CASE(15) CHASE_CASE(16)
+        CHASE_CASE(17) CHASE_CASE(18) CHASE_CASE(19) CHASE_CASE(20) CHASE_CASE(21) CHASE_CASE(22) CHASE_CASE(23) CHASE_CASE(24)
+        CHASE_CASE(25) CHASE_CASE(26) CHASE_CASE(27) CHASE_CASE(28) CHASE_CASE(29) CHASE_CASE(30) CHASE_CASE(31) CHASE_CASE(32)
+    }
+    return 0 ;
+}
+#undef CHASE_CASE
+
+// K = 1..maxChains cursors spread evenly around one random cycle, so each
+// chain owns a disjoint arc and no two ever hit the same line. Little's law
+// turns the step time into outstanding misses: mlp = K * latency(1) / step.
+void benchmarkMLP(size_t sizeBytes, size_t stride, chase_order_t order, uint64_t iters, int repeats, int maxChains){
+    if(order == CHASE_STRIDE) order = CHASE_LINE ;
+    if(maxChains < 1) maxChains = 1 ;
+    if(maxChains > MAX_CHAINS) maxChains = MAX_CHAINS ;
+    uint64_t *arr = NULL ;
+    size_t elements = makeChaseList(sizeBytes, stride, order, &arr) ;
+    if(!arr){
+        fprintf(stderr, "alloc failed for mlp chase\n") ;
+        return ;
+    }
+    madvise(arr, elements * sizeof(uint64_t), MADV_WILLNEED) ;
+
+    // Cycle length, found by walking it once (also warms the TLB)
+    uint64_t nodes = 0 ;
+    uint64_t idx = 0 ;
+    do{ idx = arr[idx] ; nodes++ ; }while(idx != 0) ;
+
+    printf("#mlp,sizeBytes=%zu,stride=%zu,order=%s,iters=%" PRIu64 ",nodes=%" PRIu64 "\n", sizeBytes, stride, chaseOrderName(order), iters, nodes) ;
+    double latency1 = 0.0 ;
+    uint64_t cursors[MAX_CHAINS] ;
+    for(int K = 1; K <= maxChains; K++){
+        // Start k at position k * nodes / K along the cycle
+        uint64_t pos = 0 ;
+        idx = 0 ;
+        for(int k = 0; k < K; k++){
+            uint64_t target = (uint64_t)k * nodes / (uint64_t)K ;
+            for(; pos < target; pos++) idx = arr[idx] ;
+            cursors[k] = idx ;
+        }
+        uint64_t steps = iters / (uint64_t)K ;
+        if(steps < 1) steps = 1 ;
+        blackhole = chaseMulti(arr, cursors, K, steps / 10 + 1) ;
+
+        double best = 0.0 ;
+        resultBegin("memory.mlp", "ns_per_access", 1) ;
+        benchResultParamNum(&results, "size", (double)sizeBytes) ;
+        benchResultParamNum(&results, "stride", (double)stride) ;
+        benchResultParam(&results, "order", chaseOrderName(order)) ;
+        benchResultParamNum(&results, "chains", K) ;
+        for(int r = 0; r < repeats; ++r){
+            perfCountersStart(&counters) ;
+            uint64_t t0 = now_ns() ;
+            uint64_t sum = chaseMulti(arr, cursors, K, steps) ;
+            uint64_t t1 = now_ns() ;
+            perfCountersStop(&counters) ;
+            uint64_t dt = t1 - t0 ;
+            double nsPerStep = (double)dt / (double)steps ;
+            double nsPerAccess = nsPerStep / (double)K ;
+            if(r == 0 || nsPerStep < best) best = nsPerStep ;
+            if(K == 1 && (r == 0 || nsPerStep < latency1)) latency1 = nsPerStep ;
+            blackhole = sum ;
+            benchResultSample(&results, nsPerAccess) ;
+            printf("mlp_repeat,%d,%zu,%d,%" PRIu64 ",%f,%f%s\n", r, sizeBytes, K, dt, nsPerAccess, nsPerStep,
+                perfCountersCsv(&counters, 1.0, 0, countersCsv, sizeof(countersCsv))) ;
+            fflush(stdout) ;
+        }
+        benchResultEnd(&results) ;
+        printf("mlp_result,chains=%d,ns_per_access=%f,outstanding=%f\n", K, best / (double)K, (double)K * latency1 / best) ;
+    }
+    freeBuffer(arr, sizeBytes) ;
 }
 
 // ---------------Streaming Bandwidth-----------------
+// Bytes one stream access moves at a read/write mix: a pure read or a pure
+// write touches one double, a blend B[i]=alpha*A[i]+(1-alpha)*B[i] counts
+// three streams (read A, read B, write B) as STREAM does
+double streamBytesPerOp(double mix) {
+    return (mix >= 0.999 || mix <= 0.001) ? (double)sizeof(double) : 3.0 * sizeof(double);
+}
+
 void benchmarkStream(size_t sizeBytes, size_t strideBytes, double readWriteMix, uint64_t iters, int repeats){
     size_t elemSize = sizeof(double) ;
     size_t elements = sizeBytes/ elemSize ;
     if(elements < 1) elements = 1 ;
 
-    double *A = alignedAllocPages(64, elements * elemSize) ;
-    double *B = alignedAllocPages(64, elements * elemSize) ;
-    if(!A || !B) {fprintf(stderr, "alloc failed\n"); return ;}
+    double *A = allocBuffer(elements * elemSize) ;
+    double *B = allocBuffer(elements * elemSize) ;
+    if(!A || !B) {fprintf(stderr, "alloc failed\n"); freeBuffer(A, elements * elemSize); freeBuffer(B, elements * elemSize); return ;}
 
     for(size_t i = 0; i < elements; i++){A[i] = (double)(i & 0xffff) * 1.234; B[i] = (double)i * 3.21 ;}
 
@@ -120,41 +454,117 @@ void benchmarkStream(size_t sizeBytes, size_t strideBytes, double readWriteMix,
     }
 
     printf("#stream,size=%zu,stride=%zu,readRatio=%f,iterations=%" PRIu64 "\n", sizeBytes, strideBytes, readWriteMix, iters) ;
+    resultBegin("memory.stream", "GiB_per_s", 0) ;
+    benchResultParamNum(&results, "size", (double)sizeBytes) ;
+    benchResultParamNum(&results, "stride", (double)strideBytes) ;
+    benchResultParamNum(&results, "mix", readWriteMix) ;
     for(int r = 0; r < repeats; ++r){
+        perfCountersStart(&counters) ;
         uint64_t t0 = now_ns() ;
         volatile double acc = 0.0 ;
-        for(uint64_t it = 0; it < iters; ++it){
-            for(size_t i = 0; i < elements; i += strideElems){
-                if(readWriteMix >= 0.999){
-                    acc += A[i] ;
-                }else if(readWriteMix <= 0.001){
-                    B[i] = (double)it ;
-                }else{
-                    double alpha = readWriteMix ;
-                    B[i] = alpha * A[i] + (1.0 - alpha) * B[i] ;
-                }
+        // one loop per mix so the hot loop carries no branch
+        if(readWriteMix >= 0.999){
+            double sum = 0.0 ;
+            for(uint64_t it = 0; it < iters; ++it){
+                for(size_t i = 0; i < elements; i += strideElems) sum += A[i] ;
+            }
+            acc = sum ;
+        }else if(readWriteMix <= 0.001){
+            for(uint64_t it = 0; it < iters; ++it){
+                for(size_t i = 0; i < elements; i += strideElems) B[i] = (double)it ;
+            }
+        }else{
+            double alpha = readWriteMix ;
+            for(uint64_t it = 0; it < iters; ++it){
+                for(size_t i = 0; i < elements; i += strideElems) B[i] = alpha * A[i] + (1.0 - alpha) * B[i] ;
             }
         }
         uint64_t t1 = now_ns() ;
+        perfCountersStop(&counters) ;
         uint64_t dt = t1 - t0 ;
 
-        double bytesPerIter = 0.0 ;
-        if(readWriteMix >= 0.999){
-            bytesPerIter = (double)elements/strideElems * (double)elemSize ;
-        }else if(readWriteMix <= 0.001){
-            bytesPerIter = (double)elements/strideElems * (double)elemSize ;
-        }else{
-            bytesPerIter = (double)elements/strideElems * (double)elemSize * 2.0 ;
-        }
+        double bytesPerIter = (double)elements/strideElems * streamBytesPerOp(readWriteMix) ;
         double totalBytes = bytesPerIter * (double)iters ;
         double giB = totalBytes / (1024.0 * 1024.0 * 1024.0) ;
         double seconds = (double)dt / 1e9 ;
         double gibPerS = giB/seconds ;
         blackhole = (uint64_t) acc ;
-        printf("stream_repeat,%d,%zu,%zu,%" PRIu64 ",%" PRIu64 ",%f\n", r, sizeBytes, strideBytes, dt, (uint64_t)totalBytes, gibPerS) ;
+        benchResultSample(&results, gibPerS) ;
+        printf("stream_repeat,%d,%zu,%zu,%" PRIu64 ",%" PRIu64 ",%f%s\n", r, sizeBytes, strideBytes, dt, (uint64_t)totalBytes, gibPerS,
+            perfCountersCsv(&counters, 1.0, 0, countersCsv, sizeof(countersCsv))) ;
         fflush(stdout) ;
     }
-    free(A) ; free(B) ;
+    benchResultEnd(&results) ;
+    freeBuffer(A, elements * elemSize) ; freeBuffer(B, elements * elemSize) ;
+}
+
+// ---------------Stream kernel family-----------------
+// Every kernel of StreamKernels.h over three arrays of sizeBytes each, for
+// every instruction set the host runs, with regular and (where offered)
+// non-temporal stores. bytes counts what the kernel itself reads and writes,
+// as STREAM does. traffic adds the write-allocate read of every regularly
+// stored line, which non-temporal stores avoid; libc and rep count as
+// regular even though they may switch to streaming stores for large sizes.
+void benchmarkStreamKernels(size_t sizeBytes, uint64_t iters, int repeats, size_t prefetchBytes){
+    size_t elemSize = sizeof(double) ;
+    size_t elements = sizeBytes / elemSize ;
+    if(elements < 1) elements = 1 ;
+    size_t pf = prefetchBytes / elemSize ;
+
+    double *a = allocBuffer(elements * elemSize) ;
+    double *b = allocBuffer(elements * elemSize) ;
+    double *c = allocBuffer(elements * elemSize) ;
+    if(!a || !b || !c){fprintf(stderr, "alloc failed\n"); freeBuffer(a, elements * elemSize); freeBuffer(b, elements * elemSize); freeBuffer(c, elements * elemSize); return ;}
+    for(size_t i = 0; i < elements; i++){a[i] = 1.0; b[i] = 2.0; c[i] = 0.0;}
+
+    stream_isa_t isas[8] ;
+    int nisas = streamIsas(isas) ;
+    const double q = 3.0 ;
+
+    printf("#stream_kernels,size=%zu,arrays=3,iterations=%" PRIu64 ",prefetch=%zu\n", sizeBytes, iters, prefetchBytes) ;
+    for(int k = 0; k < STREAM_KERNEL_COUNT; k++){
+        for(int s = 0; s < nisas; s++){
+            stream_kernel_fn fn = isas[s].fn[k] ;
+            if(!fn) continue ;
+            // sum has no stores, so no non-temporal variant
+            int stores = isas[s].nt && streamKernelWrites[k] ? 2 : 1 ;
+            for(int nt = 0; nt < stores; nt++){
+                size_t usePf = isas[s].prefetch && streamKernelReads[k] ? pf : 0 ;
+                for(int w = 0; w < DEFAULT_WARMUP; ++w) blackhole += (uint64_t)fn(a, b, c, elements, q, usePf, nt) ;
+
+                double best = 0.0, total = 0.0 ;
+                resultBegin("memory.stream_kernel", "GiB_per_s", 0) ;
+                benchResultParam(&results, "kernel", streamKernelNames[k]) ;
+                benchResultParam(&results, "isa", isas[s].name) ;
+                benchResultParam(&results, "store", nt ? "nt" : "regular") ;
+                benchResultParamNum(&results, "prefetch", (double)(usePf * elemSize)) ;
+                benchResultParamNum(&results, "size", (double)sizeBytes) ;
+                for(int r = 0; r < repeats; r++){
+                    double acc = 0.0 ;
+                    perfCountersStart(&counters) ;
+                    uint64_t t0 = now_ns() ;
+                    for(uint64_t it = 0; it < iters; ++it) acc += fn(a, b, c, elements, q, usePf, nt) ;
+                    uint64_t t1 = now_ns() ;
+                    perfCountersStop(&counters) ;
+                    blackhole += (uint64_t)acc ;
+                    double gibPerS = (double)(streamKernelReads[k] + streamKernelWrites[k]) * (double)elements * elemSize * (double)iters
+                        / (1024.0 * 1024.0 * 1024.0) / ((double)(t1 - t0) / 1e9) ;
+                    if(gibPerS > best) best = gibPerS ;
+                    total += gibPerS ;
+                    benchResultSample(&results, gibPerS) ;
+                }
+                benchResultEnd(&results) ;
+                int streams = streamKernelReads[k] + streamKernelWrites[k] ;
+                int trafficStreams = streams + (nt ? 0 : streamKernelWrites[k]) ;
+                printf("kernel_result,kernel=%s,isa=%s,store=%s,prefetch=%zu,bytes_per_elem=%d,traffic_per_elem=%d,best_gib_s=%f,avg_gib_s=%f,traffic_gib_s=%f%s\n",
+                    streamKernelNames[k], isas[s].name, nt ? "nt" : "regular", usePf * elemSize, streams * (int)elemSize, trafficStreams * (int)elemSize,
+                    best, total / (double)repeats, best * (double)trafficStreams / (double)streams,
+                    perfCountersCsv(&counters, (double)elements * (double)iters, 1, countersCsv, sizeof(countersCsv))) ;
+                fflush(stdout) ;
+            }
+        }
+    }
+    freeBuffer(a, elements * elemSize) ; freeBuffer(b, elements * elemSize) ; freeBuffer(c, elements * elemSize) ;
 }
 
 // ------------------SAXPY Kernel---------------------------
@@ -163,9 +573,9 @@ void benchmarkSAXPY(size_t sizeBytes, uint64_t iterations, int repeats){
     size_t elements = sizeBytes / elemSize ;
     if(elements < 1) elements = 1 ;
 
-    double *x = alignedAllocPages(64, elements * elemSize) ;
-    double *y = alignedAllocPages(64, elements * elemSize) ;
-    if(!x || !y){fprintf(stderr, "alloc failed\n"); return ;}
+    double *x = allocBuffer(elements * elemSize) ;
+    double *y = allocBuffer(elements * elemSize) ;
+    if(!x || !y){fprintf(stderr, "alloc failed\n"); freeBuffer(x, elements * elemSize); freeBuffer(y, elements * elemSize); return ;}
 
     for(size_t i = 0; i < elements; i++){x[i] = (double)(i+1) * 0.00123; y[i] = (double)(i+2)*0.0007;}
     madvise(x, elements * elemSize, MADV_WILLNEED) ;
@@ -178,7 +588,10 @@ void benchmarkSAXPY(size_t sizeBytes, uint64_t iterations, int repeats){
     }
 
     printf("#saxpy,size=%zu,iterations=%" PRIu64 "\n", sizeBytes, iterations) ;
+    resultBegin("memory.saxpy", "GFLOP_per_s", 0) ;
+    benchResultParamNum(&results, "size", (double)sizeBytes) ;
     for(int r = 0; r < repeats; r++){
+        perfCountersStart(&counters) ;
         uint64_t t0 = now_ns() ;
         volatile double acc = 0.0 ;
         for (uint64_t it = 0; it < iterations; ++it){
@@ -187,6 +600,7 @@ void benchmarkSAXPY(size_t sizeBytes, uint64_t iterations, int repeats){
             }
         }
         uint64_t t1 = now_ns() ;
+        perfCountersStop(&counters) ;
         uint64_t dt = t1 - t0 ;
         double flops = (double)elements * (double)iterations * 2.0 ;
         double gflop = flops / 1e9 ;
@@ -195,10 +609,83 @@ void benchmarkSAXPY(size_t sizeBytes, uint64_t iterations, int repeats){
 
         double cpe = ((double)dt/1e9) * sysconf(_SC_CLK_TCK) / (double)(elements * iterations) ;
         blackhole = (uint64_t) acc ;
-        printf("saxpy_repeat, %d,%zu,%" PRIu64 ",%" PRIu64 ",%f\n", r, sizeBytes, dt, (uint64_t)flops, gflopS) ;
+        benchResultSample(&results, gflopS) ;
+        printf("saxpy_repeat, %d,%zu,%" PRIu64 ",%" PRIu64 ",%f%s\n", r, sizeBytes, dt, (uint64_t)flops, gflopS,
+            perfCountersCsv(&counters, 1.0, 0, countersCsv, sizeof(countersCsv))) ;
         fflush(stdout) ;
     }
-    free(x) ; free(y) ;
+    benchResultEnd(&results) ;
+    freeBuffer(x, elements * elemSize) ; freeBuffer(y, elements * elemSize) ;
+}
+
+// ---------------------- Page-size sweep ----------------------
+// For every backing store and size 1 MiB..maxSize: random line-granular
+// chase latency and sequential read bandwidth over the same buffer, each
+// with dTLB misses from the counters (opened automatically for this mode).
+// huge_bytes shows how much of the buffer huge pages actually back.
+void benchmarkPages(size_t maxSize, uint64_t jumps, int repeats){
+    backing_t saved = backing ;
+    printf("#pages,maxSize=%zu,jumps=%" PRIu64 ",repeats=%d\n", maxSize, jumps, repeats) ;
+    for(int b = 0; b < BACKING_COUNT; b++){
+        backing = (backing_t)b ;
+        for(size_t size = 1u << 20; size <= maxSize; size *= 2){
+            uint64_t *arr = NULL ;
+            size_t elements = makeChaseList(size, 64, CHASE_LINE, &arr) ;
+            if(!arr){
+                printf("pages_result,backing=%s,size=%zu,error=alloc_failed\n", backingNames[b], size) ;
+                break ;
+            }
+            size_t huge = hugeBackedBytes(arr) ;
+
+            // Latency: best repeat, with that repeat's dTLB misses per access
+            uint64_t idx = chaseOnce(arr, 0, jumps / 10) ;
+            double bestLat = 0.0, latTlb = -1.0 ;
+            for(int r = 0; r < repeats; r++){
+                perfCountersStart(&counters) ;
+                uint64_t t0 = now_ns() ;
+                idx = chaseOnce(arr, idx, jumps) ;
+                uint64_t t1 = now_ns() ;
+                perfCountersStop(&counters) ;
+                double lat = (double)(t1 - t0) / (double)jumps ;
+                if(r == 0 || lat < bestLat){
+                    bestLat = lat ;
+                    latTlb = counters.valid[PC_DTLB_MISSES] ? counters.value[PC_DTLB_MISSES] / (double)jumps : -1.0 ;
+                }
+            }
+            blackhole = idx ;
+
+            // Bandwidth: sequential sums over at least 1 GiB in total
+            uint64_t passes = (1ull << 30) / size ;
+            if(passes < 1) passes = 1 ;
+            double bestBw = 0.0, bwTlb = -1.0 ;
+            for(int r = 0; r < repeats; r++){
+                uint64_t sum = 0 ;
+                perfCountersStart(&counters) ;
+                uint64_t t0 = now_ns() ;
+                for(uint64_t p = 0; p < passes; p++){
+                    for(size_t i = 0; i < elements; i++) sum += arr[i] ;
+                }
+                uint64_t t1 = now_ns() ;
+                perfCountersStop(&counters) ;
+                blackhole = sum ;
+                double gib = (double)size * (double)passes / (1024.0 * 1024.0 * 1024.0) ;
+                double bw = gib / ((double)(t1 - t0) / 1e9) ;
+                if(bw > bestBw){
+                    bestBw = bw ;
+                    bwTlb = counters.valid[PC_DTLB_MISSES] ? counters.value[PC_DTLB_MISSES] / (gib * 1024.0) : -1.0 ;
+                }
+            }
+
+            char latTlbStr[32] = "", bwTlbStr[32] = "" ;
+            if(latTlb >= 0.0) snprintf(latTlbStr, sizeof(latTlbStr), "%f", latTlb) ;
+            if(bwTlb >= 0.0) snprintf(bwTlbStr, sizeof(bwTlbStr), "%f", bwTlb) ;
+            printf("pages_result,backing=%s,size=%zu,huge_bytes=%zu,lat_ns=%f,dtlb_misses_per_access=%s,gib_s=%f,dtlb_misses_per_mib=%s\n",
+                backingNames[b], size, huge, bestLat, latTlbStr, bestBw, bwTlbStr) ;
+            fflush(stdout) ;
+            freeBuffer(arr, size) ;
+        }
+    }
+    backing = saved ;
 }
 
 // ---------------------- Intensity (multi-thread) ----------------------
@@ -209,25 +696,257 @@ typedef struct {
     double read_write_mix;
     int thread_id;
     volatile int *stop_flag;
+    uint32_t delay;             // spin iterations after every access (load throttle)
+    int cpu;                    // pin to this CPU, -1 to leave unpinned
+    int node;                   // bind private buffers to this NUMA node, -1 for first touch
+    double *shared_a;           // stream these instead of private buffers when set
+    double *shared_b;
+    volatile int *ready_count;  // incremented once buffers are initialized, may be NULL
+    volatile int *start_flag;   // spin after init until raised, may be NULL
+    volatile uint64_t ops_done; // accesses so far, published while running for readers mid-run
+    double result_bytes;
     double result_throughput_gib;
     double result_latency_ns;
 } thread_arg_t;
 
+// ---------------------- CPU topology and placement ----------------------
+// Threads are pinned by one of three policies over the allowed CPUs:
+// COMPACT fills one package a physical core at a time and only then uses
+// SMT siblings, SCATTER round-robins packages (still one thread per core
+// first), SMT puts consecutive threads on sibling hardware threads of the
+// same core. Buffers go LOCAL (bound to the worker's node), REMOTE (bound
+// to the next node) or SHARED (one pair, first touched by the main thread,
+// streamed by every worker). Topology comes from sysfs; pinning and
+// binding are plain sched_setaffinity/mbind syscalls, no libnuma.
+typedef enum { PIN_COMPACT, PIN_SCATTER, PIN_SMT, PIN_COUNT } pin_policy_t;
+typedef enum { PLACE_LOCAL, PLACE_REMOTE, PLACE_SHARED, PLACE_COUNT } placement_t;
+
+const char *pinPolicyNames[PIN_COUNT] = {"compact", "scatter", "smt"};
+const char *placementNames[PLACE_COUNT] = {"local", "remote", "shared"};
+
+typedef struct {
+    int cpu;
+    int package;
+    int core;
+    int smt;        // rank among the core's hardware threads
+    int rank;       // rank of the core within its package
+    int node;
+} cpu_topo_t;
+
+#define MAX_CPUS 1024
+
+// CPUs this process may run on, in order; returns how many were written
+int allowedCpus(int *cpus, int max) {
+    int n = 0;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c=0; c<CPU_SETSIZE && n<max; c++) if (CPU_ISSET(c, &set)) cpus[n++] = c;
+    }
+#endif
+    if (n == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int c=0; c<online && n<max; c++) cpus[n++] = c;
+    }
+    if (n == 0 && max > 0) cpus[n++] = 0;
+    return n;
+}
+
+// Pin the calling thread; a no-op off Linux (macOS has no hard affinity)
+void pinThread(int cpu) {
+#ifdef __linux__
+    if (cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) fprintf(stderr, "pin to cpu %d failed: %s\n", cpu, strerror(errno));
+#else
+    (void)cpu;
+#endif
+}
+
+// Whether cpu appears in a sysfs cpu list such as "0-3,8-11"
+int cpuListHas(const char *list, int cpu) {
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long lo = strtol(p, &end, 10), hi = lo;
+        if (end == p) break;
+        if (*end == '-') hi = strtol(end + 1, &end, 10);
+        if (cpu >= lo && cpu <= hi) return 1;
+        if (*end != ',') break;
+        p = end + 1;
+    }
+    return 0;
+}
+
+int readSysInt(const char *path, int fallback) {
+    FILE *f = fopen(path, "r");
+    int v = fallback;
+    if (!f) return fallback;
+    if (fscanf(f, "%d", &v) != 1) v = fallback;
+    fclose(f);
+    return v;
+}
+
+// Package/core/SMT rank/node for every allowed CPU. Anything sysfs does not
+// say (or a non-Linux host) reads as one package, one node, no SMT.
+int readTopology(cpu_topo_t *topo, int max) {
+    int cpus[MAX_CPUS];
+    int n = allowedCpus(cpus, max < MAX_CPUS ? max : MAX_CPUS);
+    for (int i=0;i<n;i++) {
+        char path[128], list[256];
+        topo[i].cpu = cpus[i];
+        topo[i].package = 0;
+        topo[i].core = cpus[i];
+        topo[i].smt = 0;
+        topo[i].node = 0;
+#ifdef __linux__
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpus[i]);
+        topo[i].package = readSysInt(path, 0);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpus[i]);
+        topo[i].core = readSysInt(path, cpus[i]);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpus[i]);
+        FILE *f = fopen(path, "r");
+        if (f) {
+            if (fgets(list, sizeof(list), f)) {
+                for (int c=0;c<cpus[i];c++) topo[i].smt += cpuListHas(list, c);
+            }
+            fclose(f);
+        }
+        for (int node=0; node<MAX_CPUS; node++) {
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            f = fopen(path, "r");
+            if (!f) { if (node > 0) break; else continue; }
+            int has = fgets(list, sizeof(list), f) && cpuListHas(list, cpus[i]);
+            fclose(f);
+            if (has) { topo[i].node = node; break; }
+        }
+#else
+        (void)path; (void)list;
+#endif
+    }
+    for (int i=0;i<n;i++) {
+        topo[i].rank = 0;
+        for (int j=0;j<n;j++) {
+            if (topo[j].package == topo[i].package && topo[j].smt == 0 && topo[j].core < topo[i].core) topo[i].rank++;
+        }
+    }
+    return n;
+}
+
+int cmpCompact(const void *a, const void *b) {
+    const cpu_topo_t *x = a, *y = b;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->smt != y->smt) return x->smt - y->smt;
+    if (x->core != y->core) return x->core - y->core;
+    return x->cpu - y->cpu;
+}
+
+// Core rank ahead of package, so consecutive threads alternate packages
+int cmpScatter(const void *a, const void *b) {
+    const cpu_topo_t *x = a, *y = b;
+    if (x->smt != y->smt) return x->smt - y->smt;
+    if (x->rank != y->rank) return x->rank - y->rank;
+    if (x->package != y->package) return x->package - y->package;
+    return x->cpu - y->cpu;
+}
+
+int cmpSmt(const void *a, const void *b) {
+    const cpu_topo_t *x = a, *y = b;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    if (x->smt != y->smt) return x->smt - y->smt;
+    return x->cpu - y->cpu;
+}
+
+// Allowed CPUs in the order a policy hands them to threads 0, 1, 2, ...
+int pinOrder(pin_policy_t policy, cpu_topo_t *topo, int max) {
+    int n = readTopology(topo, max);
+    int (*cmp)(const void *, const void *) = policy == PIN_SCATTER ? cmpScatter : policy == PIN_SMT ? cmpSmt : cmpCompact;
+    qsort(topo, n, sizeof(cpu_topo_t), cmp);
+    return n;
+}
+
+int nodeCount(const cpu_topo_t *topo, int n) {
+    int nodes = 1;
+    for (int i=0;i<n;i++) if (topo[i].node + 1 > nodes) nodes = topo[i].node + 1;
+    return nodes;
+}
+
+// MPOL_BIND the whole pages inside [ptr, ptr+size) to node before they are
+// first touched; MPOL_MF_MOVE also migrates pages that already exist
+// (--pages populate). Returns 0 on success or where NUMA does not apply.
+int bindToNode(void *ptr, size_t size, int node) {
+#ifdef __linux__
+    if (!ptr || node < 0) return 0;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t lo = roundUp((uintptr_t)ptr, page);
+    uintptr_t hi = ((uintptr_t)ptr + size) / page * page;
+    if (hi <= lo) return 0;
+    unsigned long mask[MAX_CPUS / (8 * sizeof(unsigned long))];
+    if (node >= (int)(8 * sizeof(mask))) return -1;
+    memset(mask, 0, sizeof(mask));
+    mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+    if (syscall(SYS_mbind, (void *)lo, hi - lo, MPOL_BIND, mask, 8 * sizeof(mask) + 1, MPOL_MF_MOVE) != 0) {
+        fprintf(stderr, "mbind to node %d failed: %s\n", node, strerror(errno));
+        return -1;
+    }
+#else
+    (void)ptr; (void)size; (void)node;
+#endif
+    return 0;
+}
+
+static inline void spinDelay(uint32_t n) {
+    for (uint32_t d=0; d<n; d++) __asm__ __volatile__("");
+}
+
+void sleepSeconds(double seconds) {
+    struct timespec nap = { (time_t)seconds, (long)((seconds - (double)(time_t)seconds) * 1e9) };
+    while (nanosleep(&nap, &nap) != 0 && errno == EINTR) {}
+}
+
 void *worker_stream_thread(void *argptr) {
     thread_arg_t *arg = (thread_arg_t *)argptr;
+    pinThread(arg->cpu);
     size_t elem_size = sizeof(double);
     size_t elements = arg->size_bytes / elem_size; if (elements<1) elements=1;
-    double *A = alignedAllocPages(64, elements * elem_size);
-    double *B = alignedAllocPages(64, elements * elem_size);
-    if (!A || !B) { fprintf(stderr,"thread alloc fail\n"); return NULL; }
-    for (size_t i=0;i<elements;i++){ A[i]=i*1.0; B[i]=i*2.0; }
+    double *A = arg->shared_a;
+    double *B = arg->shared_b;
+    int own = !A;
+    if (own) {
+        // allocated and first touched here, after pinning, so pages land on
+        // this thread's node unless node binds them elsewhere
+        A = allocBuffer(elements * elem_size);
+        B = allocBuffer(elements * elem_size);
+        if (!A || !B) { fprintf(stderr,"thread alloc fail\n"); freeBuffer(A, elements * elem_size); freeBuffer(B, elements * elem_size); A = B = NULL; }
+        else {
+            bindToNode(A, elements * elem_size, arg->node);
+            bindToNode(B, elements * elem_size, arg->node);
+            for (size_t i=0;i<elements;i++){ A[i]=i*1.0; B[i]=i*2.0; }
+        }
+    }
     size_t stride_elems = arg->stride / elem_size; if (stride_elems<1) stride_elems = 1;
+    // report ready even on failure so the main thread never waits forever
+    if (arg->ready_count) __sync_fetch_and_add(arg->ready_count, 1);
+    if (!A) return NULL;
+    if (arg->start_flag) while (!*(arg->start_flag)) sched_yield();
 
-    // run for arg->iterations loops (not time-limited here)
+    // run for arg->iterations loops, or until stop_flag is raised; the flag
+    // is polled and ops_done published every 1024 accesses, or every access
+    // when throttled, so slow passes still end and report promptly
     uint64_t t0 = now_ns();
     uint64_t ops = 0;
-    for (uint64_t it=0; it<arg->iterations && !*(arg->stop_flag); ++it) {
+    uint64_t poll = arg->delay ? 0 : 1023;
+    int stopped = 0;
+    for (uint64_t it=0; it<arg->iterations && !stopped; ++it) {
         for (size_t i=0;i<elements;i+=stride_elems) {
+            if ((ops & poll) == 0) {
+                __atomic_store_n(&arg->ops_done, ops, __ATOMIC_RELAXED);
+                if (*(arg->stop_flag)) { stopped = 1; break; }
+            }
             if (arg->read_write_mix >= 0.999) {
                 volatile double v = A[i];
                 blackhole = (uint64_t)v;
@@ -238,50 +957,1018 @@ void *worker_stream_thread(void *argptr) {
                 B[i] = alpha * A[i] + (1.0-alpha) * B[i];
             }
             ops++;
+            spinDelay(arg->delay);
         }
     }
     uint64_t t1 = now_ns();
+    __atomic_store_n(&arg->ops_done, ops, __ATOMIC_RELAXED);
     double seconds = (double)(t1 - t0) / 1e9;
-    double bytes_per_op = (arg->read_write_mix >= 0.999 || arg->read_write_mix <= 0.001) ? (double)elem_size : (double)elem_size*2.0;
-    double total_bytes = bytes_per_op * (double)ops;
-    arg->result_throughput_gib = (total_bytes / (1024.0*1024.0*1024.0)) / seconds;
-    arg->result_latency_ns = (double)(t1 - t0) / (double)ops;
-    free(A); free(B);
+    double bytes_per_op = streamBytesPerOp(arg->read_write_mix);
+    arg->result_bytes = bytes_per_op * (double)ops;
+    arg->result_throughput_gib = seconds > 0.0 ? (arg->result_bytes / (1024.0*1024.0*1024.0)) / seconds : 0.0;
+    arg->result_latency_ns = ops ? (double)(t1 - t0) / (double)ops : 0.0;
+    if (own) { freeBuffer(A, elements * elem_size); freeBuffer(B, elements * elem_size); }
     return NULL;
 }
 
-void benchmark_intensity(size_t size_bytes, size_t stride, double mix, uint64_t iterations_per_thread, int max_threads) {
-    printf("#intensity,size=%zu,stride=%zu,mix=%f,iter_per_thread=%" PRIu64 "\n", size_bytes, stride, mix, iterations_per_thread);
-    for (int threads = 1; threads <= max_threads; threads *= 2) {
-        pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+void initThreadArg(thread_arg_t *arg, size_t size_bytes, size_t stride, double mix, int thread_id, volatile int *stop, volatile int *ready) {
+    memset(arg, 0, sizeof(*arg));
+    arg->size_bytes = size_bytes;
+    arg->stride = stride;
+    arg->iterations = UINT64_MAX;
+    arg->read_write_mix = mix;
+    arg->thread_id = thread_id;
+    arg->stop_flag = stop;
+    arg->ready_count = ready;
+    arg->cpu = -1;
+    arg->node = -1;
+}
+
+// Start one worker per arg, release them together once all are ready, let
+// them stream for duration and stop them; returns the common window in
+// seconds. Counters are inherited by the workers and folded in at join.
+double runStreamThreads(thread_arg_t *targs, int threads, double duration) {
+    pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+    volatile int stop = 0;
+    volatile int ready = 0;
+    volatile int start = 0;
+    for (int i=0;i<threads;i++) {
+        targs[i].stop_flag = &stop;
+        targs[i].ready_count = &ready;
+        targs[i].start_flag = &start;
+        pthread_create(&tids[i], NULL, worker_stream_thread, &targs[i]);
+    }
+    while (ready < threads) sched_yield();
+
+    perfCountersStart(&counters);
+    uint64_t t0 = now_ns();
+    start = 1;
+    sleepSeconds(duration);
+    stop = 1;
+    uint64_t t1 = now_ns();
+    for (int i=0;i<threads;i++) pthread_join(tids[i], NULL);
+    perfCountersStop(&counters);
+    free(tids);
+    return (double)(t1 - t0) / 1e9;
+}
+
+// Every thread count 1..max_threads. Workers pin, allocate and initialize
+// their buffers, then wait at a start flag; the main thread releases them
+// all at once, sleeps for the run duration and raises stop. Bandwidth is the
+// bytes every thread moved divided by that one common window, so the threads
+// are measured over the same interval rather than summed over their own.
+void benchmark_intensity(size_t size_bytes, size_t stride, double mix, double duration, int max_threads, pin_policy_t policy, placement_t placement) {
+    cpu_topo_t topo[MAX_CPUS];
+    int ncpus = pinOrder(policy, topo, MAX_CPUS);
+    int nodes = nodeCount(topo, ncpus);
+    printf("#intensity,size=%zu,stride=%zu,mix=%f,duration_s=%f,pin=%s,placement=%s,cpus=%d,nodes=%d\n",
+        size_bytes, stride, mix, duration, pinPolicyNames[policy], placementNames[placement], ncpus, nodes);
+    if (placement == PLACE_REMOTE && nodes < 2) fprintf(stderr, "intensity: one NUMA node, remote placement is local\n");
+    if (max_threads > ncpus) fprintf(stderr, "intensity: %d threads share %d CPUs\n", max_threads, ncpus);
+
+    double *sharedA = NULL, *sharedB = NULL;
+    size_t elements = size_bytes / sizeof(double); if (elements<1) elements=1;
+    if (placement == PLACE_SHARED) {
+        // one pair for everyone, first touched from thread 0's CPU; the
+        // main thread's own affinity is put back once the pages are placed
+#ifdef __linux__
+        cpu_set_t saved;
+        int haveSaved = sched_getaffinity(0, sizeof(saved), &saved) == 0;
+#endif
+        pinThread(topo[0].cpu);
+        sharedA = allocBuffer(elements * sizeof(double));
+        sharedB = allocBuffer(elements * sizeof(double));
+        if (sharedA && sharedB) for (size_t i=0;i<elements;i++){ sharedA[i]=i*1.0; sharedB[i]=i*2.0; }
+#ifdef __linux__
+        if (haveSaved && sched_setaffinity(0, sizeof(saved), &saved) != 0) fprintf(stderr, "intensity: restoring affinity failed: %s\n", strerror(errno));
+#endif
+        if (!sharedA || !sharedB) { fprintf(stderr, "alloc failed for shared buffers\n"); freeBuffer(sharedA, elements * sizeof(double)); freeBuffer(sharedB, elements * sizeof(double)); return; }
+    }
+
+    for (int threads = 1; threads <= max_threads; threads++) {
         thread_arg_t *targs = malloc(sizeof(thread_arg_t) * threads);
-        volatile int stop = 0;
         for (int i=0;i<threads;i++) {
-            targs[i].size_bytes = size_bytes;
-            targs[i].stride = stride;
-            targs[i].iterations = iterations_per_thread;
-            targs[i].read_write_mix = mix;
-            targs[i].thread_id = i;
-            targs[i].stop_flag = &stop;
-            targs[i].result_throughput_gib = 0.0;
-            targs[i].result_latency_ns = 0.0;
-            pthread_create(&tids[i], NULL, worker_stream_thread, &targs[i]);
+            const cpu_topo_t *t = &topo[i % ncpus];
+            initThreadArg(&targs[i], size_bytes, stride, mix, i, NULL, NULL);
+            targs[i].cpu = t->cpu;
+            if (placement == PLACE_LOCAL) targs[i].node = nodes > 1 ? t->node : -1;
+            if (placement == PLACE_REMOTE) targs[i].node = nodes > 1 ? (t->node + 1) % nodes : -1;
+            targs[i].shared_a = sharedA;
+            targs[i].shared_b = sharedB;
         }
-        // let them run until completion
-        for (int i=0;i<threads;i++) pthread_join(tids[i], NULL);
+        double seconds = runStreamThreads(targs, threads, duration);
 
-        // aggregate
-        double sum_gib = 0.0;
-        double avg_lat_ns = 0.0;
+        // aggregate over the common window; per-thread rates show imbalance
+        double bytes = 0.0, avg_lat_ns = 0.0;
+        double min_gib = -1.0, max_gib = 0.0;
         for (int i=0;i<threads;i++) {
-            sum_gib += targs[i].result_throughput_gib;
+            bytes += targs[i].result_bytes;
             avg_lat_ns += targs[i].result_latency_ns;
+            if (min_gib < 0.0 || targs[i].result_throughput_gib < min_gib) min_gib = targs[i].result_throughput_gib;
+            if (targs[i].result_throughput_gib > max_gib) max_gib = targs[i].result_throughput_gib;
         }
         avg_lat_ns /= (double)threads;
-        printf("intensity_result,threads=%d,total_gib_s=%f,avg_lat_ns=%f\n", threads, sum_gib, avg_lat_ns);
+        printf("intensity_result,threads=%d,cpu_last=%d,total_gib_s=%f,min_thread_gib_s=%f,max_thread_gib_s=%f,avg_lat_ns=%f%s\n",
+            threads, topo[(threads - 1) % ncpus].cpu, bytes / (1024.0*1024.0*1024.0) / seconds, min_gib, max_gib, avg_lat_ns,
+            perfCountersCsv(&counters, 1.0, 1, countersCsv, sizeof(countersCsv)));
+        fflush(stdout);
+
+        free(targs);
+    }
+    freeBuffer(sharedA, elements * sizeof(double)); freeBuffer(sharedB, elements * sizeof(double));
+}
+
+// ---------------------- Loaded latency ----------------------
+// Intel MLC-style loaded latency: the main thread, pinned to the first
+// allowed CPU, chases a random cycle while load_threads workers on the next
+// CPUs stream at the given mix. Each worker spins `delay` iterations after
+// every access, so stepping the delay down from large to 0 walks the curve
+// from idle to saturated. One line per delay: bandwidth the workers drew
+// while the chase ran (their access counts read at both ends of the chase,
+// over its duration), and the chase latency under that load. Counters run
+// until the workers are joined, so they cover the chase and the load
+// threads together, per chase jump.
+static const uint32_t loadedDelays[] = {100000, 50000, 20000, 10000, 5000, 2000, 1000, 500, 200, 100, 50, 20, 10, 0};
+
+void benchmarkLoadedLatency(size_t size_bytes, size_t stride, double mix, uint64_t jumps, int load_threads) {
+    int cpus[MAX_CPUS];
+    int ncpus = allowedCpus(cpus, MAX_CPUS);
+    if (load_threads < 0) load_threads = 0;
+    if (load_threads + 1 > ncpus) fprintf(stderr, "loaded latency: %d threads share %d CPUs\n", load_threads + 1, ncpus);
+    pinThread(cpus[0]);
+
+    uint64_t *arr = NULL;
+    makeChaseList(size_bytes, stride, CHASE_LINE, &arr);
+    if (!arr) { fprintf(stderr, "alloc failed for loaded latency\n"); return; }
+    uint64_t idx = chaseOnce(arr, 0, jumps / 10);
+
+    printf("#loaded_latency,size=%zu,stride=%zu,mix=%f,jumps=%" PRIu64 ",load_threads=%d\n", size_bytes, stride, mix, jumps, load_threads);
+    pthread_t *tids = malloc(sizeof(pthread_t) * (load_threads + 1));
+    thread_arg_t *targs = malloc(sizeof(thread_arg_t) * (load_threads + 1));
+    for (size_t d=0; d<sizeof(loadedDelays)/sizeof(loadedDelays[0]); d++) {
+        volatile int stop = 0;
+        volatile int ready = 0;
+        for (int i=0;i<load_threads;i++) {
+            initThreadArg(&targs[i], size_bytes, stride, mix, i, &stop, &ready);
+            targs[i].delay = loadedDelays[d];
+            targs[i].cpu = cpus[(i + 1) % ncpus];
+            pthread_create(&tids[i], NULL, worker_stream_thread, &targs[i]);
+        }
+        // Chase only once every worker is generating traffic
+        while (ready < load_threads) sched_yield();
+
+        uint64_t ops0 = 0, ops1 = 0;
+        perfCountersStart(&counters);
+        for (int i=0;i<load_threads;i++) ops0 += __atomic_load_n(&targs[i].ops_done, __ATOMIC_RELAXED);
+        uint64_t t0 = now_ns();
+        idx = chaseOnce(arr, idx, jumps);
+        uint64_t t1 = now_ns();
+        for (int i=0;i<load_threads;i++) ops1 += __atomic_load_n(&targs[i].ops_done, __ATOMIC_RELAXED);
+        stop = 1;
+        for (int i=0;i<load_threads;i++) pthread_join(tids[i], NULL);
+        perfCountersStop(&counters);
+        blackhole = idx;
 
-        free(tids); free(targs);
+        double sum_gib = t1 > t0 ? streamBytesPerOp(mix) * (double)(ops1 - ops0) / (1024.0*1024.0*1024.0) / ((double)(t1 - t0) / 1e9) : 0.0;
+        printf("loaded_latency,delay=%u,load_threads=%d,total_gib_s=%f,lat_ns=%f%s\n", loadedDelays[d], load_threads, sum_gib,
+            (double)(t1 - t0) / (double)jumps, perfCountersCsv(&counters, (double)jumps, 1, countersCsv, sizeof(countersCsv)));
+        fflush(stdout);
     }
+    free(tids); free(targs);
+    freeBuffer(arr, size_bytes);
+}
+
+// ---------------------- Host profile ----------------------
+// What autodetect measured, as key=value lines in a text file (see
+// writeProfile). Every mode loads it when present so defaults follow the
+// host: --size becomes 4x the last cache level, --stride the line size, and
+// the false-sharing pads one and two lines. Explicit options still win.
+#define PROFILE_DEFAULT_PATH "memory_profile.txt"
+#define PROFILE_MAX_LEVELS 6
+
+typedef struct {
+    int loaded;
+    size_t line_size;
+    int levels;                                     // cache levels, DRAM excluded
+    size_t cache_size[PROFILE_MAX_LEVELS];
+    double latency_ns[PROFILE_MAX_LEVELS + 1];      // [levels] is DRAM
+    int tlb_levels;
+    size_t tlb_entries[PROFILE_MAX_LEVELS];
+    size_t tlb_reach[PROFILE_MAX_LEVELS];
+    double tlb_penalty_ns[PROFILE_MAX_LEVELS];      // extra ns per access past that level
+    size_t page_size;
+} memory_profile_t;
+
+memory_profile_t profile;
+
+int writeProfile(const char *path, const memory_profile_t *p) {
+    FILE *f = fopen(path, "w");
+    if (!f) { fprintf(stderr, "cannot write profile %s: %s\n", path, strerror(errno)); return -1; }
+    fprintf(f, "# memory profile written by Benchmark autodetect; sizes in bytes, latencies in ns\n");
+    fprintf(f, "line_size=%zu\npage_size=%zu\nlevels=%d\n", p->line_size, p->page_size, p->levels);
+    for (int i=0;i<p->levels;i++) fprintf(f, "l%d_size=%zu\nl%d_latency_ns=%.3f\n", i + 1, p->cache_size[i], i + 1, p->latency_ns[i]);
+    fprintf(f, "dram_latency_ns=%.3f\ntlb_levels=%d\n", p->latency_ns[p->levels], p->tlb_levels);
+    for (int i=0;i<p->tlb_levels;i++) {
+        fprintf(f, "tlb%d_entries=%zu\ntlb%d_reach=%zu\ntlb%d_penalty_ns=%.3f\n", i + 1, p->tlb_entries[i], i + 1, p->tlb_reach[i], i + 1, p->tlb_penalty_ns[i]);
+    }
+    fclose(f);
+    return 0;
+}
+
+int loadProfile(const char *path, memory_profile_t *p) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    memset(p, 0, sizeof(*p));
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char key[64];
+        double v;
+        int lvl;
+        if (line[0] == '#' || sscanf(line, "%63[^=]=%lf", key, &v) != 2) continue;
+        if (strcmp(key, "line_size")==0) p->line_size = (size_t)v;
+        else if (strcmp(key, "page_size")==0) p->page_size = (size_t)v;
+        else if (strcmp(key, "levels")==0) p->levels = (int)v;
+        else if (strcmp(key, "dram_latency_ns")==0) p->latency_ns[p->levels < PROFILE_MAX_LEVELS ? p->levels : PROFILE_MAX_LEVELS] = v;
+        else if (strcmp(key, "tlb_levels")==0) p->tlb_levels = (int)v;
+        else if (sscanf(key, "l%d_", &lvl) == 1 && lvl >= 1 && lvl <= PROFILE_MAX_LEVELS) {
+            if (strstr(key, "_size")) p->cache_size[lvl - 1] = (size_t)v;
+            else if (strstr(key, "_latency_ns")) p->latency_ns[lvl - 1] = v;
+        }
+        else if (sscanf(key, "tlb%d_", &lvl) == 1 && lvl >= 1 && lvl <= PROFILE_MAX_LEVELS) {
+            if (strstr(key, "_entries")) p->tlb_entries[lvl - 1] = (size_t)v;
+            else if (strstr(key, "_reach")) p->tlb_reach[lvl - 1] = (size_t)v;
+            else if (strstr(key, "_penalty_ns")) p->tlb_penalty_ns[lvl - 1] = v;
+        }
+    }
+    fclose(f);
+    if (p->levels > PROFILE_MAX_LEVELS) p->levels = PROFILE_MAX_LEVELS;
+    if (p->tlb_levels > PROFILE_MAX_LEVELS) p->tlb_levels = PROFILE_MAX_LEVELS;
+    p->loaded = p->line_size > 0 && p->levels > 0;
+    return p->loaded ? 0 : -1;
+}
+
+// Cache line size to use: the profile's, else 64
+size_t lineSize(void) {
+    return profile.loaded && profile.line_size ? profile.line_size : 64;
+}
+
+// ---------------------- Coherence ----------------------
+// Three views of cache-line traffic between cores:
+// - ping-pong: two threads pinned to a pair of CPUs bounce one line by
+//   taking turns writing a sequence number; half a round trip is the
+//   one-way core-to-core latency, printed for every ordered pair
+// - atomics: 1..max_threads threads hammer one shared counter with
+//   fetch-add or a CAS retry loop for a fixed duration
+// - false sharing: every thread increments its own counter, packed 8 bytes
+//   apart (same line) or padded to one or two lines (adjacent-line prefetch);
+//   the line is the profile's, 64 bytes without one
+// Threads are pinned in compact order and released together, as in the
+// intensity sweep.
+
+typedef enum { ATOMIC_FETCH_ADD, ATOMIC_CAS, ATOMIC_PRIVATE } atomic_op_t;
+
+typedef struct {
+    int cpu;
+    atomic_op_t op;
+    volatile uint64_t *target;      // shared counter, or this thread's slot
+    volatile uint64_t *line;        // ping-pong line
+    int parity;                     // ping-pong: 1 for the initiator, 0 for the responder
+    uint64_t rounds;
+    volatile int *ready_count;
+    volatile int *start_flag;
+    volatile int *stop_flag;
+    uint64_t result_ops;
+    uint64_t result_failures;       // CAS attempts that lost the race
+} coherence_arg_t;
+
+// Both sides of the ping-pong: the initiator writes odd numbers, the
+// responder even ones, each waiting to see the other's last write
+void *pingPongThread(void *argptr) {
+    coherence_arg_t *arg = (coherence_arg_t *)argptr;
+    pinThread(arg->cpu);
+    __sync_fetch_and_add(arg->ready_count, 1);
+    while (!*(arg->start_flag)) sched_yield();
+    uint64_t next = arg->parity ? 1 : 2;
+    for (uint64_t r=0; r<arg->rounds; r++, next += 2) {
+        while (__atomic_load_n(arg->line, __ATOMIC_ACQUIRE) != next - 1) {}
+        __atomic_store_n(arg->line, next, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+void *atomicThread(void *argptr) {
+    coherence_arg_t *arg = (coherence_arg_t *)argptr;
+    pinThread(arg->cpu);
+    __sync_fetch_and_add(arg->ready_count, 1);
+    while (!*(arg->start_flag)) sched_yield();
+    uint64_t ops = 0, failures = 0;
+    volatile uint64_t *p = arg->target;
+    while (!*(arg->stop_flag)) {
+        // 64 operations between polls of the stop flag
+        for (int k=0; k<64; k++) {
+            if (arg->op == ATOMIC_FETCH_ADD) {
+                __atomic_fetch_add(p, 1, __ATOMIC_SEQ_CST);
+            } else if (arg->op == ATOMIC_CAS) {
+                uint64_t v = __atomic_load_n(p, __ATOMIC_RELAXED);
+                while (!__atomic_compare_exchange_n(p, &v, v + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) failures++;
+            } else {
+                *p = *p + 1;
+            }
+        }
+        ops += 64;
+    }
+    arg->result_ops = ops;
+    arg->result_failures = failures;
+    return NULL;
+}
+
+// Start threads on fn, release them together, run for duration (or until
+// they return when duration is 0), and return the elapsed seconds
+double runCoherenceThreads(void *(*fn)(void *), coherence_arg_t *args, int threads, double duration) {
+    pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+    volatile int ready = 0, start = 0, stop = 0;
+    for (int i=0;i<threads;i++) {
+        args[i].ready_count = &ready;
+        args[i].start_flag = &start;
+        args[i].stop_flag = &stop;
+        args[i].result_ops = 0;
+        args[i].result_failures = 0;
+        pthread_create(&tids[i], NULL, fn, &args[i]);
+    }
+    while (ready < threads) sched_yield();
+    perfCountersStart(&counters);
+    uint64_t t0 = now_ns();
+    start = 1;
+    if (duration > 0.0) {
+        sleepSeconds(duration);
+        stop = 1;
+    }
+    for (int i=0;i<threads;i++) pthread_join(tids[i], NULL);
+    uint64_t t1 = now_ns();
+    perfCountersStop(&counters);
+    free(tids);
+    return (double)(t1 - t0) / 1e9;
+}
+
+void benchmarkCoherence(uint64_t rounds, double duration, int max_threads) {
+    cpu_topo_t topo[MAX_CPUS];
+    int ncpus = pinOrder(PIN_COMPACT, topo, MAX_CPUS);
+    // one line each for the ping-pong and the shared counter, then slots
+    // for the false-sharing counters at the widest padding
+    const size_t pads[] = {sizeof(uint64_t), lineSize(), 2 * lineSize()};
+    const size_t maxPad = pads[2];
+    size_t bytes = 2 * maxPad + (size_t)max_threads * maxPad;
+    uint8_t *mem = allocBuffer(bytes);
+    if (!mem) { fprintf(stderr, "alloc failed for coherence\n"); return; }
+    memset(mem, 0, bytes);
+    volatile uint64_t *line = (volatile uint64_t *)mem;
+    volatile uint64_t *shared = (volatile uint64_t *)(mem + maxPad);
+    uint8_t *slots = mem + 2 * maxPad;
+    coherence_arg_t *args = calloc((size_t)(max_threads > 2 ? max_threads : 2), sizeof(coherence_arg_t));
+
+    printf("#coherence,cpus=%d,rounds=%" PRIu64 ",duration_s=%f,max_threads=%d\n", ncpus, rounds, duration, max_threads);
+    if (ncpus < 2) fprintf(stderr, "coherence: one CPU, ping-pong matrix skipped\n");
+    for (int a=0; a<ncpus; a++) {
+        for (int b=0; b<ncpus; b++) {
+            if (topo[a].cpu == topo[b].cpu) continue;
+            *line = 0;
+            args[0].cpu = topo[a].cpu; args[0].parity = 1; args[0].line = line; args[0].rounds = rounds;
+            args[1].cpu = topo[b].cpu; args[1].parity = 0; args[1].line = line; args[1].rounds = rounds;
+            double seconds = runCoherenceThreads(pingPongThread, args, 2, 0.0);
+            double roundtrip_ns = seconds * 1e9 / (double)rounds;
+            printf("pingpong,cpu_a=%d,cpu_b=%d,same_core=%d,same_package=%d,roundtrip_ns=%f,oneway_ns=%f%s\n",
+                topo[a].cpu, topo[b].cpu, topo[a].package == topo[b].package && topo[a].core == topo[b].core,
+                topo[a].package == topo[b].package, roundtrip_ns, roundtrip_ns / 2.0,
+                perfCountersCsv(&counters, (double)rounds, 1, countersCsv, sizeof(countersCsv)));
+            fflush(stdout);
+        }
+    }
+
+    if (max_threads > ncpus) fprintf(stderr, "coherence: %d threads share %d CPUs\n", max_threads, ncpus);
+    const char *opNames[] = {"fetch_add", "cas"};
+    for (int op=ATOMIC_FETCH_ADD; op<=ATOMIC_CAS; op++) {
+        for (int threads=1; threads<=max_threads; threads++) {
+            *shared = 0;
+            for (int i=0;i<threads;i++) { args[i].cpu = topo[i % ncpus].cpu; args[i].op = (atomic_op_t)op; args[i].target = shared; }
+            double seconds = runCoherenceThreads(atomicThread, args, threads, duration);
+            uint64_t ops = 0, failures = 0;
+            for (int i=0;i<threads;i++) { ops += args[i].result_ops; failures += args[i].result_failures; }
+            printf("atomic,op=%s,threads=%d,mops_s=%f,ns_per_op=%f,failures_per_op=%f%s\n", opNames[op], threads,
+                (double)ops / seconds / 1e6, seconds * 1e9 * threads / (double)ops, (double)failures / (double)ops,
+                perfCountersCsv(&counters, (double)ops, 1, countersCsv, sizeof(countersCsv)));
+            fflush(stdout);
+        }
+    }
+
+    for (size_t p=0; p<sizeof(pads)/sizeof(pads[0]); p++) {
+        for (int threads=1; threads<=max_threads; threads++) {
+            memset(slots, 0, (size_t)max_threads * maxPad);
+            for (int i=0;i<threads;i++) {
+                args[i].cpu = topo[i % ncpus].cpu;
+                args[i].op = ATOMIC_PRIVATE;
+                args[i].target = (volatile uint64_t *)(slots + (size_t)i * pads[p]);
+            }
+            double seconds = runCoherenceThreads(atomicThread, args, threads, duration);
+            uint64_t ops = 0;
+            for (int i=0;i<threads;i++) ops += args[i].result_ops;
+            printf("false_sharing,pad=%zu,threads=%d,mops_s=%f,ns_per_op=%f%s\n", pads[p], threads,
+                (double)ops / seconds / 1e6, seconds * 1e9 * threads / (double)ops,
+                perfCountersCsv(&counters, (double)ops, 1, countersCsv, sizeof(countersCsv)));
+            fflush(stdout);
+        }
+    }
+    free(args);
+    freeBuffer(mem, bytes);
+}
+
+// ---------------------- Autodetect ----------------------
+// Measures what the other modes otherwise take on faith:
+// - a random line chase over sizes from 4 KiB up, 8 points per octave, fitted
+//   with latency plateaus; each plateau is a cache level (the last one is
+//   DRAM) and its knee is the level's effective capacity
+// - the line size, from chases over a fixed node count at growing strides:
+//   latency climbs while nodes still share lines and stops at the line size
+// - TLB reach, from a chase touching one line per page against a control
+//   chase over the same number of lines packed together; plateaus of the
+//   extra time per access are the TLB levels
+// sysfs cache/index* (sysctl hw.* on macOS) is printed alongside as a
+// cross-check, and the result is written as the host profile.
+#define AUTODETECT_PER_OCTAVE 8
+#define AUTODETECT_MAX_POINTS 256
+
+typedef struct {
+    int level;
+    size_t size;
+    size_t line;
+} sys_cache_t;
+
+size_t parseCacheSize(const char *s) {
+    char *end;
+    double v = strtod(s, &end);
+    if (*end == 'K' || *end == 'k') v *= 1024.0;
+    else if (*end == 'M' || *end == 'm') v *= 1024.0 * 1024.0;
+    else if (*end == 'G' || *end == 'g') v *= 1024.0 * 1024.0 * 1024.0;
+    return (size_t)v;
+}
+
+// Data and unified caches the OS reports for cpu, sorted by level
+int readSysCaches(int cpu, sys_cache_t *out, int max) {
+    int n = 0;
+#if defined(__linux__)
+    for (int idx=0; n<max; idx++) {
+        char path[160], type[32] = "", size[32] = "";
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, idx);
+        FILE *f = fopen(path, "r");
+        if (!f) break;
+        if (fscanf(f, "%31s", type) != 1) type[0] = '\0';
+        fclose(f);
+        if (strcmp(type, "Instruction")==0) continue;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/size", cpu, idx);
+        f = fopen(path, "r");
+        if (!f) continue;
+        if (fscanf(f, "%31s", size) != 1) size[0] = '\0';
+        fclose(f);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, idx);
+        out[n].level = readSysInt(path, n + 1);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/coherency_line_size", cpu, idx);
+        out[n].line = (size_t)readSysInt(path, 0);
+        out[n].size = parseCacheSize(size);
+        if (out[n].size) n++;
+    }
+#elif defined(__APPLE__)
+    const char *names[] = {"hw.l1dcachesize", "hw.l2cachesize", "hw.l3cachesize"};
+    int64_t line = 0;
+    size_t len = sizeof(line);
+    sysctlbyname("hw.cachelinesize", &line, &len, NULL, 0);
+    for (int i=0; i<3 && n<max; i++) {
+        int64_t v = 0;
+        len = sizeof(v);
+        if (sysctlbyname(names[i], &v, &len, NULL, 0) != 0 || v <= 0) continue;
+        out[n].level = i + 1;
+        out[n].size = (size_t)v;
+        out[n].line = (size_t)line;
+        n++;
+    }
+#else
+    (void)cpu; (void)out; (void)max;
+#endif
+    for (int i=1;i<n;i++) {
+        for (int j=i; j>0 && out[j-1].level > out[j].level; j--) { sys_cache_t t = out[j]; out[j] = out[j-1]; out[j-1] = t; }
+    }
+    return n;
+}
+
+// Best-of-repeats ns per load over a chase list, warmed by walking it twice
+double timeChase(uint64_t *arr, size_t nodes, uint64_t jumps, int repeats) {
+    uint64_t warm = 2 * (uint64_t)nodes;
+    if (warm < jumps / 10) warm = jumps / 10;
+    if (warm > (8ull << 20)) warm = 8ull << 20;
+    uint64_t idx = chaseOnce(arr, 0, warm);
+    double best = 0.0;
+    for (int r=0;r<repeats;r++) {
+        uint64_t t0 = now_ns();
+        idx = chaseOnce(arr, idx, jumps);
+        uint64_t t1 = now_ns();
+        double ns = (double)(t1 - t0) / (double)jumps;
+        if (r == 0 || ns < best) best = ns;
+    }
+    blackhole = idx;
+    return best;
+}
+
+double chaseLatency(size_t size, size_t stride, uint64_t jumps, int repeats) {
+    uint64_t *arr = NULL;
+    makeChaseList(size, stride, CHASE_LINE, &arr);
+    if (!arr) return -1.0;
+    double ns = timeChase(arr, size / stride, jumps, repeats);
+    freeBuffer(arr, size);
+    return ns;
+}
+
+// One node per page, in a random page cycle; the node's line within the
+// page rotates so the lines spread over every cache set
+double pageChaseLatency(size_t pages, size_t page, size_t line, uint64_t jumps, int repeats) {
+    size_t size = pages * page;
+    uint64_t *arr = allocBuffer(size);
+    size_t *perm = malloc(pages * sizeof(size_t));
+    if (!arr || !perm) { freeBuffer(arr, size); free(perm); return -1.0; }
+    size_t linesPerPage = page / line;
+    sattoloCycle(perm, pages, 0x9E3779B97F4A7C15ull);
+    for (size_t p=0; p<pages; p++) {
+        size_t at = (p * page + (p % linesPerPage) * line) / sizeof(uint64_t);
+        size_t next = (perm[p] * page + (perm[p] % linesPerPage) * line) / sizeof(uint64_t);
+        arr[at] = (uint64_t)next;
+    }
+    free(perm);
+    double ns = timeChase(arr, pages, jumps, repeats);
+    freeBuffer(arr, size);
+    return ns;
+}
+
+// Piecewise-constant least-squares fit of y[0..n) with k segments of at
+// least minLen points, by dynamic programming. Writes each segment's first
+// index to starts[] and returns the squared error, or -1 if k does not fit
+// (or the tables cannot be allocated).
+double fitSegments(const double *y, int n, int k, int minLen, int *starts) {
+    if (k < 1 || k * minLen > n) return -1.0;
+    double *s1 = calloc(n + 1, sizeof(double)), *s2 = calloc(n + 1, sizeof(double));
+    double *cost = malloc(sizeof(double) * (k + 1) * (n + 1));
+    int *from = malloc(sizeof(int) * (k + 1) * (n + 1));
+    if (!s1 || !s2 || !cost || !from) {
+        fprintf(stderr, "alloc failed for segment fit\n");
+        free(s1); free(s2); free(cost); free(from);
+        return -1.0;
+    }
+    for (int i=0;i<n;i++) { s1[i+1] = s1[i] + y[i]; s2[i+1] = s2[i] + y[i] * y[i]; }
+    #define SEG_ERR(a, b) (s2[b] - s2[a] - (s1[b] - s1[a]) * (s1[b] - s1[a]) / (double)((b) - (a)))
+    for (int j=0;j<=k;j++) for (int e=0;e<=n;e++) cost[j*(n+1)+e] = -1.0;
+    cost[0] = 0.0;
+    for (int j=1;j<=k;j++) {
+        for (int e=j*minLen; e<=n; e++) {
+            for (int b=(j-1)*minLen; b<=e-minLen; b++) {
+                double prev = cost[(j-1)*(n+1)+b];
+                if (prev < 0.0) continue;
+                double c = prev + SEG_ERR(b, e);
+                if (cost[j*(n+1)+e] < 0.0 || c < cost[j*(n+1)+e]) { cost[j*(n+1)+e] = c; from[j*(n+1)+e] = b; }
+            }
+        }
+    }
+    #undef SEG_ERR
+    double err = cost[k*(n+1)+n];
+    for (int j=k, e=n; j>=1; j--) { starts[j-1] = from[j*(n+1)+e]; e = starts[j-1]; }
+    free(s1); free(s2); free(cost); free(from);
+    return err;
+}
+
+int cmpDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Plateaus of y (already in log space): the segment count grows while each
+// extra segment at least halves the error and the error is above noise.
+// A segment is a plateau when at least half its points lie within flatTol
+// of its median, otherwise it is a transition and dropped. For every
+// plateau writes its median level and its knee, the last index still
+// within 15% (of the step to the next plateau) of that level.
+int findPlateaus(const double *y, int n, int maxSegs, int minLen, double noise, double flatTol, double *level, int *knee) {
+    int starts[16], best[16];
+    int k = 1;
+    double err = fitSegments(y, n, 1, minLen, best);
+    if (err < 0.0) return 0;    // fewer than minLen points: nothing to fit
+    if (maxSegs > 16) maxSegs = 16;
+    for (int j=2; j<=maxSegs; j++) {
+        double e = fitSegments(y, n, j, minLen, starts);
+        if (e < 0.0 || err <= noise * n || e > 0.5 * err) break;
+        err = e; k = j;
+        memcpy(best, starts, sizeof(int) * j);
+    }
+    int count = 0;
+    double *sorted = malloc(sizeof(double) * n);
+    if (!sorted) { fprintf(stderr, "alloc failed for plateau search\n"); return 0; }
+    for (int s=0;s<k;s++) {
+        int a = best[s], b = s + 1 < k ? best[s+1] : n;
+        memcpy(sorted, y + a, sizeof(double) * (b - a));
+        qsort(sorted, b - a, sizeof(double), cmpDouble);
+        double median = sorted[(b - a) / 2];
+        int flat = 0;
+        for (int i=a;i<b;i++) flat += fabs(y[i] - median) <= flatTol;
+        if (2 * flat < b - a) continue;
+        level[count] = median;
+        knee[count] = a;
+        count++;
+    }
+    free(sorted);
+    for (int p=0;p<count;p++) {
+        double limit = p + 1 < count ? level[p] + 0.15 * (level[p+1] - level[p]) : INFINITY;
+        int i = knee[p];
+        while (i + 1 < n && y[i+1] <= limit) i++;
+        knee[p] = i;
+    }
+    return count;
+}
+
+void benchmarkAutodetect(size_t maxSize, uint64_t jumps, int repeats, const char *profilePath) {
+    int cpus[MAX_CPUS];
+    allowedCpus(cpus, MAX_CPUS);
+    pinThread(cpus[0]);
+    sys_cache_t sys[PROFILE_MAX_LEVELS];
+    int nsys = readSysCaches(cpus[0], sys, PROFILE_MAX_LEVELS);
+    if (maxSize == 0) {
+        maxSize = nsys ? 4 * sys[nsys-1].size : (512ull << 20);
+        if (maxSize < (64ull << 20)) maxSize = 64ull << 20;
+        if (maxSize > (1ull << 30)) maxSize = 1ull << 30;
+    }
+    memory_profile_t prof;
+    memset(&prof, 0, sizeof(prof));
+    prof.page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    printf("#autodetect,max_size=%zu,points_per_octave=%d,jumps=%" PRIu64 ",cpu=%d,profile=%s\n", maxSize, AUTODETECT_PER_OCTAVE, jumps, cpus[0], profilePath);
+    for (int i=0;i<nsys;i++) printf("sysfs_cache,level=%d,size=%zu,line=%zu\n", sys[i].level, sys[i].size, sys[i].line);
+
+    // size sweep
+    size_t sizes[AUTODETECT_MAX_POINTS];
+    double logLat[AUTODETECT_MAX_POINTS], lat[AUTODETECT_MAX_POINTS];
+    int n = 0;
+    for (int step=0; n<AUTODETECT_MAX_POINTS; step++) {
+        size_t size = roundUp((size_t)(4096.0 * pow(2.0, (double)step / AUTODETECT_PER_OCTAVE)), 64);
+        if (size > maxSize) break;
+        if (n && size == sizes[n-1]) continue;
+        lat[n] = chaseLatency(size, 64, jumps, repeats);
+        if (lat[n] <= 0.0) break;
+        sizes[n] = size;
+        logLat[n] = log(lat[n]);
+        printf("size_sweep,size=%zu,lat_ns=%f\n", size, lat[n]);
+        fflush(stdout);
+        n++;
+    }
+    double level[16];
+    int knee[16];
+    int plateaus = findPlateaus(logLat, n, PROFILE_MAX_LEVELS + 3, AUTODETECT_PER_OCTAVE / 2, 1e-4, log(1.15), level, knee);
+    prof.levels = plateaus > 1 ? plateaus - 1 : 0;
+    if (prof.levels > PROFILE_MAX_LEVELS) prof.levels = PROFILE_MAX_LEVELS;
+    for (int i=0;i<prof.levels;i++) {
+        prof.cache_size[i] = sizes[knee[i]];
+        prof.latency_ns[i] = exp(level[i]);
+        size_t sysSize = i < nsys ? sys[i].size : 0;
+        double ratio = sysSize ? (double)prof.cache_size[i] / (double)sysSize : 0.0;
+        printf("level,level=%d,size=%zu,latency_ns=%f,sysfs_size=%zu,ratio=%f,agree=%d\n", i + 1, prof.cache_size[i], prof.latency_ns[i],
+            sysSize, ratio, ratio >= 0.5 && ratio <= 1.5);
+    }
+    if (plateaus > 0) prof.latency_ns[prof.levels] = exp(level[plateaus - 1]);
+    printf("dram,latency_ns=%f,plateaus=%d%s\n", prof.latency_ns[prof.levels], plateaus, plateaus < 2 ? ",note=no knee found; raise --size" : "");
+    if (nsys && prof.levels != nsys) fprintf(stderr, "autodetect: found %d cache levels, sysfs lists %d\n", prof.levels, nsys);
+
+    // line size: a fixed node count twice the L1 line count, so the nodes
+    // overflow L1 exactly when each one has a line of its own
+    size_t l1 = prof.levels ? prof.cache_size[0] : (nsys ? sys[0].size : 32768);
+    size_t nodes = 2 * l1 / 64;
+    double strideLat[5];
+    size_t strides[5] = {8, 16, 32, 64, 128};
+    for (int s=0;s<5;s++) {
+        strideLat[s] = chaseLatency(nodes * strides[s], strides[s], jumps, repeats);
+        printf("line_sweep,stride=%zu,nodes=%zu,lat_ns=%f\n", strides[s], nodes, strideLat[s]);
+    }
+    prof.line_size = strides[4];
+    for (int s=0;s<5;s++) if (strideLat[s] >= 0.92 * strideLat[4]) { prof.line_size = strides[s]; break; }
+    printf("line_size,detected=%zu,sysfs=%zu\n", prof.line_size, nsys ? sys[0].line : 0);
+
+    // TLB: one line per page against the same line count packed together
+    double extraLog[AUTODETECT_MAX_POINTS], pageLat[AUTODETECT_MAX_POINTS], ctrlLat[AUTODETECT_MAX_POINTS];
+    size_t pagesAt[AUTODETECT_MAX_POINTS];
+    int m = 0;
+    for (int step=0; m<AUTODETECT_MAX_POINTS; step++) {
+        size_t pages = (size_t)(8.0 * pow(2.0, step / 4.0));
+        if (pages > 32768 || pages * prof.page_size > maxSize) break;
+        if (m && pages == pagesAt[m-1]) continue;
+        pageLat[m] = pageChaseLatency(pages, prof.page_size, prof.line_size, jumps, repeats);
+        ctrlLat[m] = chaseLatency(pages * prof.line_size, prof.line_size, jumps, repeats);
+        if (pageLat[m] <= 0.0 || ctrlLat[m] <= 0.0) break;
+        pagesAt[m] = pages;
+        // translation cost in ns, log(1 + x) so plateaus fit on a ratio scale
+        extraLog[m] = log1p(pageLat[m] > ctrlLat[m] ? pageLat[m] - ctrlLat[m] : 0.0);
+        printf("tlb_sweep,pages=%zu,lat_ns=%f,control_ns=%f\n", pages, pageLat[m], ctrlLat[m]);
+        fflush(stdout);
+        m++;
+    }
+    plateaus = findPlateaus(extraLog, m, PROFILE_MAX_LEVELS + 1, 3, 1e-3, 0.15, level, knee);
+    prof.tlb_levels = plateaus > 1 ? plateaus - 1 : 0;
+    if (prof.tlb_levels > PROFILE_MAX_LEVELS) prof.tlb_levels = PROFILE_MAX_LEVELS;
+    for (int i=0;i<prof.tlb_levels;i++) {
+        prof.tlb_entries[i] = pagesAt[knee[i]];
+        prof.tlb_reach[i] = prof.tlb_entries[i] * prof.page_size;
+        // extra cost per access once this level's reach is exceeded
+        double extra = 0.0;
+        int cnt = 0;
+        for (int j=knee[i]+1; j<m && j<=knee[i+1]; j++) { extra += pageLat[j] - ctrlLat[j]; cnt++; }
+        prof.tlb_penalty_ns[i] = cnt ? extra / cnt : 0.0;
+        printf("tlb,level=%d,entries=%zu,reach=%zu,penalty_ns=%f\n", i + 1, prof.tlb_entries[i], prof.tlb_reach[i], prof.tlb_penalty_ns[i]);
+    }
+
+    if (prof.levels > 0 && writeProfile(profilePath, &prof) == 0) printf("#profile_written=%s\n", profilePath);
+}
+
+// ---------------------- Config-driven sweep ----------------------
+// One process runs the whole Cartesian product a config file declares, so
+// buffers are allocated and faulted in once per page mode instead of once
+// per point. The config is key = comma-separated values, # starts a comment:
+//   tests    = chase, stream          chase: random line chase, one thread
+//   sizes    = 32K, 1M, 256M          bytes, K/M/G suffixes
+//   strides  = 64, 128
+//   mixes    = 1, 0.5, 0              stream only
+//   threads  = 1, 2, 4                stream only
+//   pages    = malloc, thp            any --pages backing
+//   iters    = 100                    chase jumps/1000
+//   repeats  = 3                      chase repeats, best kept
+//   duration = 0.2                    seconds per stream point
+//   seed     = 1                      execution-order shuffle
+//   output   = sweep.csv              .json for a JSON array
+// Points run grouped by page mode (one pool, sized for the group's largest
+// point, reused by every point) with both the groups and the points in
+// each group shuffled, so drift (thermal, background load) is spread over
+// the sweep instead of biasing one end of it. Every point is written and
+// flushed as soon as it finishes; index is the point's position in the
+// unshuffled product, run its position in execution order.
+#define SWEEP_MAX_VALUES 64
+
+typedef enum { SWEEP_CHASE, SWEEP_STREAM, SWEEP_TEST_COUNT } sweep_test_t;
+
+const char *sweepTestNames[SWEEP_TEST_COUNT] = {"chase", "stream"};
+
+typedef struct {
+    int test[SWEEP_TEST_COUNT];
+    size_t size[SWEEP_MAX_VALUES]; int nsize;
+    size_t stride[SWEEP_MAX_VALUES]; int nstride;
+    double mix[SWEEP_MAX_VALUES]; int nmix;
+    int threads[SWEEP_MAX_VALUES]; int nthreads;
+    backing_t pages[BACKING_COUNT]; int npages;
+    uint64_t jumps;
+    int repeats;
+    double duration;
+    uint64_t seed;
+    char output[256];
+} sweep_config_t;
+
+typedef struct {
+    int index;
+    sweep_test_t test;
+    backing_t pages;
+    size_t size;
+    size_t stride;
+    double mix;
+    int threads;
+} sweep_point_t;
+
+char *trim(char *s) {
+    while (*s == ' ' || *s == '\t') s++;
+    char *e = s + strlen(s);
+    while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\n' || e[-1] == '\r')) *--e = '\0';
+    return s;
+}
+
+int parseSweepConfig(const char *path, sweep_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->test[SWEEP_CHASE] = cfg->test[SWEEP_STREAM] = 1;
+    cfg->stride[cfg->nstride++] = lineSize();
+    cfg->mix[cfg->nmix++] = 1.0;
+    cfg->threads[cfg->nthreads++] = 1;
+    cfg->pages[cfg->npages++] = BACKING_MALLOC;
+    cfg->jumps = 100000;
+    cfg->repeats = 3;
+    cfg->duration = 0.2;
+    cfg->seed = 1;
+    snprintf(cfg->output, sizeof(cfg->output), "sweep.csv");
+
+    FILE *f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "cannot read sweep config %s: %s\n", path, strerror(errno)); return -1; }
+    char line[1024];
+    int lineNo = 0, bad = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *eq = strchr(line, '=');
+        if (!eq) { if (*trim(line)) { fprintf(stderr, "%s:%d: expected key = values\n", path, lineNo); bad = 1; } continue; }
+        *eq = '\0';
+        char *key = trim(line);
+        char *values = trim(eq + 1);
+        if (strcmp(key, "output")==0) { snprintf(cfg->output, sizeof(cfg->output), "%s", values); continue; }
+        int count = 0;
+        for (char *save = NULL, *v = strtok_r(values, ",", &save); v; v = strtok_r(NULL, ",", &save)) {
+            v = trim(v);
+            if (count >= SWEEP_MAX_VALUES) { fprintf(stderr, "%s:%d: more than %d values\n", path, lineNo, SWEEP_MAX_VALUES); bad = 1; break; }
+            if (strcmp(key, "tests")==0) {
+                if (count == 0) memset(cfg->test, 0, sizeof(cfg->test));
+                int found = 0;
+                for (int t=0;t<SWEEP_TEST_COUNT;t++) if (strcmp(v, sweepTestNames[t])==0) { cfg->test[t] = 1; found = 1; }
+                if (!found) { fprintf(stderr, "%s:%d: unknown test %s\n", path, lineNo, v); bad = 1; }
+            } else if (strcmp(key, "sizes")==0) { cfg->size[count] = parseCacheSize(v); cfg->nsize = count + 1; }
+            else if (strcmp(key, "strides")==0) { cfg->stride[count] = parseCacheSize(v); cfg->nstride = count + 1; }
+            else if (strcmp(key, "mixes")==0) { cfg->mix[count] = atof(v); cfg->nmix = count + 1; }
+            else if (strcmp(key, "threads")==0) { cfg->threads[count] = atoi(v); cfg->nthreads = count + 1; }
+            else if (strcmp(key, "pages")==0) {
+                if (count >= BACKING_COUNT) { fprintf(stderr, "%s:%d: too many page modes\n", path, lineNo); bad = 1; break; }
+                int found = 0;
+                for (int k=0;k<BACKING_COUNT;k++) if (strcmp(v, backingNames[k])==0) { cfg->pages[count] = (backing_t)k; found = 1; }
+                if (!found) { fprintf(stderr, "%s:%d: unknown page mode %s\n", path, lineNo, v); bad = 1; }
+#ifndef __linux__
+                if (found && cfg->pages[count] != BACKING_MALLOC) { fprintf(stderr, "%s:%d: pages %s needs Linux mmap flags\n", path, lineNo, v); bad = 1; }
+#endif
+                cfg->npages = count + 1;
+            }
+            else if (strcmp(key, "iters")==0) cfg->jumps = (uint64_t)atoll(v) * 1000ull;
+            else if (strcmp(key, "repeats")==0) cfg->repeats = atoi(v);
+            else if (strcmp(key, "duration")==0) cfg->duration = atof(v);
+            else if (strcmp(key, "seed")==0) cfg->seed = (uint64_t)atoll(v);
+            else { fprintf(stderr, "%s:%d: unknown key %s\n", path, lineNo, key); bad = 1; break; }
+            count++;
+        }
+    }
+    fclose(f);
+    if (cfg->nsize == 0) {
+        // from the host profile: inside each level and well past the last
+        if (profile.loaded) {
+            for (int i=0;i<profile.levels;i++) cfg->size[cfg->nsize++] = roundUp(profile.cache_size[i] / 2, 4096);
+            cfg->size[cfg->nsize++] = 4 * profile.cache_size[profile.levels - 1];
+        } else {
+            const size_t fallback[] = {16u << 10, 256u << 10, 4u << 20, 256u << 20};
+            for (size_t i=0;i<sizeof(fallback)/sizeof(fallback[0]);i++) cfg->size[cfg->nsize++] = fallback[i];
+        }
+    }
+    for (int i=0;i<cfg->nstride;i++) if (cfg->stride[i] < sizeof(uint64_t)) cfg->stride[i] = sizeof(uint64_t);
+    for (int i=0;i<cfg->nthreads;i++) if (cfg->threads[i] < 1) cfg->threads[i] = 1;
+    if (cfg->repeats < 1) cfg->repeats = 1;
+    if (cfg->jumps < 1000) cfg->jumps = 1000;
+    return bad ? -1 : 0;
+}
+
+void shufflePoints(sweep_point_t *p, int n, uint64_t *state) {
+    for (int i=n-1; i>0; i--) {
+        int j = (int)(chaseRandom(state) % (uint64_t)(i + 1));
+        sweep_point_t t = p[i]; p[i] = p[j]; p[j] = t;
+    }
+}
+
+// Bytes of pool a point needs: the chase list, or an A/B pair per thread
+size_t sweepPointBytes(const sweep_point_t *p) {
+    return p->test == SWEEP_CHASE ? roundUp(p->size, 64) : (size_t)p->threads * 2 * roundUp(p->size, 64);
+}
+
+void sweepWrite(FILE *out, int json, int run, const sweep_point_t *p, size_t huge, double lat_ns, double gib_s, double scale) {
+    char mix[32] = "", threads[16] = "", lat[32] = "", gib[32] = "";
+    if (p->test == SWEEP_STREAM) { snprintf(mix, sizeof(mix), "%g", p->mix); snprintf(threads, sizeof(threads), "%d", p->threads); }
+    if (lat_ns >= 0.0) snprintf(lat, sizeof(lat), "%f", lat_ns);
+    if (gib_s >= 0.0) snprintf(gib, sizeof(gib), "%f", gib_s);
+    if (!json) {
+        fprintf(out, "%d,%d,%s,%s,%zu,%zu,%s,%s,%zu,%s,%s%s\n", p->index, run, sweepTestNames[p->test], backingNames[p->pages], p->size, p->stride,
+            mix, threads, huge, lat, gib, perfCountersCsv(&counters, scale, 0, countersCsv, sizeof(countersCsv)));
+    } else {
+        fprintf(out, "%s{\"index\":%d,\"run\":%d,\"test\":\"%s\",\"pages\":\"%s\",\"size\":%zu,\"stride\":%zu,\"mix\":%s,\"threads\":%s,\"huge_bytes\":%zu,\"lat_ns\":%s,\"gib_s\":%s",
+            run ? ",\n" : "", p->index, run, sweepTestNames[p->test], backingNames[p->pages], p->size, p->stride,
+            *mix ? mix : "null", *threads ? threads : "null", huge, *lat ? lat : "null", *gib ? gib : "null");
+        if (counters.enabled) {
+            fprintf(out, ",\"counters\":{");
+            for (int c=0;c<PC_COUNT;c++) {
+                if (counters.valid[c]) fprintf(out, "%s\"%s\":%.10g", c ? "," : "", perfCounterNames[c], counters.value[c] / scale);
+                else fprintf(out, "%s\"%s\":null", c ? "," : "", perfCounterNames[c]);
+            }
+            fprintf(out, "}");
+        }
+        fprintf(out, "}");
+    }
+    fflush(out);
+}
+
+void benchmarkSweep(const char *configPath) {
+    sweep_config_t cfg;
+    if (parseSweepConfig(configPath, &cfg) != 0) return;
+
+    // the product, in declaration order so index is stable across seeds
+    int total = 0;
+    if (cfg.test[SWEEP_CHASE]) total += cfg.npages * cfg.nsize * cfg.nstride;
+    if (cfg.test[SWEEP_STREAM]) total += cfg.npages * cfg.nsize * cfg.nstride * cfg.nmix * cfg.nthreads;
+    sweep_point_t *points = malloc(sizeof(sweep_point_t) * (total ? total : 1));
+    int n = 0;
+    for (int t=0;t<SWEEP_TEST_COUNT;t++) {
+        if (!cfg.test[t]) continue;
+        for (int pg=0;pg<cfg.npages;pg++) for (int sz=0;sz<cfg.nsize;sz++) for (int st=0;st<cfg.nstride;st++) {
+            int nmix = t == SWEEP_STREAM ? cfg.nmix : 1, nthr = t == SWEEP_STREAM ? cfg.nthreads : 1;
+            for (int mx=0;mx<nmix;mx++) for (int th=0;th<nthr;th++) {
+                sweep_point_t p = { n, (sweep_test_t)t, cfg.pages[pg], cfg.size[sz], cfg.stride[st], cfg.mix[mx], cfg.threads[th] };
+                points[n++] = p;
+            }
+        }
+    }
+
+    int json = strlen(cfg.output) > 5 && strcmp(cfg.output + strlen(cfg.output) - 5, ".json")==0;
+    FILE *out = fopen(cfg.output, "w");
+    if (!out) { fprintf(stderr, "cannot write %s: %s\n", cfg.output, strerror(errno)); free(points); return; }
+    if (json) fprintf(out, "[\n");
+    else fprintf(out, "index,run,test,pages,size,stride,mix,threads,huge_bytes,lat_ns,gib_s%s\n", perfCountersCsvHeader(&counters));
+
+    cpu_topo_t topo[MAX_CPUS];
+    int ncpus = pinOrder(PIN_COMPACT, topo, MAX_CPUS);
+    pinThread(topo[0].cpu);
+    printf("#sweep,config=%s,points=%d,output=%s,seed=%" PRIu64 "\n", configPath, n, cfg.output, cfg.seed);
+    fflush(stdout);
+
+    // page-mode groups in shuffled order, points shuffled within each
+    uint64_t state = cfg.seed ? cfg.seed : 1;
+    backing_t order[BACKING_COUNT];
+    int ngroups = cfg.npages;
+    memcpy(order, cfg.pages, sizeof(backing_t) * ngroups);
+    for (int i=ngroups-1; i>0; i--) { int j = (int)(chaseRandom(&state) % (uint64_t)(i + 1)); backing_t t = order[i]; order[i] = order[j]; order[j] = t; }
+
+    backing_t saved = backing;
+    uint64_t t0 = now_ns();
+    int run = 0;
+    for (int g=0; g<ngroups; g++) {
+        sweep_point_t *group = malloc(sizeof(sweep_point_t) * (n ? n : 1));
+        if (!group) { fprintf(stderr, "sweep: alloc failed for pages=%s, group skipped\n", backingNames[order[g]]); continue; }
+        int m = 0;
+        size_t poolBytes = 0;
+        for (int i=0;i<n;i++) {
+            if (points[i].pages != order[g]) continue;
+            group[m++] = points[i];
+            if (sweepPointBytes(&points[i]) > poolBytes) poolBytes = sweepPointBytes(&points[i]);
+        }
+        // a page mode no point uses gets no pool at all
+        if (!m) { free(group); continue; }
+        shufflePoints(group, m, &state);
+
+        backing = order[g];
+        uint8_t *pool = allocBuffer(poolBytes);
+        if (!pool) { fprintf(stderr, "sweep: %zu-byte pool for pages=%s failed, %d points skipped\n", poolBytes, backingNames[order[g]], m); free(group); continue; }
+        memset(pool, 0, poolBytes);
+        size_t huge = hugeBackedBytes(pool);
+
+        for (int i=0;i<m;i++, run++) {
+            sweep_point_t *p = &group[i];
+            if (p->test == SWEEP_CHASE) {
+                uint64_t *arr = (uint64_t *)pool;
+                if (buildChaseList(arr, p->size, p->stride, CHASE_LINE) != 0) { fprintf(stderr, "sweep: chase list for point %d failed\n", p->index); continue; }
+                uint64_t nodes = p->size / (p->stride < sizeof(uint64_t) ? sizeof(uint64_t) : p->stride);
+                uint64_t warm = 2 * nodes < (8ull << 20) ? 2 * nodes : (8ull << 20);
+                uint64_t idx = chaseOnce(arr, 0, warm);
+                double best = -1.0;
+                perfCountersStart(&counters);
+                for (int r=0;r<cfg.repeats;r++) {
+                    uint64_t c0 = now_ns();
+                    idx = chaseOnce(arr, idx, cfg.jumps);
+                    uint64_t c1 = now_ns();
+                    double ns = (double)(c1 - c0) / (double)cfg.jumps;
+                    if (best < 0.0 || ns < best) best = ns;
+                }
+                perfCountersStop(&counters);
+                blackhole = idx;
+                sweepWrite(out, json, run, p, huge, best, -1.0, (double)cfg.jumps * cfg.repeats);
+            } else {
+                size_t elems = roundUp(p->size, 64) / sizeof(double);
+                thread_arg_t *targs = malloc(sizeof(thread_arg_t) * p->threads);
+                for (int t=0;t<p->threads;t++) {
+                    double *a = (double *)pool + (size_t)t * 2 * elems;
+                    for (size_t e=0; e<2*elems; e++) a[e] = 1.0;
+                    initThreadArg(&targs[t], p->size, p->stride, p->mix, t, NULL, NULL);
+                    targs[t].cpu = topo[t % ncpus].cpu;
+                    targs[t].shared_a = a;
+                    targs[t].shared_b = a + elems;
+                }
+                double seconds = runStreamThreads(targs, p->threads, cfg.duration);
+                double bytes = 0.0, lat = 0.0;
+                for (int t=0;t<p->threads;t++) { bytes += targs[t].result_bytes; lat += targs[t].result_latency_ns; }
+                double bytesPerOp = streamBytesPerOp(p->mix);
+                sweepWrite(out, json, run, p, huge, lat / p->threads, bytes / (1024.0*1024.0*1024.0) / seconds, bytes / bytesPerOp);
+                free(targs);
+            }
+        }
+        freeBuffer(pool, poolBytes);
+        free(group);
+    }
+    backing = saved;
+    if (json) fprintf(out, "%s]\n", run ? "\n" : "");
+    fclose(out);
+    printf("#sweep_done,points=%d,seconds=%f\n", run, (double)(now_ns() - t0) / 1e9);
+    free(points);
 }
 
 // ---------------------- Command-line interface ----------------------
@@ -290,19 +1977,50 @@ void usage(const char *pname) {
         "Usage: %s <mode> [options]\n"
         "Modes:\n"
         "  pc   : pointer-chase latency\n"
-        "    opts: --size <bytes> --stride <bytes> --iters <jumps> --repeats <r>\n"
+        "    opts: --size <bytes> --stride <bytes> --order <line|page|stride> --iters <jumps> --repeats <r>\n"
+        "  mlp  : 1..maxchains interleaved random chases (memory-level parallelism)\n"
+        "    opts: --size <bytes> --stride <bytes> --order <line|page> --iters <jumps> --repeats <r> --maxchains <1..32>\n"
         "  stream : streaming bandwidth\n"
         "    opts: --size <bytes> --stride <bytes> --mix <read_ratio (0..1)> --iters <loops> --repeats <r>\n"
+        "  kernels : copy/scale/add/triad/sum/fill for libc, rep, SSE2, AVX2, AVX-512 with regular and non-temporal stores\n"
+        "    opts: --size <bytes per array> --iters <loops> --repeats <r> --prefetch <bytes ahead, 0 = off>\n"
         "  saxpy : saxpy kernel\n"
         "    opts: --size <bytes> --iters <loops> --repeats <r>\n"
-        "  intensity : multi-thread intensity sweep\n"
-        "    opts: --size <bytes> --stride <bytes> --mix <0..1> --iters <per-thread> --maxthreads <2|4|8|..>\n"
+        "  intensity : multi-thread intensity sweep, 1..maxthreads threads released together for a fixed duration\n"
+        "    opts: --size <bytes per thread> --stride <bytes> --mix <0..1> --duration <seconds> --maxthreads <n>\n"
+        "          --pin <compact|scatter|smt> --placement <local|remote|shared>\n"
+        "  loaded : chase latency under maxthreads stream threads, swept from idle to full load (MLC-style)\n"
+        "    opts: --size <bytes> --stride <bytes> --mix <0..1> --iters <jumps/1000> --maxthreads <load threads>\n"
+        "  coherence : core-to-core ping-pong matrix, fetch-add/CAS contention and false sharing (8/64/128-byte pad)\n"
+        "    opts: --iters <ping-pong round trips/1000> --duration <seconds per point> --maxthreads <n>\n"
+        "  autodetect : fine chase sweep fitted into latency plateaus; cache sizes, line size, per-level latency, TLB reach,\n"
+        "    checked against sysfs and written to the host profile\n"
+        "    opts: --size <max bytes, default 4x sysfs LLC> --iters <jumps/1000> --repeats <r> --profile <file>\n"
+        "  sweep : every point of a config file's sizes x strides x mixes x threads x pages in one process, shuffled,\n"
+        "    streamed to one CSV/JSON file (config format above benchmarkSweep in Benchmark.c)\n"
+        "    opts: --config <file>\n"
+        "  pages : latency/bandwidth/dTLB misses for every --pages backing, 1 MiB..size\n"
+        "    opts: --size <max bytes> --iters <jumps/1000> --repeats <r>\n"
+        "  --pages <malloc|4k|thp|2m|1g|populate> (any mode): buffer backing store (default malloc)\n"
+        "  --profile <file> (any mode): host profile written by autodetect (default " PROFILE_DEFAULT_PATH "); when it exists,\n"
+        "    --size defaults to 4x the last cache level and --stride to the line size\n"
+        "  --counters (any mode): append cycles, instructions, L1D/LLC/dTLB misses and stall cycles\n"
+        "    per repeat via perf_event_open; columns stay empty where counters are unavailable\n"
+        "  --results <file> pc, mlp, stream, kernels and saxpy only (other modes reject it): append every repeat to file in the shared result schema\n"
+        "    (Common/BenchResult.h) for Common/compareResults.py\n"
         "\nExamples:\n"
         "  %s pc --size 65536 --stride 64 --iters 1000000\n"
+        "  %s mlp --size 268435456 --stride 64 --iters 100 --maxchains 32\n"
+        "  %s pages --size 1073741824 --iters 100\n"
+        "  %s autodetect --iters 200 --repeats 3\n"
+        "  %s sweep --config sweep.conf --counters\n"
+        "  %s coherence --iters 100 --duration 0.5 --maxthreads 8\n"
+        "  %s loaded --size 268435456 --mix 1.0 --iters 100 --maxthreads 7\n"
         "  %s stream --size 8388608 --stride 8 --mix 0.5 --iters 10\n"
-        "  %s saxpy --size 33554432 --iters 20\n"
-        "  %s intensity --size 16777216 --stride 8 --mix 0.5 --iters 100 --maxthreads 8\n",
-        pname, pname, pname, pname, pname);
+        "  %s kernels --size 268435456 --iters 5 --prefetch 1024\n"
+        "  %s saxpy --size 33554432 --iters 20 --results nightly.jsonl\n"
+        "  %s intensity --size 16777216 --stride 8 --mix 0.5 --duration 1 --maxthreads 8 --pin scatter --placement remote\n",
+        pname, pname, pname, pname, pname, pname, pname, pname, pname, pname, pname, pname);
 }
 
 int main(int argc, char **argv) {
@@ -316,34 +2034,128 @@ int main(int argc, char **argv) {
     int repeats = DEFAULT_REPEATS;
     double mix = 0.5;
     int maxthreads = 8;
+    double duration = 1.0;
+    size_t prefetch = 0;
+    pin_policy_t pin = PIN_COMPACT;
+    placement_t placement = PLACE_LOCAL;
+    int useCounters = 0;
+    chase_order_t order = CHASE_LINE;
+    int maxchains = MAX_CHAINS;
+    const char *profilePath = PROFILE_DEFAULT_PATH;
+    int sizeSet = 0, strideSet = 0;
+    const char *configPath = NULL;
+    const char *resultsPath = NULL;
 
     // parse args
     for (int i=2;i<argc;i++) {
-        if (strcmp(argv[i], "--size")==0 && i+1<argc) { size = (size_t)atoll(argv[++i]); }
-        else if (strcmp(argv[i], "--stride")==0 && i+1<argc) { stride = (size_t)atoll(argv[++i]); }
+        if (strcmp(argv[i], "--size")==0 && i+1<argc) { size = (size_t)atoll(argv[++i]); sizeSet = 1; }
+        else if (strcmp(argv[i], "--stride")==0 && i+1<argc) { stride = (size_t)atoll(argv[++i]); strideSet = 1; }
+        else if (strcmp(argv[i], "--profile")==0 && i+1<argc) { profilePath = argv[++i]; }
+        else if (strcmp(argv[i], "--config")==0 && i+1<argc) { configPath = argv[++i]; }
         else if (strcmp(argv[i], "--iters")==0 && i+1<argc) { iters = (uint64_t)atoll(argv[++i]); }
         else if (strcmp(argv[i], "--repeats")==0 && i+1<argc) { repeats = atoi(argv[++i]); }
         else if (strcmp(argv[i], "--mix")==0 && i+1<argc) { mix = atof(argv[++i]); }
         else if (strcmp(argv[i], "--maxthreads")==0 && i+1<argc) { maxthreads = atoi(argv[++i]); }
+        else if (strcmp(argv[i], "--prefetch")==0 && i+1<argc) { prefetch = (size_t)atoll(argv[++i]); }
+        else if (strcmp(argv[i], "--duration")==0 && i+1<argc) { duration = atof(argv[++i]); }
+        else if (strcmp(argv[i], "--counters")==0) { useCounters = 1; }
+        else if (strcmp(argv[i], "--results")==0 && i+1<argc) { resultsPath = argv[++i]; }
+        else if (strcmp(argv[i], "--pin")==0 && i+1<argc) {
+            const char *p = argv[++i];
+            int found = 0;
+            for (int k=0;k<PIN_COUNT;k++) if (strcmp(p, pinPolicyNames[k])==0) { pin = (pin_policy_t)k; found = 1; }
+            if (!found) { fprintf(stderr,"Unknown pin policy: %s\n", p); usage(argv[0]); return 1; }
+        }
+        else if (strcmp(argv[i], "--placement")==0 && i+1<argc) {
+            const char *p = argv[++i];
+            int found = 0;
+            for (int k=0;k<PLACE_COUNT;k++) if (strcmp(p, placementNames[k])==0) { placement = (placement_t)k; found = 1; }
+            if (!found) { fprintf(stderr,"Unknown placement: %s\n", p); usage(argv[0]); return 1; }
+        }
+        else if (strcmp(argv[i], "--maxchains")==0 && i+1<argc) { maxchains = atoi(argv[++i]); }
+        else if (strcmp(argv[i], "--pages")==0 && i+1<argc) {
+            const char *b = argv[++i];
+            int found = 0;
+            for (int k=0;k<BACKING_COUNT;k++) if (strcmp(b, backingNames[k])==0) { backing = (backing_t)k; found = 1; }
+            if (!found) { fprintf(stderr,"Unknown backing: %s\n", b); usage(argv[0]); return 1; }
+#ifndef __linux__
+            if (backing != BACKING_MALLOC) { fprintf(stderr,"--pages %s needs Linux mmap flags\n", b); return 1; }
+#endif
+        }
+        else if (strcmp(argv[i], "--order")==0 && i+1<argc) {
+            const char *o = argv[++i];
+            if (strcmp(o, "line")==0) order = CHASE_LINE;
+            else if (strcmp(o, "page")==0) order = CHASE_PAGE;
+            else if (strcmp(o, "stride")==0) order = CHASE_STRIDE;
+            else { fprintf(stderr,"Unknown order: %s\n", o); usage(argv[0]); return 1; }
+        }
         else { fprintf(stderr,"Unknown arg: %s\n", argv[i]); usage(argv[0]); return 1; }
     }
 
+    // only these modes write result records; anywhere else --results would
+    // silently leave the file empty
+    if (resultsPath && strcmp(mode,"pc")!=0 && strcmp(mode,"mlp")!=0 && strcmp(mode,"stream")!=0
+            && strcmp(mode,"kernels")!=0 && strcmp(mode,"saxpy")!=0) {
+        fprintf(stderr,"--results is supported in pc, mlp, stream, kernels and saxpy modes, not %s\n", mode);
+        return 1;
+    }
+
+    // host profile from autodetect: sizes past the last cache level (split
+    // across threads for the multi-threaded modes) and the real line size
+    if (strcmp(mode,"autodetect")!=0 && loadProfile(profilePath, &profile)==0) {
+        size_t llc = profile.cache_size[profile.levels - 1];
+        printf("#profile=%s,line=%zu,levels=%d,llc=%zu\n", profilePath, profile.line_size, profile.levels, llc);
+        if (!sizeSet) {
+            size = 4 * llc;
+            if ((strcmp(mode,"intensity")==0 || strcmp(mode,"loaded")==0) && maxthreads > 1) size = roundUp(size / (size_t)maxthreads, 4096);
+            if (size < (1u << 20)) size = 1u << 20;
+        }
+        if (!strideSet) stride = profile.line_size;
+    }
+
+    if (strcmp(mode,"pages")==0) useCounters = 1;
+    if (useCounters) {
+        perfCountersOpen(&counters, 1);
+        printf("#counters%s\n", perfCountersCsvHeader(&counters));
+    }
+
+    benchClockInit();
+    if (resultsPath && benchResultsOpen(&results, resultsPath) != 0) return 1;
+
+    if (backing != BACKING_MALLOC) printf("#pages=%s\n", backingNames[backing]);
     if (strcmp(mode,"pc")==0) {
         // choose a larger iters if small array to get enough samples
         uint64_t jumps = iters * 1000ull;
         if (size < 65536) jumps = iters * 100000ull;
-        benchmarkPointerChase(size, stride, jumps, repeats);
+        benchmarkPointerChase(size, stride, order, jumps, repeats);
+    } else if (strcmp(mode,"sweep")==0) {
+        if (!configPath) { fprintf(stderr,"sweep needs --config <file>\n"); usage(argv[0]); return 1; }
+        benchmarkSweep(configPath);
+    } else if (strcmp(mode,"autodetect")==0) {
+        benchmarkAutodetect(sizeSet ? size : 0, iters * 1000ull, repeats, profilePath);
+    } else if (strcmp(mode,"coherence")==0) {
+        benchmarkCoherence(iters * 1000ull, duration, maxthreads);
+    } else if (strcmp(mode,"loaded")==0) {
+        benchmarkLoadedLatency(size, stride, mix, iters * 1000ull, maxthreads);
+    } else if (strcmp(mode,"pages")==0) {
+        benchmarkPages(size, iters * 1000ull, repeats);
+    } else if (strcmp(mode,"mlp")==0) {
+        benchmarkMLP(size, stride, order, iters * 1000ull, repeats, maxchains);
     } else if (strcmp(mode,"stream")==0) {
         benchmarkStream(size, stride, mix, iters, repeats);
+    } else if (strcmp(mode,"kernels")==0) {
+        benchmarkStreamKernels(size, iters, repeats, prefetch);
     } else if (strcmp(mode,"saxpy")==0) {
         benchmarkSAXPY(size, iters, repeats);
     } else if (strcmp(mode,"intensity")==0) {
-        benchmark_intensity(size, stride, mix, iters, maxthreads);
+        benchmark_intensity(size, stride, mix, duration, maxthreads, pin, placement);
     } else {
         fprintf(stderr,"Unknown mode: %s\n", mode);
         usage(argv[0]);
         return 1;
     }
 
+    perfCountersClose(&counters);
+    benchResultsClose(&results);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+// Body of the STREAM-style kernels, included by StreamKernels.h once per
+// instruction set with these macros defined (and #undef'd again at the end):
+//   SK_ISA                         name suffix of the generated functions
+//   SK_ATTR                        target attribute for that set, may be empty
+//   SK_VEC, SK_W                   vector of doubles and its width
+//   SK_LOAD(p), SK_STORE(p, v)     aligned load and store
+//   SK_STREAM(p, v), SK_FENCE()    non-temporal store and the fence after it
+//   SK_SET1(x), SK_ADD(a, b), SK_MUL(a, b)
+// No include guard on purpose.
+
+#define SK_FN(name) SK_CAT(name, SK_ISA)
+
+// Regular or non-temporal store, resolved at compile time in every caller
+#define SK_PUT(p, v, nt) do { if(nt) SK_STREAM(p, v) ; else SK_STORE(p, v) ; } while(0)
+
+// One prefetch per cache line of the block pf doubles ahead of src
+#define SK_PREFETCH(src, i, pf) do { \
+    if(pf) for(size_t l = 0; l < STREAM_BLOCK; l += 8) __builtin_prefetch((src) + (i) + (pf) + l, 0, 3) ; \
+} while(0)
+
+// c = a
+SK_ATTR static inline __attribute__((always_inline)) void SK_FN(copyBody)(double *restrict a, double *restrict c, size_t n, size_t pf, const int nt){
+    size_t i = 0, end = n / STREAM_BLOCK * STREAM_BLOCK ;
+    for(; i < end; i += STREAM_BLOCK){
+        SK_PREFETCH(a, i, pf) ;
+        for(size_t k = 0; k < STREAM_BLOCK; k += SK_W) SK_PUT(c + i + k, SK_LOAD(a + i + k), nt) ;
+    }
+    for(; i < n; i++) c[i] = a[i] ;
+    if(nt) SK_FENCE() ;
+}
+
+// b = q * c
+SK_ATTR static inline __attribute__((always_inline)) void SK_FN(scaleBody)(double *restrict b, double *restrict c, size_t n, double q, size_t pf, const int nt){
+    SK_VEC vq = SK_SET1(q) ;
+    size_t i = 0, end = n / STREAM_BLOCK * STREAM_BLOCK ;
+    for(; i < end; i += STREAM_BLOCK){
+        SK_PREFETCH(c, i, pf) ;
+        for(size_t k = 0; k < STREAM_BLOCK; k += SK_W) SK_PUT(b + i + k, SK_MUL(vq, SK_LOAD(c + i + k)), nt) ;
+    }
+    for(; i < n; i++) b[i] = q * c[i] ;
+    if(nt) SK_FENCE() ;
+}
+
+// c = a + b
+SK_ATTR static inline __attribute__((always_inline)) void SK_FN(addBody)(double *restrict a, double *restrict b, double *restrict c, size_t n, size_t pf, const int nt){
+    size_t i = 0, end = n / STREAM_BLOCK * STREAM_BLOCK ;
+    for(; i < end; i += STREAM_BLOCK){
+        SK_PREFETCH(a, i, pf) ;
+        SK_PREFETCH(b, i, pf) ;
+        for(size_t k = 0; k < STREAM_BLOCK; k += SK_W) SK_PUT(c + i + k, SK_ADD(SK_LOAD(a + i + k), SK_LOAD(b + i + k)), nt) ;
+    }
+    for(; i < n; i++) c[i] = a[i] + b[i] ;
+    if(nt) SK_FENCE() ;
+}
+
+// a = b + q * c
+SK_ATTR static inline __attribute__((always_inline)) void SK_FN(triadBody)(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, const int nt){
+    SK_VEC vq = SK_SET1(q) ;
+    size_t i = 0, end = n / STREAM_BLOCK * STREAM_BLOCK ;
+    for(; i < end; i += STREAM_BLOCK){
+        SK_PREFETCH(b, i, pf) ;
+        SK_PREFETCH(c, i, pf) ;
+        for(size_t k = 0; k < STREAM_BLOCK; k += SK_W) SK_PUT(a + i + k, SK_ADD(SK_LOAD(b + i + k), SK_MUL(vq, SK_LOAD(c + i + k))), nt) ;
+    }
+    for(; i < n; i++) a[i] = b[i] + q * c[i] ;
+    if(nt) SK_FENCE() ;
+}
+
+// a = q
+SK_ATTR static inline __attribute__((always_inline)) void SK_FN(fillBody)(double *restrict a, size_t n, double q, const int nt){
+    SK_VEC vq = SK_SET1(q) ;
+    size_t i = 0, end = n / STREAM_BLOCK * STREAM_BLOCK ;
+    for(; i < end; i += STREAM_BLOCK){
+        for(size_t k = 0; k < STREAM_BLOCK; k += SK_W) SK_PUT(a + i + k, vq, nt) ;
+    }
+    for(; i < n; i++) a[i] = q ;
+    if(nt) SK_FENCE() ;
+}
+
+SK_ATTR static double SK_FN(copy)(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    (void)b ; (void)q ;
+    if(nt) SK_FN(copyBody)(a, c, n, pf, 1) ; else SK_FN(copyBody)(a, c, n, pf, 0) ;
+    return 0.0 ;
+}
+
+SK_ATTR static double SK_FN(scale)(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    (void)a ;
+    if(nt) SK_FN(scaleBody)(b, c, n, q, pf, 1) ; else SK_FN(scaleBody)(b, c, n, q, pf, 0) ;
+    return 0.0 ;
+}
+
+SK_ATTR static double SK_FN(add)(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    (void)q ;
+    if(nt) SK_FN(addBody)(a, b, c, n, pf, 1) ; else SK_FN(addBody)(a, b, c, n, pf, 0) ;
+    return 0.0 ;
+}
+
+SK_ATTR static double SK_FN(triad)(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    if(nt) SK_FN(triadBody)(a, b, c, n, q, pf, 1) ; else SK_FN(triadBody)(a, b, c, n, q, pf, 0) ;
+    return 0.0 ;
+}
+
+// Read-only: four independent accumulators so the add latency is hidden
+SK_ATTR static double SK_FN(sum)(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    (void)b ; (void)c ; (void)q ; (void)nt ;
+    SK_VEC acc0 = SK_SET1(0.0), acc1 = acc0, acc2 = acc0, acc3 = acc0 ;
+    size_t i = 0, end = n / STREAM_BLOCK * STREAM_BLOCK ;
+    for(; i < end; i += STREAM_BLOCK){
+        SK_PREFETCH(a, i, pf) ;
+        for(size_t k = 0; k < STREAM_BLOCK; k += 4 * SK_W){
+            acc0 = SK_ADD(acc0, SK_LOAD(a + i + k)) ;
+            acc1 = SK_ADD(acc1, SK_LOAD(a + i + k + SK_W)) ;
+            acc2 = SK_ADD(acc2, SK_LOAD(a + i + k + 2 * SK_W)) ;
+            acc3 = SK_ADD(acc3, SK_LOAD(a + i + k + 3 * SK_W)) ;
+        }
+    }
+    double lanes[SK_W] __attribute__((aligned(64))) ;
+    SK_STORE(lanes, SK_ADD(SK_ADD(acc0, acc1), SK_ADD(acc2, acc3))) ;
+    double s = 0.0 ;
+    for(int l = 0; l < SK_W; l++) s += lanes[l] ;
+    for(; i < n; i++) s += a[i] ;
+    return s ;
+}
+
+SK_ATTR static double SK_FN(fill)(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    (void)b ; (void)c ; (void)pf ;
+    if(nt) SK_FN(fillBody)(a, n, q, 1) ; else SK_FN(fillBody)(a, n, q, 0) ;
+    return 0.0 ;
+}
+
+#undef SK_FN
+#undef SK_PUT
+#undef SK_PREFETCH
+#undef SK_ISA
+#undef SK_ATTR
+#undef SK_VEC
+#undef SK_W
+#undef SK_LOAD
+#undef SK_STORE
+#undef SK_STREAM
+#undef SK_FENCE
+#undef SK_SET1
+#undef SK_ADD
+#undef SK_MUL
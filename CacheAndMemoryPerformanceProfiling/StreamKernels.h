@@ -0,0 +1,144 @@
+// STREAM-style bandwidth kernels for the "kernels" mode of Benchmark.c:
+// Copy, Scale, Add, Triad plus a read-only sum and a write-only fill, each
+// built once per instruction set (SSE2, AVX2, AVX-512 on x86; plain C that
+// the compiler vectorizes elsewhere) with a regular and a non-temporal store
+// path and an optional software-prefetch distance. The "libc" and "rep" sets
+// only provide copy (memcpy, rep movsb) and fill (memset, rep stosb) so bulk
+// copy paths can be compared against the hand-written loops.
+#ifndef STREAM_KERNELS_H
+#define STREAM_KERNELS_H
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define STREAM_X86 1
+#include <immintrin.h>
+#endif
+
+#define SK_CAT2(a, b) a##_##b
+#define SK_CAT(a, b) SK_CAT2(a, b)
+
+// Doubles per unrolled step: four 64-byte lines, one prefetch each
+#define STREAM_BLOCK 32
+
+typedef double (*stream_kernel_fn)(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt) ;
+
+enum { STREAM_COPY, STREAM_SCALE, STREAM_ADD, STREAM_TRIAD, STREAM_SUM, STREAM_FILL, STREAM_KERNEL_COUNT } ;
+
+static const char *const streamKernelNames[STREAM_KERNEL_COUNT] = {"copy", "scale", "add", "triad", "sum", "fill"} ;
+
+// Arrays read and written per element, for the bytes-moved accounting
+static const int streamKernelReads[STREAM_KERNEL_COUNT] = {1, 1, 2, 2, 1, 0} ;
+static const int streamKernelWrites[STREAM_KERNEL_COUNT] = {1, 1, 1, 1, 0, 1} ;
+
+#if STREAM_X86
+#define SK_ISA sse2
+#define SK_ATTR __attribute__((target("sse2")))
+#define SK_VEC __m128d
+#define SK_W 2
+#define SK_LOAD(p) _mm_load_pd(p)
+#define SK_STORE(p, v) _mm_store_pd(p, v)
+#define SK_STREAM(p, v) _mm_stream_pd(p, v)
+#define SK_FENCE() _mm_sfence()
+#define SK_SET1(x) _mm_set1_pd(x)
+#define SK_ADD(a, b) _mm_add_pd(a, b)
+#define SK_MUL(a, b) _mm_mul_pd(a, b)
+#include "StreamKernelBody.h"
+
+#define SK_ISA avx2
+#define SK_ATTR __attribute__((target("avx2")))
+#define SK_VEC __m256d
+#define SK_W 4
+#define SK_LOAD(p) _mm256_load_pd(p)
+#define SK_STORE(p, v) _mm256_store_pd(p, v)
+#define SK_STREAM(p, v) _mm256_stream_pd(p, v)
+#define SK_FENCE() _mm_sfence()
+#define SK_SET1(x) _mm256_set1_pd(x)
+#define SK_ADD(a, b) _mm256_add_pd(a, b)
+#define SK_MUL(a, b) _mm256_mul_pd(a, b)
+#include "StreamKernelBody.h"
+
+#define SK_ISA avx512
+#define SK_ATTR __attribute__((target("avx512f")))
+#define SK_VEC __m512d
+#define SK_W 8
+#define SK_LOAD(p) _mm512_load_pd(p)
+#define SK_STORE(p, v) _mm512_store_pd(p, v)
+#define SK_STREAM(p, v) _mm512_stream_pd(p, v)
+#define SK_FENCE() _mm_sfence()
+#define SK_SET1(x) _mm512_set1_pd(x)
+#define SK_ADD(a, b) _mm512_add_pd(a, b)
+#define SK_MUL(a, b) _mm512_mul_pd(a, b)
+#include "StreamKernelBody.h"
+
+static double copy_rep(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    (void)b ; (void)q ; (void)pf ; (void)nt ;
+    void *dst = c ;
+    const void *src = a ;
+    size_t bytes = n * sizeof(double) ;
+    __asm__ __volatile__("rep movsb" : "+D"(dst), "+S"(src), "+c"(bytes) : : "memory") ;
+    return 0.0 ;
+}
+
+// rep stosb stores a byte, so like memset it fills with zeros
+static double fill_rep(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    (void)b ; (void)c ; (void)q ; (void)pf ; (void)nt ;
+    void *dst = a ;
+    size_t bytes = n * sizeof(double) ;
+    __asm__ __volatile__("rep stosb" : "+D"(dst), "+c"(bytes) : "a"(0) : "memory") ;
+    return 0.0 ;
+}
+#else
+// No streaming-store intrinsic here; the non-temporal path is not offered
+#define SK_ISA scalar
+#define SK_ATTR
+#define SK_VEC double
+#define SK_W 1
+#define SK_LOAD(p) (*(p))
+#define SK_STORE(p, v) (*(p) = (v))
+#define SK_STREAM(p, v) (*(p) = (v))
+#define SK_FENCE() ((void)0)
+#define SK_SET1(x) (x)
+#define SK_ADD(a, b) ((a) + (b))
+#define SK_MUL(a, b) ((a) * (b))
+#include "StreamKernelBody.h"
+#endif
+
+static double copy_libc(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    (void)b ; (void)q ; (void)pf ; (void)nt ;
+    memcpy(c, a, n * sizeof(double)) ;
+    return 0.0 ;
+}
+
+static double fill_libc(double *restrict a, double *restrict b, double *restrict c, size_t n, double q, size_t pf, int nt){
+    (void)b ; (void)c ; (void)q ; (void)pf ; (void)nt ;
+    memset(a, 0, n * sizeof(double)) ;
+    return 0.0 ;
+}
+
+typedef struct {
+    const char *name ;
+    int nt ;                                    // has a non-temporal store path
+    int prefetch ;                              // honours the prefetch distance
+    stream_kernel_fn fn[STREAM_KERNEL_COUNT] ;  // NULL where the set has no such kernel
+} stream_isa_t ;
+
+#define SK_ALL(isa) {SK_CAT(copy, isa), SK_CAT(scale, isa), SK_CAT(add, isa), SK_CAT(triad, isa), SK_CAT(sum, isa), SK_CAT(fill, isa)}
+
+// Instruction sets this host can run, in table order; returns the count
+static int streamIsas(stream_isa_t *out){
+    int n = 0 ;
+    out[n++] = (stream_isa_t){"libc", 0, 0, {copy_libc, NULL, NULL, NULL, NULL, fill_libc}} ;
+#if STREAM_X86
+    out[n++] = (stream_isa_t){"rep", 0, 0, {copy_rep, NULL, NULL, NULL, NULL, fill_rep}} ;
+    out[n++] = (stream_isa_t){"sse2", 1, 1, SK_ALL(sse2)} ;
+    if(__builtin_cpu_supports("avx2")) out[n++] = (stream_isa_t){"avx2", 1, 1, SK_ALL(avx2)} ;
+    if(__builtin_cpu_supports("avx512f")) out[n++] = (stream_isa_t){"avx512", 1, 1, SK_ALL(avx512)} ;
+#else
+    out[n++] = (stream_isa_t){"scalar", 0, 1, SK_ALL(scalar)} ;
+#endif
+    return n ;
+}
+
+#endif
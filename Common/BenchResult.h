@@ -0,0 +1,295 @@
+// Shared clock and result records for the cache/memory, SIMD and storage
+// suites, in C so Benchmark.c and the C++ tests include the same file.
+//
+// Clock: the TSC (the virtual counter on AArch64) converted to ns with a
+// rate calibrated once against CLOCK_MONOTONIC. Reading it is a few cycles
+// instead of a vDSO call, and every suite times on the same scale. Hosts
+// without an invariant counter fall back to CLOCK_MONOTONIC itself.
+//
+// Results: one JSON object per line (--results <file>, appended, so several
+// runs or programs can share a file). Each names the benchmark, its
+// parameters, the unit and which direction is better, the raw per-repeat
+// samples rather than a summary, and a host fingerprint (CPU model, governor,
+// kernel, THP, clock) so a comparison can tell a regression from a different
+// machine. Common/compareResults.py tests one file against a baseline.
+//
+//   {"schema":"bench-result/1","benchmark":"memory.pointer_chase","unit":"ns_per_access",
+//    "better":"lower","params":{"size":65536,...},"samples":[1.21,1.19,...],"time":"...","host":{...}}
+//
+// A zeroed bench_results_t writes nothing, like a zeroed perf_counters_t.
+#ifndef BENCH_RESULT_H
+#define BENCH_RESULT_H
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// ---------------------- Clock ----------------------
+typedef struct {
+    int ready ;
+    int ticking ;           // ticks are usable; otherwise CLOCK_MONOTONIC
+    double nsPerTick ;
+    uint64_t tick0 ;
+    uint64_t ns0 ;
+} bench_clock_t ;
+
+static bench_clock_t benchClock ;
+
+static inline uint64_t benchMonotonicNs(void){
+    struct timespec ts ;
+    clock_gettime(CLOCK_MONOTONIC, &ts) ;
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec ;
+}
+
+// Raw hardware ticks: TSC on x86 (reference cycles, not core cycles under
+// turbo), cntvct_el0 on AArch64, 0 elsewhere
+static inline uint64_t benchTicks(void){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc() ;
+#elif defined(__aarch64__)
+    uint64_t v ;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(v)) ;
+    return v ;
+#else
+    return 0 ;
+#endif
+}
+
+// Only a counter that keeps one rate through P-states and deep C-states
+// (CPUID 80000007h EDX[8] on x86) can stand in for wall time
+static inline int benchTicksInvariant(void){
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned a, b, c, d ;
+    if(!__get_cpuid(0x80000007u, &a, &b, &c, &d)) return 0 ;
+    return (d >> 8) & 1 ;
+#elif defined(__aarch64__)
+    return 1 ;
+#else
+    return 0 ;
+#endif
+}
+
+// Tick and monotonic time read as close together as the host allows: the
+// tightest of a few bracketing pairs of clock_gettime calls
+static inline void benchClockPair(uint64_t *tick, uint64_t *ns){
+    uint64_t best = UINT64_MAX ;
+    for(int i = 0; i < 5; i++){
+        uint64_t n0 = benchMonotonicNs() ;
+        uint64_t t = benchTicks() ;
+        uint64_t n1 = benchMonotonicNs() ;
+        if(n1 - n0 < best){
+            best = n1 - n0 ;
+            *tick = t ;
+            *ns = n0 + (n1 - n0) / 2 ;
+        }
+    }
+}
+
+// Calibrates over 20 ms; benchClockNs() does this on first use, so call it
+// up front to keep those 20 ms out of the first measurement
+static inline void benchClockInit(void){
+    if(benchClock.ready) return ;
+    benchClock.ticking = 0 ;
+    if(benchTicksInvariant()){
+        uint64_t t0 = 0, n0 = 0, t1 = 0, n1 = 0 ;
+        benchClockPair(&t0, &n0) ;
+        while(benchMonotonicNs() - n0 < 20000000ull) {}
+        benchClockPair(&t1, &n1) ;
+        if(t1 > t0){
+            benchClock.ticking = 1 ;
+            benchClock.nsPerTick = (double)(n1 - n0) / (double)(t1 - t0) ;
+            benchClock.tick0 = t0 ;
+            benchClock.ns0 = n0 ;
+        }
+    }
+    benchClock.ready = 1 ;
+}
+
+static inline uint64_t benchClockNs(void){
+    if(!benchClock.ready) benchClockInit() ;
+    if(!benchClock.ticking) return benchMonotonicNs() ;
+    return benchClock.ns0 + (uint64_t)((double)(benchTicks() - benchClock.tick0) * benchClock.nsPerTick) ;
+}
+
+// Ticks per second, so tick deltas convert to time or reference cycles; 0
+// when the clock runs on CLOCK_MONOTONIC
+static inline double benchTickHz(void){
+    if(!benchClock.ready) benchClockInit() ;
+    return benchClock.ticking ? 1e9 / benchClock.nsPerTick : 0.0 ;
+}
+
+// ---------------------- Host fingerprint ----------------------
+typedef struct {
+    char cpu[128] ;
+    char governor[32] ;
+    char kernel[160] ;
+    char thp[16] ;
+    char hostname[72] ;
+    long cpus ;
+} bench_host_t ;
+
+// First line of a file, newline stripped; "" when unreadable
+static inline void benchReadLine(const char *path, char *buf, size_t len){
+    buf[0] = '\0' ;
+    FILE *f = fopen(path, "r") ;
+    if(!f) return ;
+    if(!fgets(buf, (int)len, f)) buf[0] = '\0' ;
+    fclose(f) ;
+    buf[strcspn(buf, "\n")] = '\0' ;
+}
+
+static inline void benchHostProbe(bench_host_t *h){
+    memset(h, 0, sizeof(*h)) ;
+    char line[512] ;
+    FILE *f = fopen("/proc/cpuinfo", "r") ;
+    if(f){
+        // "model name" on x86; AArch64 kernels only give the part number
+        while(fgets(line, sizeof(line), f)){
+            char *colon = strchr(line, ':') ;
+            if(!colon) continue ;
+            if(strncmp(line, "model name", 10) == 0 || (!h->cpu[0] && strncmp(line, "CPU part", 8) == 0)){
+                colon++ ;
+                while(*colon == ' ') colon++ ;
+                snprintf(h->cpu, sizeof(h->cpu), "%s", colon) ;
+                h->cpu[strcspn(h->cpu, "\n")] = '\0' ;
+                if(line[0] == 'm') break ;
+            }
+        }
+        fclose(f) ;
+    }
+    benchReadLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor", h->governor, sizeof(h->governor)) ;
+    // "always [madvise] never": keep the bracketed choice
+    benchReadLine("/sys/kernel/mm/transparent_hugepage/enabled", line, sizeof(line)) ;
+    char *lb = strchr(line, '[') ;
+    char *rb = lb ? strchr(lb, ']') : NULL ;
+    if(rb){
+        *rb = '\0' ;
+        snprintf(h->thp, sizeof(h->thp), "%s", lb + 1) ;
+    }
+    struct utsname u ;
+    if(uname(&u) == 0){
+        snprintf(h->kernel, sizeof(h->kernel), "%s %s", u.sysname, u.release) ;
+        snprintf(h->hostname, sizeof(h->hostname), "%s", u.nodename) ;
+    }
+    h->cpus = sysconf(_SC_NPROCESSORS_ONLN) ;
+}
+
+// ---------------------- Result records ----------------------
+typedef struct {
+    FILE *file ;
+    bench_host_t host ;
+    int params ;            // written to the open record so far
+    int samples ;           // -1 until the params object is closed
+} bench_results_t ;
+
+static inline void benchJsonString(FILE *f, const char *s){
+    fputc('"', f) ;
+    for(; *s; s++){
+        unsigned char c = (unsigned char)*s ;
+        if(c == '"' || c == '\\') fprintf(f, "\\%c", c) ;
+        else if(c < 0x20) fprintf(f, "\\u%04x", c) ;
+        else fputc(c, f) ;
+    }
+    fputc('"', f) ;
+}
+
+static inline void benchJsonNumber(FILE *f, double v){
+    if(isfinite(v)) fprintf(f, "%.10g", v) ;
+    else fputs("null", f) ;
+}
+
+// Appends to path; returns 0, or -1 with a message when it cannot be opened
+static inline int benchResultsOpen(bench_results_t *r, const char *path){
+    memset(r, 0, sizeof(*r)) ;
+    r->file = fopen(path, "a") ;
+    if(!r->file){
+        fprintf(stderr, "cannot write %s: %s\n", path, strerror(errno)) ;
+        return -1 ;
+    }
+    benchHostProbe(&r->host) ;
+    benchClockInit() ;
+    return 0 ;
+}
+
+static inline void benchResultsClose(bench_results_t *r){
+    if(r->file) fclose(r->file) ;
+    r->file = NULL ;
+}
+
+// Starts a record. benchmark is "<suite>.<test>" (memory.stream,
+// simd.saxpy, storage.randread_4k_qd1); lowerIsBetter says which way a
+// change is a regression.
+static inline void benchResultBegin(bench_results_t *r, const char *benchmark, const char *unit, int lowerIsBetter){
+    if(!r->file) return ;
+    fputs("{\"schema\":\"bench-result/1\",\"benchmark\":", r->file) ;
+    benchJsonString(r->file, benchmark) ;
+    fputs(",\"unit\":", r->file) ;
+    benchJsonString(r->file, unit) ;
+    fprintf(r->file, ",\"better\":\"%s\",\"params\":{", lowerIsBetter ? "lower" : "higher") ;
+    r->params = 0 ;
+    r->samples = -1 ;
+}
+
+static inline void benchResultParam(bench_results_t *r, const char *key, const char *value){
+    if(!r->file || r->samples >= 0) return ;
+    if(r->params++) fputc(',', r->file) ;
+    benchJsonString(r->file, key) ;
+    fputc(':', r->file) ;
+    benchJsonString(r->file, value) ;
+}
+
+static inline void benchResultParamNum(bench_results_t *r, const char *key, double value){
+    if(!r->file || r->samples >= 0) return ;
+    if(r->params++) fputc(',', r->file) ;
+    benchJsonString(r->file, key) ;
+    fputc(':', r->file) ;
+    benchJsonNumber(r->file, value) ;
+}
+
+// Parameters must all come before the first sample
+static inline void benchResultSample(bench_results_t *r, double v){
+    if(!r->file) return ;
+    if(r->samples < 0){
+        fputs("},\"samples\":[", r->file) ;
+        r->samples = 0 ;
+    }
+    if(r->samples++) fputc(',', r->file) ;
+    benchJsonNumber(r->file, v) ;
+}
+
+static inline void benchResultEnd(bench_results_t *r){
+    if(!r->file) return ;
+    if(r->samples < 0) fputs("},\"samples\":[", r->file) ;
+    char stamp[32] ;
+    time_t now = time(NULL) ;
+    struct tm utc ;
+    gmtime_r(&now, &utc) ;
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &utc) ;
+    fprintf(r->file, "],\"time\":\"%s\",\"host\":{\"cpu\":", stamp) ;
+    benchJsonString(r->file, r->host.cpu) ;
+    fputs(",\"governor\":", r->file) ;
+    benchJsonString(r->file, r->host.governor) ;
+    fputs(",\"kernel\":", r->file) ;
+    benchJsonString(r->file, r->host.kernel) ;
+    fputs(",\"thp\":", r->file) ;
+    benchJsonString(r->file, r->host.thp) ;
+    fputs(",\"hostname\":", r->file) ;
+    benchJsonString(r->file, r->host.hostname) ;
+    fprintf(r->file, ",\"cpus\":%ld,\"clock\":\"%s\",\"tick_hz\":", r->host.cpus, benchClock.ticking ? "tsc" : "monotonic") ;
+    benchJsonNumber(r->file, benchTickHz()) ;
+    fputs("}}\n", r->file) ;
+    fflush(r->file) ;
+    r->samples = -1 ;
+}
+
+#endif
@@ -0,0 +1,180 @@
+// Optional hardware performance counters via perf_event_open(2), shared by
+// the C cache/memory benchmark and the C++ SIMD tests.
+//
+// Every counter is opened on its own rather than as a group so an event the
+// PMU (or a VM/container) does not expose only blanks its own column. Counts
+// are user-space only, which works under the default perf_event_paranoid=2,
+// and are scaled by time_enabled/time_running when the kernel multiplexes.
+// Anywhere perf_event_open is missing or refused, including non-Linux hosts,
+// every column is simply left empty.
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum {
+    PC_CYCLES,
+    PC_INSTRUCTIONS,
+    PC_L1D_MISSES,
+    PC_LLC_MISSES,
+    PC_DTLB_MISSES,
+    PC_STALL_CYCLES,
+    PC_COUNT
+} ;
+
+static const char *const perfCounterNames[PC_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "stall_cycles"
+} ;
+
+typedef struct {
+    int enabled ;               // collection requested; a zeroed struct is a no-op
+    int fd[PC_COUNT] ;          // -1 when that event is unavailable
+    int valid[PC_COUNT] ;       // last stop produced a usable value
+    double value[PC_COUNT] ;    // last start..stop delta, multiplex-scaled
+    uint64_t base[PC_COUNT][3] ;    // value, time_enabled, time_running at start
+} perf_counters_t ;
+
+#ifdef __linux__
+static inline int perfOpenEvent(uint32_t type, uint64_t config, int tid, int inherit){
+    struct perf_event_attr attr ;
+    memset(&attr, 0, sizeof(attr)) ;
+    attr.size = sizeof(attr) ;
+    attr.type = type ;
+    attr.config = config ;
+    attr.disabled = 1 ;
+    attr.inherit = inherit ? 1 : 0 ;
+    attr.exclude_kernel = 1 ;
+    attr.exclude_hv = 1 ;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING ;
+    return (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0) ;
+}
+
+static inline uint64_t perfCacheConfig(uint64_t cache, uint64_t op, uint64_t result){
+    return cache | (op << 8) | (result << 16) ;
+}
+#endif
+
+// Open every counter for thread tid (0: the calling thread). With inherit
+// set, threads it creates afterwards are counted too once they have exited
+// (joined); long-lived workers need counters of their own instead.
+static inline void perfCountersOpenThread(perf_counters_t *pc, int tid, int inherit){
+    memset(pc, 0, sizeof(*pc)) ;
+    for(int i = 0; i < PC_COUNT; i++) pc->fd[i] = -1 ;
+#ifdef __linux__
+    pc->fd[PC_CYCLES] = perfOpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, tid, inherit) ;
+    pc->fd[PC_INSTRUCTIONS] = perfOpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, tid, inherit) ;
+    pc->fd[PC_L1D_MISSES] = perfOpenEvent(PERF_TYPE_HW_CACHE,
+        perfCacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), tid, inherit) ;
+    pc->fd[PC_LLC_MISSES] = perfOpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, tid, inherit) ;
+    pc->fd[PC_DTLB_MISSES] = perfOpenEvent(PERF_TYPE_HW_CACHE,
+        perfCacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), tid, inherit) ;
+    // Backend stalls where the PMU maps them, frontend stalls otherwise
+    pc->fd[PC_STALL_CYCLES] = perfOpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND, tid, inherit) ;
+    if(pc->fd[PC_STALL_CYCLES] < 0){
+        pc->fd[PC_STALL_CYCLES] = perfOpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND, tid, inherit) ;
+    }
+    int opened = 0 ;
+    for(int i = 0; i < PC_COUNT; i++) opened += pc->fd[i] >= 0 ;
+    pc->enabled = 1 ;
+    if(!opened){
+        fprintf(stderr, "perf counters unavailable (%s); counter columns left empty\n", strerror(errno)) ;
+    }
+#else
+    (void)tid ;
+    (void)inherit ;
+    pc->enabled = 1 ;
+    fprintf(stderr, "perf counters need Linux perf_event_open; counter columns left empty\n") ;
+#endif
+}
+
+static inline void perfCountersOpen(perf_counters_t *pc, int inherit){
+    perfCountersOpenThread(pc, 0, inherit) ;
+}
+
+// Stop reports the difference from a read taken here rather than trusting
+// the reset: counts of inherited threads folded in when they exit survive
+// PERF_EVENT_IOC_RESET, as do the enabled/running times
+static inline void perfCountersStart(perf_counters_t *pc){
+    if(!pc->enabled) return ;
+#ifdef __linux__
+    for(int i = 0; i < PC_COUNT; i++){
+        if(pc->fd[i] < 0) continue ;
+        ioctl(pc->fd[i], PERF_EVENT_IOC_RESET, 0) ;
+        if(read(pc->fd[i], pc->base[i], sizeof(pc->base[i])) != (ssize_t)sizeof(pc->base[i])) memset(pc->base[i], 0, sizeof(pc->base[i])) ;
+        ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0) ;
+    }
+#else
+    (void)pc ;
+#endif
+}
+
+static inline void perfCountersStop(perf_counters_t *pc){
+    for(int i = 0; i < PC_COUNT; i++){
+        pc->valid[i] = 0 ;
+        pc->value[i] = 0.0 ;
+    }
+    if(!pc->enabled) return ;
+#ifdef __linux__
+    for(int i = 0; i < PC_COUNT; i++){
+        if(pc->fd[i] < 0) continue ;
+        ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0) ;
+    }
+    for(int i = 0; i < PC_COUNT; i++){
+        uint64_t buf[3] ;   // value, time_enabled, time_running
+        if(pc->fd[i] < 0) continue ;
+        if(read(pc->fd[i], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) continue ;
+        for(int k = 0; k < 3; k++) buf[k] -= pc->base[i][k] ;
+        if(buf[2] == 0) continue ;
+        pc->value[i] = buf[2] < buf[1] ? (double)buf[0] * (double)buf[1] / (double)buf[2] : (double)buf[0] ;
+        pc->valid[i] = 1 ;
+    }
+#endif
+}
+
+static inline void perfCountersClose(perf_counters_t *pc){
+    if(!pc->enabled) return ;
+#ifdef __linux__
+    for(int i = 0; i < PC_COUNT; i++){
+        if(pc->fd[i] >= 0) close(pc->fd[i]) ;
+        pc->fd[i] = -1 ;
+    }
+#endif
+    pc->enabled = 0 ;
+}
+
+// ",cycles,instructions,..." to extend a CSV header; empty when disabled
+static inline const char *perfCountersCsvHeader(const perf_counters_t *pc){
+    return pc->enabled ? ",cycles,instructions,l1d_misses,llc_misses,dtlb_misses,stall_cycles" : "" ;
+}
+
+// Last deltas divided by scale (1 for totals, calls or elements for rates)
+// as extra CSV columns: ",v,v,..." with empty fields for missing events, or
+// ",name=v,..." when withKeys is set. Empty string when disabled.
+static inline const char *perfCountersCsv(const perf_counters_t *pc, double scale, int withKeys, char *buf, size_t len){
+    size_t used = 0 ;
+    buf[0] = '\0' ;
+    if(!pc->enabled) return buf ;
+    if(scale <= 0.0) scale = 1.0 ;
+    for(int i = 0; i < PC_COUNT && used < len; i++){
+        int n ;
+        if(withKeys && pc->valid[i]) n = snprintf(buf + used, len - used, ",%s=%.10g", perfCounterNames[i], pc->value[i] / scale) ;
+        else if(withKeys) n = snprintf(buf + used, len - used, ",%s=", perfCounterNames[i]) ;
+        else if(pc->valid[i]) n = snprintf(buf + used, len - used, ",%.10g", pc->value[i] / scale) ;
+        else n = snprintf(buf + used, len - used, ",") ;
+        if(n < 0) break ;
+        used += (size_t)n ;
+    }
+    return buf ;
+}
+
+#endif
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+# Compares a run against a baseline, both in the shared result schema of
+# Common/BenchResult.h (one JSON record per line, written by --results in
+# Benchmark.c, the SIMD tests and StorageBench).
+#
+# Records are matched on benchmark + params; records repeated in one file
+# pool their samples. Each pair gets a one-sided Mann-Whitney U test in the
+# record's "worse" direction, so nothing is assumed about the shape of the
+# distribution and a few outlier repeats cannot fake or hide a shift. A
+# benchmark is flagged only when the shift is both significant (p < alpha)
+# and larger than the threshold on the medians, so noise on a quiet host and
+# real-but-negligible shifts both stay quiet. Host fingerprints that differ
+# (CPU, governor, kernel, THP, clock) are reported, since then a "regression"
+# may just be a different machine.
+#
+# Usage: python3 compareResults.py baseline.jsonl new.jsonl [--threshold PCT] [--alpha P]
+# Exit status: 0 clean, 1 at least one regression, 2 bad input.
+import argparse, json, math, sys
+
+HOST_KEYS = ("cpu", "governor", "kernel", "thp", "clock")
+
+
+def load(path):
+    runs, hosts = {}, {}
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                rec = json.loads(line)
+            except ValueError as e:
+                sys.exit("%s:%d: %s" % (path, n, e))
+            key = (rec["benchmark"], json.dumps(rec.get("params", {}), sort_keys=True))
+            entry = runs.setdefault(key, {"unit": rec.get("unit", ""), "better": rec.get("better", "lower"), "samples": []})
+            entry["samples"] += [s for s in rec.get("samples", []) if s is not None]
+            host = rec.get("host", {})
+            hosts[tuple(host.get(k, "") for k in HOST_KEYS)] = host
+    return runs, hosts
+
+
+def median(xs):
+    s = sorted(xs)
+    m = len(s) // 2
+    return s[m] if len(s) % 2 else 0.5 * (s[m - 1] + s[m])
+
+
+def exact_upper_tail(u, n1, n2):
+    """P(U >= u) under H0 with no ties, counting orderings of the values."""
+    top = n1 * n2
+    # f[j][k]: orderings of i x's and j y's with k (x > y) pairs, built over i;
+    # the largest value is either an x, beating all j y's, or a y
+    f = [[1] + [0] * top for _ in range(n2 + 1)]
+    for i in range(1, n1 + 1):
+        g = [[0] * (top + 1) for _ in range(n2 + 1)]
+        for j in range(n2 + 1):
+            for k in range(top + 1):
+                g[j][k] = (f[j][k - j] if k >= j else 0) + (g[j - 1][k] if j else 0)
+        f = g
+    return sum(f[n2][int(math.ceil(u - 1e-9)):]) / float(sum(f[n2]))
+
+
+def mann_whitney_greater(x, y):
+    """One-sided p-value that x tends to be larger than y."""
+    n1, n2 = len(x), len(y)
+    u = 0.0
+    for a in x:
+        for b in y:
+            u += 1.0 if a > b else 0.5 if a == b else 0.0
+    tied = len(set(x) | set(y)) < n1 + n2
+    if not tied and n1 * n2 <= 900:
+        return exact_upper_tail(u, n1, n2)
+    # normal approximation with tie and continuity corrections
+    pooled = sorted(x + y)
+    n = n1 + n2
+    ties = 0.0
+    i = 0
+    while i < n:
+        j = i
+        while j < n and pooled[j] == pooled[i]:
+            j += 1
+        t = j - i
+        ties += t ** 3 - t
+        i = j
+    var = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1)))
+    if var <= 0:
+        return 1.0
+    z = (u - n1 * n2 / 2.0 - 0.5) / math.sqrt(var)
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+def min_p(n1, n2):
+    """Smallest one-sided p the test can reach with these sample counts."""
+    return 1.0 / math.comb(n1 + n2, n1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Flag benchmark regressions against a baseline")
+    ap.add_argument("baseline")
+    ap.add_argument("new")
+    ap.add_argument("--threshold", type=float, default=5.0, help="minimum median change to flag, percent (default 5)")
+    ap.add_argument("--alpha", type=float, default=0.01, help="significance level of the one-sided test (default 0.01)")
+    ap.add_argument("--all", action="store_true", help="list unchanged benchmarks too")
+    args = ap.parse_args()
+
+    base, base_hosts = load(args.baseline)
+    new, new_hosts = load(args.new)
+    if not base or not new:
+        print("no records in %s" % (args.baseline if not base else args.new))
+        return 2
+    for h in set(new_hosts) - set(base_hosts):
+        print("warning: host differs from baseline:", ", ".join("%s=%s" % (k, v) for k, v in zip(HOST_KEYS, h)))
+
+    regressions = 0
+    print("%-10s %-34s %-48s %14s %14s %9s %9s" % ("status", "benchmark", "params", "base_median", "new_median", "change%", "p"))
+    for key in sorted(set(base) | set(new)):
+        bench, params = key
+        label = ",".join("%s=%s" % kv for kv in json.loads(params).items())
+        if key not in new or key not in base:
+            print("%-10s %-34s %s" % ("missing" if key not in new else "new", bench, label))
+            continue
+        b, n = base[key]["samples"], new[key]["samples"]
+        if len(b) < 2 or len(n) < 2:
+            print("%-10s %-34s %s" % ("few", bench, label))
+            continue
+        lower = new[key]["better"] == "lower"
+        mb, mn = median(b), median(n)
+        change = (mn - mb) / mb * 100.0 if mb else float("inf")
+        worse = change if lower else -change
+        # test in the worse direction, and the better one for improvements
+        p_worse = mann_whitney_greater(n, b) if lower else mann_whitney_greater(b, n)
+        p_better = mann_whitney_greater(b, n) if lower else mann_whitney_greater(n, b)
+        if min_p(len(b), len(n)) >= args.alpha and abs(worse) > args.threshold:
+            # too few samples for any p below alpha: shown, never flagged
+            status, p = "underpower", p_worse
+        elif p_worse < args.alpha and worse > args.threshold:
+            status, p = "REGRESSION", p_worse
+            regressions += 1
+        elif p_better < args.alpha and -worse > args.threshold:
+            status, p = "improved", p_better
+        else:
+            status, p = "ok", min(p_worse, p_better)
+        if status == "ok" and not args.all:
+            continue
+        print("%-10s %-34s %-48s %14.6g %14.6g %+9.2f %9.2g" % (status, bench, label, mb, mn, change, p))
+    print("%d regression(s) beyond %.1f%% at alpha %g over %d benchmarks" % (regressions, args.threshold, args.alpha, len(set(base) & set(new))))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
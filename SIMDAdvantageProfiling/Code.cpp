@@ -1,38 +1,56 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <random>
 #include <functional>
 #include <cmath>
-
-// Timing
-double timeit(std::function<void()> f, int repeats=5){
-	double best = 1e9;
-	for(int i = 0; i<repeats;i++){
-		auto start = std::chrono::high_resolution_clock::now();
-		f();
-		auto end = std::chrono::high_resolution_clock::now();
-		double ms = std::chrono::duration<double, std::milli>(end-start).count();
-		if(ms < best) best = ms ;
-	}
-	return best/1000.0 ;
-}
+#include <cstring>
+#include <string>
+
+#include "Expr.h"
+#include "Gather.h"
+#include "Gemm.h"
+#include "Harness.h"
+#include "LowPrecision.h"
+#include "Reduction.h"
+#include "SimdKernels.h"
+#include "ThreadPool.h"
+
+// Timing: one harness for every test so --format/--cold/--samples apply
+// everywhere, and every test emits its results as records.
+static Harness harness ;
 
 // Data Type Comparison Scalar
+// StorageTraits widens narrow storage (fp16/bf16/int8) to its accumulation
+// type; for float and double it is the identity.
 template <typename T>
-void saxpy_dataTyped_scalar(T a, const T* x, T* y, size_t N){
+void saxpy_dataTyped_scalar(typename StorageTraits<T>::Acc a, const T* x, T* y, size_t N){
+	typedef StorageTraits<T> S ;
 	for(size_t i = 0; i < N; i++){
-		y[i] = a * x[i] + y[i] ;
+		y[i] = S::store(a * S::load(x[i]) + S::load(y[i])) ;
 	}
 }
 
 // Data Type Comparison Vector
 template <typename T>
-void saxpy_dataTyped_vector(T a, const T* x, T* y, size_t N){
+void saxpy_dataTyped_vector(typename StorageTraits<T>::Acc a, const T* x, T* y, size_t N){
+	typedef StorageTraits<T> S ;
 	#pragma omp simd
 	for(size_t i = 0; i < N; i++){
-		y[i] = a * x[i] + y[i] ;
+		y[i] = S::store(a * S::load(x[i]) + S::load(y[i])) ;
+	}
+}
+
+// Data Type Comparison Dot Scalar (mixed precision: accumulate in Acc)
+template <typename T>
+typename StorageTraits<T>::Acc dot_dataTyped_scalar(const T* x, const T* y, size_t N){
+	typedef StorageTraits<T> S ;
+	typename S::Acc sum = 0 ;
+	for(size_t i = 0; i < N; i++){
+		sum += S::load(x[i]) * S::load(y[i]) ;
 	}
+	return sum ;
 }
 
 // Strided
@@ -91,6 +109,14 @@ float dot_vectorized(const float* x, const float* y, size_t N){
 	return sum ;
 }
 
+// Scalar and vectorized runs of one kernel on the same params; the vector
+// record also carries its speedup over scalar
+void recordPair(const char* test, const char* kernel, const Fields& params, double flops, const TimingStats& scalar, const TimingStats& vector){
+	harness.record(test, std::string(kernel) + "_scalar", params, scalar, {Field("gflops", flops / (scalar.median * 1e9))}) ;
+	harness.record(test, std::string(kernel) + "_vector", params, vector,
+			{Field("gflops", flops / (vector.median * 1e9)), Field("speedup", scalar.median / vector.median)}) ;
+}
+
 // Speedup and GFLOP analysis
 void test1(size_t N){
 	std::vector<float> x(N), y(N), result(N) ;
@@ -104,35 +130,22 @@ void test1(size_t N){
 	}
 
 	// SAXPY timing
-	double sax_scalar = timeit([&](){saxpy_scalar(2.0f, x.data(), y.data(), N); }) ;
-	double sax_vector = timeit([&](){saxpy_vectorized(2.0f, x.data(), y.data(), N); }) ;
-
-	double sax_flops = 2.0 * N;
-	double sax_scalar_gflops = sax_flops / (sax_scalar * 1e9) ;
-	double sax_vector_gflops = sax_flops / (sax_vector * 1e9) ;
-
-	std::cout << std::to_string(sax_scalar/sax_vector) << "x     " ;
-	std::cout << std::to_string(sax_scalar_gflops) << " " ;
-	std::cout << std::to_string(sax_vector_gflops) << " " ;
+	TimingStats sax_scalar = harness.measure([&](){saxpy_scalar(2.0f, x.data(), y.data(), N); }) ;
+	TimingStats sax_vector = harness.measure([&](){saxpy_vectorized(2.0f, x.data(), y.data(), N); }) ;
+	recordPair("speedup", "saxpy", {Field("N", N)}, 2.0 * N, sax_scalar, sax_vector) ;
 
 	//randomize data again
 	for(size_t i = 0; i < N; i++){
 		x[i] = dist(engine) ;
 		y[i] = dist(engine) ;
 	}
-	
-	// DOT multiply timing
-	double DOT_scalar = timeit([&](){dot_scalar(x.data(), y.data(), N); }) ;
-	double DOT_vector = timeit([&](){dot_vectorized(x.data(), y.data(), N); }) ;
-
-	double DOT_flops = 2.0 * N;
-	double DOT_scalar_gflops = DOT_flops / (DOT_scalar * 1e9) ;
-	double DOT_vector_gflops = DOT_flops / (DOT_vector * 1e9) ;
-	
-	std::cout << std::to_string(DOT_scalar/DOT_vector) << "x         " ;
-	std::cout << std::to_string(DOT_scalar_gflops) << "     " ;
-	std::cout << std::to_string(DOT_vector_gflops) << " " ;
 
+	// DOT multiply timing
+	volatile float sink = 0.0f ;
+	TimingStats DOT_scalar = harness.measure([&](){sink = dot_scalar(x.data(), y.data(), N); }) ;
+	TimingStats DOT_vector = harness.measure([&](){sink = dot_vectorized(x.data(), y.data(), N); }) ;
+	(void)sink ;
+	recordPair("speedup", "dot", {Field("N", N)}, 2.0 * N, DOT_scalar, DOT_vector) ;
 
 	//randomize data again
 	for(size_t i = 0; i < N; i++){
@@ -141,204 +154,805 @@ void test1(size_t N){
 	}
 
 	// Elementwise Multiply timing
-	double ELEMENT_scalar = timeit([&](){element_scalar(x.data(), y.data(), result.data(), N); }) ;
-	double ELEMENT_vector = timeit([&](){element_vectorized(x.data(), y.data(), result.data(), N); }) ;
-
-	double ELEMENT_flops = 1.0 * N;
-	double ELEMENT_scalar_gflops = ELEMENT_flops / (ELEMENT_scalar * 1e9) ;
-	double ELEMENT_vector_gflops = ELEMENT_flops / (ELEMENT_vector * 1e9) ;
-
-	std::cout << std::to_string(ELEMENT_scalar/ELEMENT_vector) << "x " ;
-	std::cout << std::to_string(ELEMENT_scalar_gflops) << " " ;
-	std::cout << std::to_string(ELEMENT_vector_gflops) << " \n" ;
+	TimingStats ELEMENT_scalar = harness.measure([&](){element_scalar(x.data(), y.data(), result.data(), N); }) ;
+	TimingStats ELEMENT_vector = harness.measure([&](){element_vectorized(x.data(), y.data(), result.data(), N); }) ;
+	recordPair("speedup", "element", {Field("N", N)}, 1.0 * N, ELEMENT_scalar, ELEMENT_vector) ;
 }
 
-// Alignment Analysis
+// Alignment Analysis: page-aligned buffers, the same buffers shifted by one
+// float so no vector load is aligned, and a run over twice as many elements
 void test2(){
 	size_t N = 1e7 ;
-	size_t N2 = 1e7+1;
 	size_t N3 = 2e7 ;
-	std::vector<float> x(N), y(N), result(N) ;
+	struct Layout { const char* name ; size_t offset ; size_t n ; } ;
+	const Layout layouts[] = {{"aligned", 0, N}, {"misaligned", 1, N}, {"multiples", 0, N3}} ;
+
+	float* xbuf = allocFloats(N3 + 1) ;
+	float* ybuf = allocFloats(N3 + 1) ;
+	float* rbuf = allocFloats(N3 + 1) ;
+	if(!xbuf || !ybuf || !rbuf){
+		std::cerr << "alloc failed for N=" << N3 << "\n" ;
+		free(xbuf) ; free(ybuf) ; free(rbuf) ;
+		return ;
+	}
 
-	//randomize data
 	std::default_random_engine engine(42) ;
 	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
-	for(size_t i = 0; i < N; i++){
-		x[i] = dist(engine) ;
-		y[i] = dist(engine) ;
+	volatile float sink = 0.0f ;
+	for(const Layout& l : layouts){
+		float* x = xbuf + l.offset ;
+		float* y = ybuf + l.offset ;
+		float* result = rbuf + l.offset ;
+		size_t n = l.n ;
+		Fields params = {Field("layout", l.name), Field("N", n), Field("offset_bytes", l.offset * sizeof(float))} ;
+
+		//randomize data
+		for(size_t i = 0; i < n; i++){
+			x[i] = dist(engine) ;
+			y[i] = dist(engine) ;
+		}
+		TimingStats sax_scalar = harness.measure([&](){saxpy_scalar(2.0f, x, y, n); }) ;
+		TimingStats sax_vector = harness.measure([&](){saxpy_vectorized(2.0f, x, y, n); }) ;
+		recordPair("alignment", "saxpy", params, 2.0 * n, sax_scalar, sax_vector) ;
+
+		TimingStats DOT_scalar = harness.measure([&](){sink = dot_scalar(x, y, n); }) ;
+		TimingStats DOT_vector = harness.measure([&](){sink = dot_vectorized(x, y, n); }) ;
+		recordPair("alignment", "dot", params, 2.0 * n, DOT_scalar, DOT_vector) ;
+
+		TimingStats ELEMENT_scalar = harness.measure([&](){element_scalar(x, y, result, n); }) ;
+		TimingStats ELEMENT_vector = harness.measure([&](){element_vectorized(x, y, result, n); }) ;
+		recordPair("alignment", "element", params, 1.0 * n, ELEMENT_scalar, ELEMENT_vector) ;
 	}
-	std::cout<< "SAXPY  " ;
-	// Aligned
-	double sax_scalar = timeit([&](){saxpy_scalar(2.0f, x.data(), y.data(), N); }) ;
-	double sax_vector = timeit([&](){saxpy_vectorized(2.0f, x.data(), y.data(), N); }) ;
-	std::cout << std::to_string(sax_scalar) << "  " << std::to_string(sax_vector) << "  " ;
+	(void)sink ;
+	free(xbuf) ; free(ybuf) ; free(rbuf) ;
+}
+
+// Stride/Gather Effects using only SAXPY
+void test3(){
+	size_t N = 1<<20 ;
+	std::vector<float> x(N), y(N) ;
 
-	// Misaligned
+	// Random Values
+	std::default_random_engine engine(42) ;
+	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
 	for(size_t i = 0; i < N; i++){
 		x[i] = dist(engine) ;
-	}	
-	for(size_t i = 0; i < N2; i++){
 		y[i] = dist(engine) ;
 	}
-	sax_scalar = timeit([&](){saxpy_scalar(2.0f, x.data(), y.data(), N); }) ;
-	sax_vector = timeit([&](){saxpy_vectorized(2.0f, x.data(), y.data(), N); }) ;
-	std::cout << std::to_string(sax_scalar) << "  " << std::to_string(sax_vector) << "  " ;
 
-	// Multiples
-	for(size_t i = 0; i < N; i++){
-		x[i] = dist(engine) ;
-	}	
-	for(size_t i = 0; i < N3; i++){
-		y[i] = dist(engine) ;
+	// Stride values and computation
+	std::vector<size_t> strides = {1, 2, 4, 8, 16, 32, 64} ;
+	for(auto stride : strides){
+		TimingStats time = harness.measure([&](){saxpy_strided(2.0, x.data(), y.data(), N, stride);}) ;
+
+		// FLOPs
+		double flops = 2.0 * (N / stride) ;
+		harness.record("stride", "saxpy_strided", {Field("N", N), Field("stride", stride)}, time,
+				{Field("gflops", flops / (time.median * 1e9))}) ;
 	}
-	sax_scalar = timeit([&](){saxpy_scalar(2.0f, x.data(), y.data(), N); }) ;
-	sax_vector = timeit([&](){saxpy_vectorized(2.0f, x.data(), y.data(), N); }) ;
-	std::cout << std::to_string(sax_scalar) << "  " << std::to_string(sax_vector) << "  \n" ;
 
+}
 
-	//randomize data
+// Data Type Comparison for one storage type: compiler scalar and vector
+// loops, the hand-written SIMD path, and mixed-precision dot. int8 rates
+// are integer GOP/s; gbps counts the bytes one SIMD SAXPY moves.
+template <typename T>
+void testDataType(const char* name, size_t N, typename StorageTraits<T>::Acc a){
+	typedef StorageTraits<T> S ;
+	std::vector<T> x(N), y(N) ;
+	std::default_random_engine engine(42) ;
+	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
 	for(size_t i = 0; i < N; i++){
-		x[i] = dist(engine) ;
-		y[i] = dist(engine) ;
+		// int8 gets small signed integers so SAXPY does not saturate at once
+		float scale = sizeof(T) == 1 ? 16.0f : 1.0f ;
+		float offset = sizeof(T) == 1 ? 8.0f : 0.0f ;
+		x[i] = S::store((typename S::Acc)(dist(engine) * scale - offset)) ;
+		y[i] = S::store((typename S::Acc)(dist(engine) * scale - offset)) ;
 	}
-	std::cout<< "DOT  " ;
-	// Aligned
-	double DOT_scalar = timeit([&](){dot_scalar(x.data(), y.data(), N); }) ;
-	double DOT_vector = timeit([&](){dot_vectorized(x.data(), y.data(), N); }) ;
-	std::cout << std::to_string(DOT_scalar) << "  " << std::to_string(DOT_vector) << "  " ;
 
-	// Misaligned
+	LowPrecisionKernels<T> k = lowPrecisionKernels((const T*)nullptr) ;
+	auto saxpy_simd = k.saxpy ? k.saxpy : saxpy_dataTyped_vector<T> ;
+	auto dot_simd = k.dot ? k.dot : dot_dataTyped_scalar<T> ;
+
+	double flops = 2.0 * N ;
+	double bytesPerElem = 3.0 * sizeof(T) ;
+	TimingStats time_scalar = harness.measure([&](){saxpy_dataTyped_scalar<T>(a, x.data(), y.data(), N);}) ;
+	TimingStats time_vector = harness.measure([&](){saxpy_dataTyped_vector<T>(a, x.data(), y.data(), N);}) ;
+	TimingStats time_simd = harness.measure([&](){saxpy_simd(a, x.data(), y.data(), N);}) ;
+	volatile double sink = 0.0 ;
+	TimingStats dot_time_scalar = harness.measure([&](){sink = (double)dot_dataTyped_scalar<T>(x.data(), y.data(), N);}) ;
+	TimingStats dot_time_simd = harness.measure([&](){sink = (double)dot_simd(x.data(), y.data(), N);}) ;
+	(void)sink ;
+
+	Fields params = {Field("type", name), Field("N", N), Field("bytes_per_elem", bytesPerElem), Field("simd_path", k.name)} ;
+	recordPair("datatype", "saxpy", params, flops, time_scalar, time_vector) ;
+	harness.record("datatype", "saxpy_simd", params, time_simd,
+			{Field("gflops", flops / (time_simd.median * 1e9)), Field("speedup", time_scalar.median / time_simd.median),
+			 Field("gbps", bytesPerElem * N / (time_simd.median * 1e9))}) ;
+	harness.record("datatype", "dot_scalar", params, dot_time_scalar, {Field("gflops", flops / (dot_time_scalar.median * 1e9))}) ;
+	harness.record("datatype", "dot_simd", params, dot_time_simd,
+			{Field("gflops", flops / (dot_time_simd.median * 1e9)), Field("speedup", dot_time_scalar.median / dot_time_simd.median)}) ;
+}
+
+// Data Type Comparison
+void test4(){
+	size_t N = 1<<20 ;
+	testDataType<float>("Float", N, 2.0f) ;
+	testDataType<double>("Double", N, 2.0) ;
+	testDataType<half_t>("FP16", N, 2.0f) ;
+	testDataType<bf16_t>("BF16", N, 2.0f) ;
+	testDataType<int8_t>("INT8", N, 2) ;
+}
+
+// ISA Comparison: compiler baselines next to every hand-written backend the host supports
+void test5(size_t N, const std::vector<SimdBackend>& backends){
+	std::vector<float> x(N), y(N), result(N) ;
+
+	std::default_random_engine engine(42) ;
+	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
 	for(size_t i = 0; i < N; i++){
 		x[i] = dist(engine) ;
-	}	
-	for(size_t i = 0; i < N2; i++){
 		y[i] = dist(engine) ;
 	}
-	DOT_scalar = timeit([&](){dot_scalar(x.data(), y.data(), N); }) ;
-	DOT_vector = timeit([&](){dot_vectorized(x.data(), y.data(), N); }) ;
-	std::cout << std::to_string(DOT_scalar) << "  " << std::to_string(DOT_vector) << "  " ;
 
-	// Multiples
-	for(size_t i = 0; i < N; i++){
-		x[i] = dist(engine) ;
-	}	
-	for(size_t i = 0; i < N3; i++){
-		y[i] = dist(engine) ;
+	// Speedups are against the scalar backend, which benchBackends lists first
+	double sax_base = 0.0, dot_base = 0.0, element_base = 0.0 ;
+	for(const SimdBackend& b : backends){
+		TimingStats sax_time = harness.measure([&](){b.saxpy(2.0f, x.data(), y.data(), N); }) ;
+		volatile float sink = 0.0f ;
+		TimingStats dot_time = harness.measure([&](){sink = b.dot(x.data(), y.data(), N); }) ;
+		TimingStats element_time = harness.measure([&](){b.element(x.data(), y.data(), result.data(), N); }) ;
+		(void)sink ;
+		if(b.isa == ISA_SCALAR){
+			sax_base = sax_time.median ; dot_base = dot_time.median ; element_base = element_time.median ;
+		}
+
+		Fields params = {Field("isa", b.name), Field("N", N)} ;
+		harness.record("isa", "saxpy", params, sax_time,
+				{Field("gflops", 2.0 * N / (sax_time.median * 1e9)), Field("speedup", sax_base / sax_time.median)}) ;
+		harness.record("isa", "dot", params, dot_time,
+				{Field("gflops", 2.0 * N / (dot_time.median * 1e9)), Field("speedup", dot_base / dot_time.median)}) ;
+		harness.record("isa", "element", params, element_time,
+				{Field("gflops", 1.0 * N / (element_time.median * 1e9)), Field("speedup", element_base / element_time.median)}) ;
 	}
-	DOT_scalar = timeit([&](){dot_scalar(x.data(), y.data(), N); }) ;
-	DOT_vector = timeit([&](){dot_vectorized(x.data(), y.data(), N); }) ;
-	std::cout << std::to_string(DOT_scalar) << "  " << std::to_string(DOT_vector) << "  \n" ;
+}
 
-	//randomize data
+// Reduction accuracy/throughput: every accumulator count and summation mode
+// against a double-precision reference
+void test6(size_t N, const std::vector<SimdBackend>& backends){
+	std::vector<float> x(N), y(N) ;
+
+	std::default_random_engine engine(42) ;
+	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
 	for(size_t i = 0; i < N; i++){
 		x[i] = dist(engine) ;
 		y[i] = dist(engine) ;
 	}
-	std::cout<< "ELEMENT  " ;
-	// Aligned
-	double ELEMENT_scalar = timeit([&](){element_scalar(x.data(), y.data(),result.data(), N); }) ;
-	double ELEMENT_vector = timeit([&](){element_vectorized(x.data(), y.data(), result.data(), N); }) ;
-	std::cout << std::to_string(ELEMENT_scalar) << "  " << std::to_string(ELEMENT_vector) << "  " ;
 
-	// Misaligned
-	for(size_t i = 0; i < N; i++){
-		x[i] = dist(engine) ;
-	}	
-	for(size_t i = 0; i < N2; i++){
-		y[i] = dist(engine) ;
+	double reference = 0.0 ;
+	for(size_t i = 0; i < N; i++) reference += (double)x[i] * (double)y[i] ;
+
+	double flops = 2.0 * N ;
+	auto report = [&](const char* isa, int accumulators, const char* mode, dot_fn fn){
+		volatile float result = 0.0f ;
+		TimingStats time = harness.measure([&](){result = fn(x.data(), y.data(), N); }) ;
+		double relErr = std::fabs((double)result - reference) / std::fabs(reference) ;
+		harness.record("reduce", "dot", {Field("isa", isa), Field("accumulators", accumulators), Field("mode", mode), Field("N", N)}, time,
+				{Field("gflops", flops / (time.median * 1e9)), Field("rel_error", relErr)}) ;
+	} ;
+
+	report("scalar", 1, "naive", dot_scalar) ;
+	report("auto", 1, "naive", dot_vectorized) ;
+	for(const ReductionVariant& v : reductionVariants(backends)){
+		report(v.isa, v.accumulators, sumModeName(v.mode), v.fn) ;
 	}
-	ELEMENT_scalar = timeit([&](){element_scalar(x.data(), y.data(), result.data(), N); }) ;
-	ELEMENT_vector = timeit([&](){element_vectorized(x.data(), y.data(), result.data(), N); }) ;
-	std::cout << std::to_string(ELEMENT_scalar) << "  " << std::to_string(ELEMENT_vector) << "  " ;
+}
 
-	// Multiples
-	for(size_t i = 0; i < N; i++){
-		x[i] = dist(engine) ;
-	}	
-	for(size_t i = 0; i < N3; i++){
-		y[i] = dist(engine) ;
+// Core scaling: parallel kernels on a persistent pinned pool, 1..maxThreads.
+// Buffers are re-allocated and first-touched for every thread count so page
+// placement always matches the chunking being timed.
+void test7(size_t N, const SimdBackend& b, int maxThreads){
+	ThreadPool pool(maxThreads) ;
+	harness.countThreads(pool.threadIds()) ;
+	double sax_base = 0.0, dot_base = 0.0, element_base = 0.0 ;
+
+	for(int threads = 1; threads <= maxThreads; threads++){
+		float* x = allocFloats(N) ;
+		float* y = allocFloats(N) ;
+		float* result = allocFloats(N) ;
+		if(!x || !y || !result){
+			std::cerr << "alloc failed for N=" << N << "\n" ;
+			free(x) ; free(y) ; free(result) ;
+			harness.countThreads({}) ;
+			return ;
+		}
+		auto randomize = [](float* p, size_t n, int tid){
+			std::default_random_engine engine(42 + tid) ;
+			std::uniform_real_distribution<float> dist(0.0, 1.0) ;
+			for(size_t i = 0; i < n; i++) p[i] = dist(engine) ;
+		} ;
+		firstTouch(pool, threads, x, N, randomize) ;
+		firstTouch(pool, threads, y, N, randomize) ;
+		firstTouch(pool, threads, result, N, [](float* p, size_t n, int){ std::memset(p, 0, n * sizeof(float)) ; }) ;
+
+		TimingStats sax_time = harness.measure([&](){saxpy_parallel(pool, threads, b, 2.0f, x, y, N); }) ;
+		volatile float sink = 0.0f ;
+		TimingStats dot_time = harness.measure([&](){sink = dot_parallel(pool, threads, b, x, y, N); }) ;
+		TimingStats element_time = harness.measure([&](){element_parallel(pool, threads, b, x, y, result, N); }) ;
+		(void)sink ;
+
+		double sax_gflops = 2.0 * N / (sax_time.median * 1e9) ;
+		double dot_gflops = 2.0 * N / (dot_time.median * 1e9) ;
+		double element_gflops = 1.0 * N / (element_time.median * 1e9) ;
+		if(threads == 1){
+			sax_base = sax_gflops ; dot_base = dot_gflops ; element_base = element_gflops ;
+		}
+
+		// Efficiency = speedup over one thread divided by thread count
+		Fields params = {Field("isa", b.name), Field("threads", threads), Field("N", N)} ;
+		harness.record("threads", "saxpy", params, sax_time,
+				{Field("gflops", sax_gflops), Field("efficiency", sax_gflops / (sax_base * threads)),
+				 Field("gbps", 12.0 * N / (sax_time.median * 1e9))}) ;
+		harness.record("threads", "dot", params, dot_time,
+				{Field("gflops", dot_gflops), Field("efficiency", dot_gflops / (dot_base * threads)),
+				 Field("gbps", 8.0 * N / (dot_time.median * 1e9))}) ;
+		harness.record("threads", "element", params, element_time,
+				{Field("gflops", element_gflops), Field("efficiency", element_gflops / (element_base * threads)),
+				 Field("gbps", 12.0 * N / (element_time.median * 1e9))}) ;
+
+		free(x) ; free(y) ; free(result) ;
 	}
-	ELEMENT_scalar = timeit([&](){element_scalar(x.data(), y.data(), result.data(), N); }) ;
-	ELEMENT_vector = timeit([&](){element_vectorized(x.data(), y.data(), result.data(), N); }) ;
-	std::cout << std::to_string(ELEMENT_scalar) << "  " << std::to_string(ELEMENT_vector) << "  \n" ;
+	harness.countThreads({}) ;
 }
 
-// Stride/Gather Effects using only SAXPY
-void test3(){
-	size_t N = 1<<20 ;
-	std::vector<float> x(N), y(N) ;
+// Fused vs unfused chains. Unfused runs the backend's kernels back to back;
+// fused evaluates the expression template compiled for the same ISA.
+void test8(size_t N, const SimdBackend& b){
+	std::vector<float> x(N), y(N), z(N), result(N) ;
 
-	// Random Values
 	std::default_random_engine engine(42) ;
 	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
 	for(size_t i = 0; i < N; i++){
 		x[i] = dist(engine) ;
 		y[i] = dist(engine) ;
+		z[i] = dist(engine) ;
 	}
 
-	// Stride values and computation
-	std::vector<size_t> strides = {1, 2, 4, 8, 16, 32, 64} ;
-	for(auto stride : strides){
-		double time = timeit([&](){saxpy_strided(2.0, x.data(), y.data(), N, stride);}) ;
+	fused_saxpy_dot_fn saxpyDot = fusedSaxpyDot(b) ;
+	fused_element_saxpy_fn elementSaxpy = fusedElementSaxpy(b) ;
+	volatile float sink = 0.0f ;
+
+	// Fused and unfused must compute the same thing before either is timed.
+	// Arrays agree to float rounding (FMA contraction may differ); the dots
+	// sum in different orders, so they are held to the double-precision sum.
+	{
+		std::vector<float> yUnfused(y), yFused(y), rUnfused(N), rFused(N) ;
+		b.saxpy(2.0f, x.data(), yUnfused.data(), N) ;
+		float dotUnfused = b.dot(yUnfused.data(), z.data(), N) ;
+		float dotFused = saxpyDot(2.0f, x.data(), yFused.data(), z.data(), N) ;
+		b.element(x.data(), y.data(), rUnfused.data(), N) ;
+		b.saxpy(2.0f, z.data(), rUnfused.data(), N) ;
+		elementSaxpy(2.0f, x.data(), y.data(), z.data(), rFused.data(), N) ;
+		double ref = 0.0, worst = 0.0 ;
+		for(size_t i = 0; i < N; i++){
+			ref += (double)yUnfused[i] * (double)z[i] ;
+			worst = std::max(worst, std::fabs((double)yUnfused[i] - yFused[i]) / (std::fabs((double)yUnfused[i]) + 1e-6)) ;
+			worst = std::max(worst, std::fabs((double)rUnfused[i] - rFused[i]) / (std::fabs((double)rUnfused[i]) + 1e-6)) ;
+		}
+		double dotTol = 1e-2 * std::fabs(ref) + 1e-3 ;
+		if(worst > 1e-5 || std::fabs(dotUnfused - ref) > dotTol || std::fabs(dotFused - ref) > dotTol){
+			std::cerr << "fuse: fused and unfused results disagree at N=" << N << " (max rel array diff " << worst
+				<< ", dot unfused " << dotUnfused << " fused " << dotFused << " exact " << ref << "); skipped\n" ;
+			return ;
+		}
+	}
 
-		// FLOPs
-		double flops = 2.0 * (N / stride) ;
-		double glops = flops / (time * 1e9) ;
+	// y = a*x + y ; dot(y, z)
+	TimingStats unfused1 = harness.measure([&](){
+		b.saxpy(2.0f, x.data(), y.data(), N) ;
+		sink = b.dot(y.data(), z.data(), N) ;
+	}) ;
+	TimingStats fused1 = harness.measure([&](){sink = saxpyDot(2.0f, x.data(), y.data(), z.data(), N); }) ;
+
+	// result = x*y ; result = a*z + result
+	TimingStats unfused2 = harness.measure([&](){
+		b.element(x.data(), y.data(), result.data(), N) ;
+		b.saxpy(2.0f, z.data(), result.data(), N) ;
+	}) ;
+	TimingStats fused2 = harness.measure([&](){elementSaxpy(2.0f, x.data(), y.data(), z.data(), result.data(), N); }) ;
+	(void)sink ;
+
+	// Bytes actually moved: unfused re-reads the intermediate array
+	double flops = 4.0 * N ;
+	Fields params = {Field("isa", b.name), Field("N", N)} ;
+	harness.record("fuse", "saxpy_dot_unfused", params, unfused1,
+			{Field("gflops", flops / (unfused1.median * 1e9)), Field("gbps", 20.0 * N / (unfused1.median * 1e9))}) ;
+	harness.record("fuse", "saxpy_dot_fused", params, fused1,
+			{Field("gflops", flops / (fused1.median * 1e9)), Field("gbps", 16.0 * N / (fused1.median * 1e9)),
+			 Field("speedup", unfused1.median / fused1.median)}) ;
+	harness.record("fuse", "element_saxpy_unfused", params, unfused2,
+			{Field("gflops", flops / (unfused2.median * 1e9)), Field("gbps", 24.0 * N / (unfused2.median * 1e9))}) ;
+	harness.record("fuse", "element_saxpy_fused", params, fused2,
+			{Field("gflops", flops / (fused2.median * 1e9)), Field("gbps", 16.0 * N / (fused2.median * 1e9)),
+			 Field("speedup", unfused2.median / fused2.median)}) ;
+}
+
+// Measured single-core FMA peak of the backend's ISA, in GFLOP/s
+double peakGflops(const SimdBackend& b, bool doublePrecision){
+	peak_fn fn = peakKernel(b.isa, doublePrecision) ;
+	if(!fn) return 0.0 ;
+	uint64_t iters = PEAK_ITERS / 2 ;
+	double flops = 0.0 ;
+	TimingStats t = harness.measure([&](){flops = fn(iters); }) ;
+	return flops / (t.median * 1e9) ;
+}
+
+// The same probe as a gemm record, next to the theoretical peak it is
+// compared with; returns the measured GFLOP/s
+double recordPeak(const SimdBackend& b, bool doublePrecision){
+	peak_fn fn = peakKernel(b.isa, doublePrecision) ;
+	if(!fn) return 0.0 ;
+	double flops = 0.0 ;
+	TimingStats t = harness.measure([&](){flops = fn(PEAK_ITERS / 2); }) ;
+	double gflops = flops / (t.median * 1e9) ;
+	harness.record("gemm", "peak_fma", {Field("isa", b.name), Field("precision", doublePrecision ? "fp64" : "fp32")}, t,
+			{Field("gflops", gflops), Field("theory_gflops", theoreticalGflops(b.isa, doublePrecision)),
+			 Field("clock_ghz", nominalClockHz() / 1e9)}) ;
+	return gflops ;
+}
 
-		std::cout << std::to_string(stride) << " " << std::to_string(glops) << " " << std::to_string(time*1000) << std::endl ; 
+// Blocked vs naive GEMM (n x n x n) and GEMV (4n x 4n). Efficiency is given
+// against the measured FMA probe and against the theoretical peak.
+template <typename T>
+void test9(const char* name, size_t n, const SimdBackend& b, const GemmBlocking& bs, double peak, double theory){
+	GemmKernels<T> k = gemmKernels<T>(b) ;
+	std::default_random_engine engine(42) ;
+	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
+
+	std::vector<T> A(n*n), B(n*n), C(n*n, T(0)), Cref(n*n, T(0)) ;
+	for(size_t i = 0; i < n*n; i++){
+		A[i] = (T)dist(engine) ;
+		B[i] = (T)dist(engine) ;
+	}
+
+	// Correctness first, on a zeroed C
+	gemm_naive(n, n, n, A.data(), B.data(), Cref.data()) ;
+	k.gemm(n, n, n, A.data(), B.data(), C.data(), bs) ;
+	double gemmErr = 0.0 ;
+	for(size_t i = 0; i < n*n; i++){
+		gemmErr = std::max(gemmErr, std::fabs((double)C[i] - (double)Cref[i]) / std::fabs((double)Cref[i])) ;
 	}
 
+	double gemm_flops = 2.0 * n * n * n ;
+	TimingStats gemm_naive_time = harness.measure([&](){gemm_naive(n, n, n, A.data(), B.data(), C.data()); }) ;
+	TimingStats gemm_blocked_time = harness.measure([&](){k.gemm(n, n, n, A.data(), B.data(), C.data(), bs); }) ;
+
+	size_t m = 4 * n ;
+	std::vector<T> Av(m*m), x(m), y(m, T(0)) ;
+	for(size_t i = 0; i < m*m; i++) Av[i] = (T)dist(engine) ;
+	for(size_t i = 0; i < m; i++) x[i] = (T)dist(engine) ;
+	// Same check for GEMV, on zeroed outputs: both accumulate into y
+	std::vector<T> yref(m, T(0)) ;
+	gemv_naive(m, m, Av.data(), x.data(), yref.data()) ;
+	k.gemv(m, m, Av.data(), x.data(), y.data(), bs) ;
+	double gemvErr = 0.0 ;
+	for(size_t i = 0; i < m; i++){
+		gemvErr = std::max(gemvErr, std::fabs((double)y[i] - (double)yref[i]) / std::fabs((double)yref[i])) ;
+	}
+	double gemv_flops = 2.0 * m * m ;
+	TimingStats gemv_naive_time = harness.measure([&](){gemv_naive(m, m, Av.data(), x.data(), y.data()); }) ;
+	TimingStats gemv_blocked_time = harness.measure([&](){k.gemv(m, m, Av.data(), x.data(), y.data(), bs); }) ;
+
+	// pct_probe is against the measured FMA probe, pct_theory against
+	// clock x FMA ports x lanes x 2
+	auto report = [&](const char* kernel, size_t dim, double flops, const TimingStats& t, double maxErr){
+		double gflops = flops / (t.median * 1e9) ;
+		harness.record("gemm", kernel,
+				{Field("isa", b.name), Field("type", name), Field("n", dim), Field("MC", bs.MC), Field("KC", bs.KC), Field("NC", bs.NC)}, t,
+				{Field("gflops", gflops), Field("pct_probe", 100.0 * gflops / peak), Field("pct_theory", 100.0 * gflops / theory),
+				 Field("max_rel_error", maxErr)}) ;
+	} ;
+	report("gemm_naive", n, gemm_flops, gemm_naive_time, gemmErr) ;
+	report("gemm_blocked", n, gemm_flops, gemm_blocked_time, gemmErr) ;
+	report("gemv_naive", m, gemv_flops, gemv_naive_time, gemvErr) ;
+	report("gemv_blocked", m, gemv_flops, gemv_blocked_time, gemvErr) ;
 }
 
-// Data Type Comparison
-void test4(){
-	size_t N = 1<<20 ;
-	// Float Test
-	std::vector<float> xf(N), yf(N) ;
-	double f_flops = 2.0 * N;
-	double float_time_scalar = timeit([&](){saxpy_dataTyped_scalar(2.0f, xf.data(), yf.data(), N);});
-	double float_time_vector = timeit([&](){saxpy_dataTyped_vector(2.0f, xf.data(), yf.data(), N);});
-	double float_speedup = float_time_scalar/float_time_vector ;
-	double gflops_float_scalar = f_flops / (float_time_scalar*1e9) ;
-	double gflops_float_vector = f_flops / (float_time_vector*1e9) ;
-	std::cout << "Float " << std::to_string(float_speedup) << " " 
-				<< std::to_string(gflops_float_scalar) << "  "
-				<< std::to_string(gflops_float_vector) << std::endl;
-
-	// Double Test
-	std::vector<double> xd(N), yd(N) ;
-	double d_flops = 2.0 * N;
-	double double_time_scalar = timeit([&](){saxpy_dataTyped_scalar(2.0, xd.data(), yd.data(), N);});
-	double double_time_vector = timeit([&](){saxpy_dataTyped_vector(2.0, xd.data(), yd.data(), N);});
-	double double_speedup = double_time_scalar/double_time_vector ;
-	double gflops_double_scalar = d_flops / (double_time_scalar*1e9) ;
-	double gflops_double_vector = d_flops / (double_time_vector*1e9) ;
-	std::cout << "Double " << std::to_string(double_speedup) << " " 
-				<< std::to_string(gflops_double_scalar) << "  "
-				<< std::to_string(gflops_double_vector) ;
+// Gather/scatter and SpMV over irregular index lists. Every kernel variant
+// and prefetch distance is compared with the scalar, no-prefetch run of the
+// same pattern and table size.
+void test10(size_t tableSize, const std::vector<size_t>& dists){
+	const size_t N = 1 << 22 ;
+	const size_t nnzPerRow = 16 ;
+	std::vector<float> table(tableSize), x(N), y(N), ySpmv(N / nnzPerRow) ;
+	std::default_random_engine engine(42) ;
+	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
+	for(float& v : table) v = dist(engine) ;
+	for(float& v : x) v = dist(engine) ;
+	for(float& v : y) v = dist(engine) ;
+
+	std::vector<GatherKernels> kernels = gatherKernels() ;
+	for(IndexPattern p : {IDX_RANDOM, IDX_CLUSTERED, IDX_SORTED}){
+		std::vector<int32_t> idx = makeIndices(p, N, tableSize, 7) ;
+		CsrMatrix m = makeCsr(p, N / nnzPerRow, tableSize, nnzPerRow, 7) ;
+		// speedups are against the scalar kernel without prefetch, whatever
+		// distances were asked for
+		const GatherKernels& base = kernels[0] ;
+		double gather_base = harness.measure([&](){base.gather(2.0f, table.data(), idx.data(), y.data(), N, 0); }).median ;
+		double scatter_base = harness.measure([&](){base.scatter(2.0f, x.data(), idx.data(), table.data(), N, 0); }).median ;
+		double spmv_base = harness.measure([&](){base.spmv(m.rows, m.rowPtr.data(), m.col.data(), m.val.data(), table.data(), ySpmv.data(), 0); }).median ;
+		for(const GatherKernels& k : kernels){
+			for(size_t d : dists){
+				TimingStats gather_time = harness.measure([&](){k.gather(2.0f, table.data(), idx.data(), y.data(), N, d); }) ;
+				// scatter writes into the table so its footprint matches gather
+				TimingStats scatter_time = harness.measure([&](){k.scatter(2.0f, x.data(), idx.data(), table.data(), N, d); }) ;
+				TimingStats spmv_time = harness.measure([&](){k.spmv(m.rows, m.rowPtr.data(), m.col.data(), m.val.data(), table.data(), ySpmv.data(), d); }) ;
+				Fields params = {Field("pattern", indexPatternName(p)), Field("table_bytes", tableSize * sizeof(float)),
+						Field("isa", k.name), Field("prefetch", d)} ;
+				harness.record("gather", "gather_saxpy", params, gather_time,
+						{Field("gflops", 2.0 * N / (gather_time.median * 1e9)), Field("ns_per_elem", gather_time.median * 1e9 / N),
+						 Field("speedup", gather_base / gather_time.median)}) ;
+				harness.record("gather", "scatter_add", params, scatter_time,
+						{Field("gflops", 2.0 * N / (scatter_time.median * 1e9)), Field("ns_per_elem", scatter_time.median * 1e9 / N),
+						 Field("speedup", scatter_base / scatter_time.median)}) ;
+				harness.record("gather", "spmv", params, spmv_time,
+						{Field("gflops", 2.0 * N / (spmv_time.median * 1e9)), Field("ns_per_nnz", spmv_time.median * 1e9 / N),
+						 Field("speedup", spmv_base / spmv_time.median)}) ;
+			}
+		}
+	}
+}
+
+// ------------------------------- Roofline --------------------------------
+// One measured point of a kernel: problem size, the work and compulsory
+// traffic of one call, the bytes it keeps live, and the timing
+struct RooflinePoint {
+	size_t n ;
+	double flops ;
+	double bytes ;
+	double footprint ;
+	TimingStats t ;
+} ;
+
+// A registered kernel sizes itself to a target footprint and measures one point
+struct RooflineKernel {
+	const char* name ;
+	std::function<RooflinePoint(size_t footprint)> run ;
+} ;
+
+// A bandwidth ceiling: a level, the footprint probed inside it (half its
+// capacity), and the best GB/s any probe reached there
+struct RooflineRoof {
+	const char* level ;
+	size_t capacity ;
+	size_t footprint ;
+	double gbps ;
+} ;
+
+static std::vector<float> randomFloats(size_t n, unsigned seed){
+	std::vector<float> v(n) ;
+	std::default_random_engine engine(seed) ;
+	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
+	for(float& f : v) f = dist(engine) ;
+	return v ;
+}
+
+static volatile float rooflineSink ;
+
+// Every fp32 kernel the roofline places, run on backend b. Traffic counts
+// each array once per call (read, write, or both for in-place updates).
+std::vector<RooflineKernel> rooflineKernels(const SimdBackend& b){
+	std::vector<RooflineKernel> out ;
+	auto stream = [](const char* name, double flopsPerElem, double bytesPerElem, double footprintPerElem, int arrays,
+			std::function<void(size_t, std::vector<std::vector<float> >&)> call){
+		return RooflineKernel{name, [=](size_t footprint){
+			size_t n = std::max<size_t>(64, (size_t)(footprint / footprintPerElem)) ;
+			std::vector<std::vector<float> > a ;
+			for(int k = 0; k < arrays; k++) a.push_back(randomFloats(n, 42 + k)) ;
+			TimingStats t = harness.measure([&](){ call(n, a) ; }) ;
+			return RooflinePoint{n, flopsPerElem * n, bytesPerElem * n, footprintPerElem * n, t} ;
+		}} ;
+	} ;
+	out.push_back(stream("saxpy", 2, 12, 8, 2, [b](size_t n, std::vector<std::vector<float> >& a){ b.saxpy(2.0f, a[0].data(), a[1].data(), n) ; })) ;
+	out.push_back(stream("dot", 2, 8, 8, 2, [b](size_t n, std::vector<std::vector<float> >& a){ rooflineSink = b.dot(a[0].data(), a[1].data(), n) ; })) ;
+	out.push_back(stream("element", 1, 12, 12, 3, [b](size_t n, std::vector<std::vector<float> >& a){ b.element(a[0].data(), a[1].data(), a[2].data(), n) ; })) ;
+	fused_saxpy_dot_fn saxpyDot = fusedSaxpyDot(b) ;
+	fused_element_saxpy_fn elementSaxpy = fusedElementSaxpy(b) ;
+	out.push_back(stream("fused_saxpy_dot", 4, 16, 12, 3, [saxpyDot](size_t n, std::vector<std::vector<float> >& a){
+		rooflineSink = saxpyDot(2.0f, a[0].data(), a[1].data(), a[2].data(), n) ;
+	})) ;
+	out.push_back(stream("fused_element_saxpy", 3, 16, 16, 4, [elementSaxpy](size_t n, std::vector<std::vector<float> >& a){
+		elementSaxpy(2.0f, a[0].data(), a[1].data(), a[2].data(), a[3].data(), n) ;
+	})) ;
+
+	// Low-precision storage moves fewer bytes for the same fp32 arithmetic
+	auto narrow = [](const char* name, auto tag, size_t bytesPerValue){
+		typedef decltype(tag) T ;
+		return RooflineKernel{name, [=](size_t footprint){
+			typedef StorageTraits<T> S ;
+			LowPrecisionKernels<T> k = lowPrecisionKernels((const T*)nullptr) ;
+			auto saxpy = k.saxpy ? k.saxpy : saxpy_dataTyped_vector<T> ;
+			size_t n = std::max<size_t>(64, footprint / (2 * bytesPerValue)) ;
+			std::vector<T> x(n), y(n) ;
+			std::vector<float> src = randomFloats(2 * n, 42) ;
+			for(size_t i = 0; i < n; i++){ x[i] = S::store(src[i]) ; y[i] = S::store(src[n + i]) ; }
+			TimingStats t = harness.measure([&](){ saxpy(2.0f, x.data(), y.data(), n) ; }) ;
+			return RooflinePoint{n, 2.0 * n, 3.0 * bytesPerValue * n, 2.0 * bytesPerValue * n, t} ;
+		}} ;
+	} ;
+	out.push_back(narrow("saxpy_fp16", half_t(), sizeof(half_t))) ;
+	out.push_back(narrow("saxpy_bf16", bf16_t(), sizeof(bf16_t))) ;
+
+	// Random gather into a table as large as the streamed arrays
+	std::vector<GatherKernels> gk = gatherKernels() ;
+	GatherKernels g = gk.back() ;
+	for(const GatherKernels& k : gk) if(std::strcmp(k.name, b.name) == 0) g = k ;
+	out.push_back(RooflineKernel{"gather_saxpy", [g](size_t footprint){
+		size_t n = std::max<size_t>(64, footprint / 12) ;
+		std::vector<float> table = randomFloats(n, 42), y = randomFloats(n, 43) ;
+		std::vector<int32_t> idx = makeIndices(IDX_RANDOM, n, n, 7) ;
+		TimingStats t = harness.measure([&](){ g.gather(2.0f, table.data(), idx.data(), y.data(), n, 0) ; }) ;
+		return RooflinePoint{n, 2.0 * n, 16.0 * n, 12.0 * n, t} ;
+	}}) ;
+
+	// GEMV streams its matrix once; GEMM reuses every element n times, so its
+	// compulsory-traffic intensity grows with n. GEMM stays <= 1024 to bound runtime.
+	GemmKernels<float> gemm = gemmKernels<float>(b) ;
+	GemmBlocking bs = defaultBlocking<float>(hostCacheSizes()) ;
+	out.push_back(RooflineKernel{"gemv", [gemm, bs](size_t footprint){
+		size_t m = std::max<size_t>(16, (size_t)std::sqrt(footprint / 4.0)) ;
+		std::vector<float> A = randomFloats(m * m, 42), x = randomFloats(m, 43), y(m, 0.0f) ;
+		TimingStats t = harness.measure([&](){ gemm.gemv(m, m, A.data(), x.data(), y.data(), bs) ; }) ;
+		return RooflinePoint{m, 2.0 * m * m, 4.0 * m * m + 8.0 * m, 4.0 * m * m + 8.0 * m, t} ;
+	}}) ;
+	out.push_back(RooflineKernel{"gemm", [gemm, bs](size_t footprint){
+		size_t n = std::min<size_t>(1024, std::max<size_t>(16, (size_t)std::sqrt(footprint / 12.0))) ;
+		std::vector<float> A = randomFloats(n * n, 42), B = randomFloats(n * n, 43), C(n * n, 0.0f) ;
+		TimingStats t = harness.measure([&](){ gemm.gemm(n, n, n, A.data(), B.data(), C.data(), bs) ; }) ;
+		return RooflinePoint{n, 2.0 * n * n * n, 16.0 * n * n, 12.0 * n * n, t} ;
+	}}) ;
+	return out ;
 }
 
-int main(){
-	/* 	Speedup and GFLOP analysis
-	std::cout << "Arraysize  SAXPY_speedup SAXPY_GFLOP/s     DOT_speedup  DOT_GFLOP/s    ELEMENT_speedup  ELEMENT_GFLOP/s " << std::endl ;
-	std::cout << "                         scalar   vector                scalar vector                   scalar vector  " <<std::endl;
-	for(size_t i = 1; i <= 8; i++){
-		std::cout << std::to_string(i) << "          " ;
-		test(pow(10,i)) ;
-	}
-	*/
-
-	/*  Alignment Analysis
-	std::cout << "        Aligned         Unaligned       Multiples" << std::endl ;
-	std::cout << "        scalar vector   scalar vector   scalar vector " << std::endl ;
-	test2() ;
-	*/
-
-	/*  Stride Effects Analysis
-	std::cout << "Stride     GFLOP/s     Time(ms)" << std::endl ;
-	test3() ;
-	*/
-
-	std::cout << "Type    Speedup  GFLOP/s(scalar)    GFLOP/s(vector)\n" ;
-	test4() ;
-}
\ No newline at end of file
+// Roofline: FMA peak per ISA, read bandwidth per cache level and DRAM, then
+// every registered kernel at a footprint inside each level, placed against
+// the roof of the level it ran from. Single core, like the peak probe.
+void test11(const SimdBackend& b, const std::vector<SimdBackend>& backends){
+	for(const SimdBackend& isa : backends){
+		for(bool dp : {false, true}){
+			peak_fn fn = peakKernel(isa.isa, dp) ;
+			if(!fn) continue ;
+			double flops = 0.0 ;
+			TimingStats t = harness.measure([&](){ flops = fn(PEAK_ITERS / 20) ; }) ;
+			harness.record("roofline", "peak_fma", {Field("isa", isa.name), Field("precision", dp ? "fp64" : "fp32")}, t,
+					{Field("gflops", flops / (t.median * 1e9))}) ;
+		}
+	}
+	double peak = peakGflops(b, false) ;
+
+	// Bandwidth roofs are the best of a read-only reduction (16 accumulators,
+	// so FMA latency never limits it) and an in-place SAXPY update
+	// Levels the host does not report (size 0) get no roof
+	CacheSizes c = hostCacheSizes(false) ;
+	size_t dram = std::max<size_t>(4 * std::max({c.l1d, c.l2, c.l3}), (size_t)64 << 20) ;
+	std::vector<RooflineRoof> roofs ;
+	for(const RooflineRoof& r : {RooflineRoof{"L1", c.l1d, c.l1d / 2, 0.0}, RooflineRoof{"L2", c.l2, c.l2 / 2, 0.0},
+			RooflineRoof{"L3", c.l3, c.l3 / 2, 0.0}}){
+		if(r.capacity) roofs.push_back(r) ;
+		else std::cerr << "roofline: " << r.level << " size unknown, no roof for it\n" ;
+	}
+	roofs.push_back({"DRAM", SIZE_MAX, dram, 0.0}) ;
+	dot_fn read = b.dot ;
+	for(const ReductionVariant& v : reductionVariants({b})){
+		if(v.accumulators == 16 && v.mode == SUM_NAIVE) read = v.fn ;
+	}
+	for(RooflineRoof& r : roofs){
+		size_t n = r.footprint / 8 ;
+		std::vector<float> x = randomFloats(n, 42), y = randomFloats(n, 43) ;
+		TimingStats tr = harness.measure([&](){ rooflineSink = read(x.data(), y.data(), n) ; }) ;
+		TimingStats tu = harness.measure([&](){ b.saxpy(2.0f, x.data(), y.data(), n) ; }) ;
+		double readGbps = 8.0 * n / (tr.median * 1e9) ;
+		double updateGbps = 12.0 * n / (tu.median * 1e9) ;
+		r.gbps = std::max(readGbps, updateGbps) ;
+		harness.record("roofline", "bandwidth", {Field("isa", b.name), Field("level", r.level), Field("footprint", r.footprint)},
+				readGbps >= updateGbps ? tr : tu,
+				{Field("gbps", r.gbps), Field("read_gbps", readGbps), Field("update_gbps", updateGbps),
+				 Field("ridge_flops_per_byte", peak / r.gbps)}) ;
+	}
+
+	for(const RooflineKernel& k : rooflineKernels(b)){
+		for(const RooflineRoof& target : roofs){
+			RooflinePoint p = k.run(target.footprint) ;
+			// The roof is that of the smallest level the footprint fits in
+			const RooflineRoof* roof = &roofs.back() ;
+			for(const RooflineRoof& r : roofs){
+				if(p.footprint <= r.capacity){ roof = &r ; break ; }
+			}
+			double ai = p.flops / p.bytes ;
+			double gflops = p.flops / (p.t.median * 1e9) ;
+			double attainable = std::min(peak, ai * roof->gbps) ;
+			harness.record("roofline", k.name,
+					{Field("isa", b.name), Field("n", p.n), Field("footprint", p.footprint), Field("level", roof->level),
+					 Field("flops_per_byte", ai)}, p.t,
+					{Field("gflops", gflops), Field("roof_gflops", attainable), Field("pct_of_roof", 100.0 * gflops / attainable),
+					 Field("headroom", attainable / gflops), Field("bound", ai * roof->gbps < peak ? "memory" : "compute")}) ;
+		}
+	}
+}
+
+// Scalar and compiler-vectorized kernels followed by the hand-written backends.
+// A non-null name keeps the scalar baseline plus that one backend.
+std::vector<SimdBackend> benchBackends(const char* only){
+	std::vector<SimdBackend> out = {
+		{"scalar", ISA_SCALAR, 1, saxpy_scalar, dot_scalar, element_scalar},
+	} ;
+	SimdBackend automatic = {"auto", ISA_AUTO, 0, saxpy_vectorized, dot_vectorized, element_vectorized} ;
+	if(!only){
+		out.push_back(automatic) ;
+		for(const SimdBackend& b : availableBackends()) out.push_back(b) ;
+	}else if(std::strcmp(only, "auto") == 0){
+		out.push_back(automatic) ;
+	}else if(std::strcmp(only, "scalar") != 0){
+		const SimdBackend* b = findBackend(only) ;
+		if(b) out.push_back(*b) ;
+		else out.clear() ;
+	}
+	return out ;
+}
+
+void usage(const char* pname){
+	std::cerr << "Usage: " << pname << " [mode] [options]\n"
+		<< "Modes:\n"
+		<< "  speedup   : scalar vs vector speedup and GFLOP/s, N = 10^1..10^maxexp\n"
+		<< "  alignment : aligned, misaligned and multiple-size buffers\n"
+		<< "  stride    : strided SAXPY\n"
+		<< "  datatype  : double, float, fp16, bf16 and int8 storage (default)\n"
+		<< "  isa       : hand-written SIMD backends side by side, N = 10^3..10^maxexp\n"
+		<< "  reduce    : dot reductions by accumulator count and summation mode, N = 10^4..10^maxexp\n"
+		<< "  threads   : parallel kernels on a pinned thread pool, 1..maxthreads threads, N = 10^maxexp\n"
+		<< "  fuse      : fused expression templates vs back-to-back kernels, N = 10^1..10^maxexp\n"
+		<< "  gemm      : cache-blocked GEMM/GEMV vs naive loops against measured and theoretical FMA peak, n = 64..gemmmax\n"
+		<< "  gather    : gather-SAXPY, scatter-add and CSR SpMV over random/clustered/sorted indices\n"
+		<< "  roofline  : FMA peaks, per-level bandwidth roofs, and every kernel's distance from its roof\n"
+		<< "Options:\n"
+		<< "  --isa <scalar|auto|sse2|avx2|avx512|neon>  restrict isa/reduce modes to one backend\n"
+		<< "  --maxexp <n>                               largest array size exponent (default 8)\n"
+		<< "  --maxthreads <n>                           threads mode upper bound (default: all allowed CPUs)\n"
+		<< "  --gemmmax <n>                              largest GEMM dimension (default 1024)\n"
+		<< "  --mc/--kc/--nc <n>                         GEMM block sizes (default: from L2/L1/L3 sizes)\n"
+		<< "  --prefetch <d>                             gather mode prefetch distance (default: sweep 0 16 64)\n"
+		<< "  --format <csv|json>                        record format (default csv)\n"
+		<< "  --samples <n>                              timed samples per measurement (default 15)\n"
+		<< "  --mintime <ms>                             minimum duration of one warm sample (default 10)\n"
+		<< "  --cold                                     flush caches before every call instead of calibrating\n"
+		<< "  --flushmb <n>                              cold-run flush buffer in MiB (default 4x L3)\n"
+		<< "  --counters                                 add perf_event cycles/instructions/L1D/LLC/dTLB misses/stalls per call\n"
+		<< "  --results <file>                           append the raw samples of every record in the shared result schema,\n"
+		<< "                                             for Common/compareResults.py\n" ;
+}
+
+int main(int argc, char** argv){
+	std::string mode = argc > 1 ? argv[1] : "datatype" ;
+	const char* isaName = nullptr ;
+	int maxExp = 8 ;
+	int maxThreads = (int)allowedCpus().size() ;
+	size_t gemmMax = 1024 ;
+	size_t mc = 0, kc = 0, nc = 0 ;
+	std::vector<size_t> prefetchDists = {0, 16, 64} ;
+	size_t flushMb = 0 ;
+	for(int i = 2; i < argc; i++){
+		if(std::strcmp(argv[i], "--isa") == 0 && i+1 < argc) isaName = argv[++i] ;
+		else if(std::strcmp(argv[i], "--maxexp") == 0 && i+1 < argc) maxExp = std::atoi(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--maxthreads") == 0 && i+1 < argc) maxThreads = std::atoi(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--gemmmax") == 0 && i+1 < argc) gemmMax = (size_t)std::atoll(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--mc") == 0 && i+1 < argc) mc = (size_t)std::atoll(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--kc") == 0 && i+1 < argc) kc = (size_t)std::atoll(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--nc") == 0 && i+1 < argc) nc = (size_t)std::atoll(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--prefetch") == 0 && i+1 < argc) prefetchDists = {(size_t)std::atoll(argv[++i])} ;
+		else if(std::strcmp(argv[i], "--format") == 0 && i+1 < argc){
+			std::string f = argv[++i] ;
+			if(f == "json") harness.opts.format = OUT_JSON ;
+			else if(f == "csv") harness.opts.format = OUT_CSV ;
+			else { std::cerr << "Unknown format: " << f << "\n" ; usage(argv[0]) ; return 1 ; }
+		}
+		else if(std::strcmp(argv[i], "--samples") == 0 && i+1 < argc) harness.opts.samples = std::max(1, std::atoi(argv[++i])) ;
+		else if(std::strcmp(argv[i], "--mintime") == 0 && i+1 < argc) harness.opts.minSampleSec = std::atof(argv[++i]) / 1000.0 ;
+		else if(std::strcmp(argv[i], "--cold") == 0) harness.opts.cold = true ;
+		else if(std::strcmp(argv[i], "--flushmb") == 0 && i+1 < argc) flushMb = (size_t)std::atoll(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--counters") == 0) harness.enableCounters() ;
+		else if(std::strcmp(argv[i], "--results") == 0 && i+1 < argc){
+			if(!harness.openResults(argv[++i])) return 1 ;
+		}
+		else { std::cerr << "Unknown arg: " << argv[i] << "\n" ; usage(argv[0]) ; return 1 ; }
+	}
+	harness.opts.minSamples = std::min(harness.opts.minSamples, harness.opts.samples) ;
+	benchClockInit() ;
+	// Cold runs evict with 4x the LLC unless told otherwise
+	harness.opts.flushBytes = flushMb ? flushMb << 20 : 4 * hostCacheSizes().l3 ;
+
+	if(mode == "speedup"){
+		for(int i = 1; i <= maxExp; i++){
+			test1((size_t)pow(10,i)) ;
+		}
+	}else if(mode == "alignment"){
+		test2() ;
+	}else if(mode == "stride"){
+		test3() ;
+	}else if(mode == "datatype"){
+		test4() ;
+	}else if(mode == "isa"){
+		std::vector<SimdBackend> backends = benchBackends(isaName) ;
+		if(backends.empty()){
+			std::cerr << "ISA backend not available on this host: " << isaName << "\n" ;
+			return 1 ;
+		}
+		const SimdBackend* best = bestBackend() ;
+		std::cerr << "# dispatch selects " << (best ? best->name : "auto") << "\n" ;
+		for(int i = 3; i <= maxExp; i++){
+			test5((size_t)pow(10,i), backends) ;
+		}
+	}else if(mode == "reduce"){
+		std::vector<SimdBackend> backends = isaName ? benchBackends(isaName) : availableBackends() ;
+		if(isaName && backends.empty()){
+			std::cerr << "ISA backend not available on this host: " << isaName << "\n" ;
+			return 1 ;
+		}
+		for(int i = 4; i <= maxExp; i++){
+			test6((size_t)pow(10,i), backends) ;
+		}
+	}else if(mode == "threads"){
+		const SimdBackend* b = isaName ? findBackend(isaName) : bestBackend() ;
+		SimdBackend automatic = {"auto", ISA_AUTO, 0, saxpy_vectorized, dot_vectorized, element_vectorized} ;
+		if(!b && isaName && std::strcmp(isaName, "auto") != 0){
+			std::cerr << "ISA backend not available on this host: " << isaName << "\n" ;
+			return 1 ;
+		}
+		if(!b) b = &automatic ;
+		test7((size_t)pow(10,maxExp), *b, maxThreads < 1 ? 1 : maxThreads) ;
+	}else if(mode == "fuse"){
+		const SimdBackend* b = isaName ? findBackend(isaName) : bestBackend() ;
+		if(!b){
+			std::cerr << "ISA backend not available on this host: " << (isaName ? isaName : "none") << "\n" ;
+			return 1 ;
+		}
+		for(int i = 1; i <= maxExp; i++){
+			test8((size_t)pow(10,i), *b) ;
+		}
+	}else if(mode == "gemm"){
+		const SimdBackend* b = isaName ? findBackend(isaName) : bestBackend() ;
+		if(!b){
+			std::cerr << "ISA backend not available on this host: " << (isaName ? isaName : "none") << "\n" ;
+			return 1 ;
+		}
+		CacheSizes caches = hostCacheSizes() ;
+		GemmBlocking fs = defaultBlocking<float>(caches), ds = defaultBlocking<double>(caches) ;
+		for(GemmBlocking* bs : {&fs, &ds}){
+			if(mc) bs->MC = mc ;
+			if(kc) bs->KC = kc ;
+			if(nc) bs->NC = nc ;
+		}
+		double fpeak = recordPeak(*b, false), dpeak = recordPeak(*b, true) ;
+		double ftheory = theoreticalGflops(b->isa, false), dtheory = theoreticalGflops(b->isa, true) ;
+		for(size_t n = 64; n <= gemmMax; n *= 2) test9<float>("Float", n, *b, fs, fpeak, ftheory) ;
+		for(size_t n = 64; n <= gemmMax; n *= 2) test9<double>("Double", n, *b, ds, dpeak, dtheory) ;
+	}else if(mode == "gather"){
+		// 64 KiB (L1/L2), 1 MiB (L2), 16 MiB (LLC), 256 MiB (DRAM), capped by maxexp
+		for(size_t tableSize : {(size_t)1 << 14, (size_t)1 << 18, (size_t)1 << 22, (size_t)1 << 26}){
+			if((double)tableSize > pow(10, maxExp)) break ;
+			test10(tableSize, prefetchDists) ;
+		}
+	}else if(mode == "roofline"){
+		const SimdBackend* b = isaName ? findBackend(isaName) : bestBackend() ;
+		if(!b){
+			std::cerr << "ISA backend not available on this host: " << (isaName ? isaName : "none") << "\n" ;
+			return 1 ;
+		}
+		test11(*b, availableBackends()) ;
+	}else{
+		std::cerr << "Unknown mode: " << mode << "\n" ;
+		usage(argv[0]) ;
+		return 1 ;
+	}
+	harness.finish() ;
+	return 0 ;
+}
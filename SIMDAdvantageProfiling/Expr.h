@@ -0,0 +1,169 @@
+// Lazy expression templates over float arrays. Writing a*x + y builds a small
+// tree instead of a temporary array; assign() and the fused reductions then
+// walk every input once in a single loop, so a chain like
+// "y = a*x + y; dot(y, z)" costs one trip through memory instead of two.
+//
+// Every node is always_inline so a whole expression collapses into the loop
+// of whichever function evaluates it, including target-attributed wrappers
+// that pick the vector width per ISA (see the instantiations at the bottom).
+#pragma once
+
+#include <cstddef>
+
+#include "SimdKernels.h"
+
+#define EXPR_INLINE __attribute__((always_inline)) inline
+
+// Lanes reduced side by side; wide enough for AVX-512 with no cross-lane adds
+#define EXPR_REDUCE_LANES 16
+
+template <typename E>
+struct Expr {
+	EXPR_INLINE const E& self() const { return static_cast<const E&>(*this) ; }
+} ;
+
+// Leaf: an input array
+struct Vec : Expr<Vec> {
+	const float* p ;
+	explicit Vec(const float* data) : p(data) {}
+	EXPR_INLINE float operator[](size_t i) const { return p[i] ; }
+} ;
+
+// Leaf: a scalar broadcast to every element
+struct Scalar : Expr<Scalar> {
+	float v ;
+	explicit Scalar(float value) : v(value) {}
+	EXPR_INLINE float operator[](size_t) const { return v ; }
+} ;
+
+struct OpAdd { static EXPR_INLINE float apply(float a, float b){ return a + b ; } } ;
+struct OpSub { static EXPR_INLINE float apply(float a, float b){ return a - b ; } } ;
+struct OpMul { static EXPR_INLINE float apply(float a, float b){ return a * b ; } } ;
+
+template <typename L, typename R, typename Op>
+struct BinExpr : Expr<BinExpr<L, R, Op> > {
+	L l ;
+	R r ;
+	BinExpr(const L& left, const R& right) : l(left), r(right) {}
+	EXPR_INLINE float operator[](size_t i) const { return Op::apply(l[i], r[i]) ; }
+} ;
+
+template <typename L, typename R>
+EXPR_INLINE BinExpr<L, R, OpAdd> operator+(const Expr<L>& l, const Expr<R>& r){ return BinExpr<L, R, OpAdd>(l.self(), r.self()) ; }
+template <typename L, typename R>
+EXPR_INLINE BinExpr<L, R, OpSub> operator-(const Expr<L>& l, const Expr<R>& r){ return BinExpr<L, R, OpSub>(l.self(), r.self()) ; }
+template <typename L, typename R>
+EXPR_INLINE BinExpr<L, R, OpMul> operator*(const Expr<L>& l, const Expr<R>& r){ return BinExpr<L, R, OpMul>(l.self(), r.self()) ; }
+template <typename R>
+EXPR_INLINE BinExpr<Scalar, R, OpMul> operator*(float a, const Expr<R>& r){ return BinExpr<Scalar, R, OpMul>(Scalar(a), r.self()) ; }
+
+// ------------------------------ Evaluation -------------------------------
+// out[i] = e[i]. out may alias an input: each element is read before written.
+template <typename E>
+EXPR_INLINE void assign(float* out, const Expr<E>& expr, size_t N){
+	const E& e = expr.self() ;
+	for(size_t i = 0; i < N; i++) out[i] = e[i] ;
+}
+
+// sum(e[i]) with independent lane accumulators so the loop vectorizes
+// without reassociating (no -ffast-math needed)
+template <typename E>
+EXPR_INLINE float sum(const Expr<E>& expr, size_t N){
+	const E& e = expr.self() ;
+	float acc[EXPR_REDUCE_LANES] = {} ;
+	size_t i = 0 ;
+	for(; i + EXPR_REDUCE_LANES <= N; i += EXPR_REDUCE_LANES){
+		for(size_t l = 0; l < EXPR_REDUCE_LANES; l++) acc[l] += e[i + l] ;
+	}
+	for(size_t width = EXPR_REDUCE_LANES / 2; width > 0; width /= 2){
+		for(size_t l = 0; l < width; l++) acc[l] += acc[l + width] ;
+	}
+	float total = acc[0] ;
+	for(; i < N; i++) total += e[i] ;
+	return total ;
+}
+
+// Fused: out[i] = e[i] and return sum(out[i] * z[i]) in the same pass
+template <typename E, typename Z>
+EXPR_INLINE float assignDot(float* out, const Expr<E>& expr, const Expr<Z>& zexpr, size_t N){
+	const E& e = expr.self() ;
+	const Z& z = zexpr.self() ;
+	float acc[EXPR_REDUCE_LANES] = {} ;
+	size_t i = 0 ;
+	for(; i + EXPR_REDUCE_LANES <= N; i += EXPR_REDUCE_LANES){
+		for(size_t l = 0; l < EXPR_REDUCE_LANES; l++){
+			float v = e[i + l] ;
+			out[i + l] = v ;
+			acc[l] += v * z[i + l] ;
+		}
+	}
+	for(size_t width = EXPR_REDUCE_LANES / 2; width > 0; width /= 2){
+		for(size_t l = 0; l < width; l++) acc[l] += acc[l + width] ;
+	}
+	float total = acc[0] ;
+	for(; i < N; i++){
+		float v = e[i] ;
+		out[i] = v ;
+		total += v * z[i] ;
+	}
+	return total ;
+}
+
+// ---------------------- Benchmark pipelines per ISA ----------------------
+// y = a*x + y ; return dot(y, z)
+typedef float (*fused_saxpy_dot_fn)(float a, const float* x, float* y, const float* z, size_t N) ;
+// result = x*y + a*z
+typedef void (*fused_element_saxpy_fn)(float a, const float* x, const float* y, const float* z, float* result, size_t N) ;
+
+EXPR_INLINE float fusedSaxpyDotBody(float a, const float* x, float* y, const float* z, size_t N){
+	return assignDot(y, a * Vec(x) + Vec(y), Vec(z), N) ;
+}
+
+EXPR_INLINE void fusedElementSaxpyBody(float a, const float* x, const float* y, const float* z, float* result, size_t N){
+	assign(result, Vec(x) * Vec(y) + a * Vec(z), N) ;
+}
+
+static float fused_saxpy_dot_base(float a, const float* x, float* y, const float* z, size_t N){
+	return fusedSaxpyDotBody(a, x, y, z, N) ;
+}
+static void fused_element_saxpy_base(float a, const float* x, const float* y, const float* z, float* result, size_t N){
+	fusedElementSaxpyBody(a, x, y, z, result, N) ;
+}
+
+#if SIMD_X86
+__attribute__((target("avx2,fma")))
+static float fused_saxpy_dot_avx2(float a, const float* x, float* y, const float* z, size_t N){
+	return fusedSaxpyDotBody(a, x, y, z, N) ;
+}
+__attribute__((target("avx2,fma")))
+static void fused_element_saxpy_avx2(float a, const float* x, const float* y, const float* z, float* result, size_t N){
+	fusedElementSaxpyBody(a, x, y, z, result, N) ;
+}
+__attribute__((target("avx512f")))
+static float fused_saxpy_dot_avx512(float a, const float* x, float* y, const float* z, size_t N){
+	return fusedSaxpyDotBody(a, x, y, z, N) ;
+}
+__attribute__((target("avx512f")))
+static void fused_element_saxpy_avx512(float a, const float* x, const float* y, const float* z, float* result, size_t N){
+	fusedElementSaxpyBody(a, x, y, z, result, N) ;
+}
+#endif
+
+// Fused pipelines compiled for the same ISA as the given backend
+static inline fused_saxpy_dot_fn fusedSaxpyDot(const SimdBackend& b){
+#if SIMD_X86
+	if(b.isa == ISA_AVX512) return fused_saxpy_dot_avx512 ;
+	if(b.isa == ISA_AVX2) return fused_saxpy_dot_avx2 ;
+#endif
+	(void)b ;
+	return fused_saxpy_dot_base ;
+}
+
+static inline fused_element_saxpy_fn fusedElementSaxpy(const SimdBackend& b){
+#if SIMD_X86
+	if(b.isa == ISA_AVX512) return fused_element_saxpy_avx512 ;
+	if(b.isa == ISA_AVX2) return fused_element_saxpy_avx2 ;
+#endif
+	(void)b ;
+	return fused_element_saxpy_base ;
+}
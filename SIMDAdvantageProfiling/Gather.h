@@ -0,0 +1,238 @@
+// Index-driven kernels that generalize saxpy_strided to irregular access:
+// gather-SAXPY (y[i] += a*x[idx[i]]), scatter-add (y[idx[i]] += a*x[i]) and
+// CSR sparse matrix-vector multiply. Each has a scalar version and AVX2 /
+// AVX-512 hardware-gather versions, and all take a software prefetch
+// distance d that touches x[idx[i+d]] ahead of use (0 disables it).
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "SimdKernels.h"
+
+typedef void (*gather_saxpy_fn)(float a, const float* x, const int32_t* idx, float* y, size_t N, size_t dist) ;
+typedef void (*scatter_add_fn)(float a, const float* x, const int32_t* idx, float* y, size_t N, size_t dist) ;
+typedef void (*spmv_fn)(size_t rows, const int32_t* rowPtr, const int32_t* col, const float* val, const float* x, float* y, size_t dist) ;
+
+struct GatherKernels {
+	const char* name ;
+	gather_saxpy_fn gather ;
+	scatter_add_fn scatter ;
+	spmv_fn spmv ;
+} ;
+
+// --------------------------------- Scalar --------------------------------
+static void gather_saxpy_scalar(float a, const float* x, const int32_t* idx, float* y, size_t N, size_t dist){
+	for(size_t i = 0; i < N; i++){
+		if(dist && i + dist < N) __builtin_prefetch(x + idx[i + dist]) ;
+		y[i] = a * x[idx[i]] + y[i] ;
+	}
+}
+
+static void scatter_add_scalar(float a, const float* x, const int32_t* idx, float* y, size_t N, size_t dist){
+	for(size_t i = 0; i < N; i++){
+		if(dist && i + dist < N) __builtin_prefetch(y + idx[i + dist], 1) ;
+		y[idx[i]] += a * x[i] ;
+	}
+}
+
+static void spmv_scalar(size_t rows, const int32_t* rowPtr, const int32_t* col, const float* val, const float* x, float* y, size_t dist){
+	size_t nnz = (size_t)rowPtr[rows] ;
+	for(size_t r = 0; r < rows; r++){
+		float sum = 0.0f ;
+		for(int32_t k = rowPtr[r]; k < rowPtr[r + 1]; k++){
+			if(dist && (size_t)k + dist < nnz) __builtin_prefetch(x + col[k + dist]) ;
+			sum += val[k] * x[col[k]] ;
+		}
+		y[r] = sum ;
+	}
+}
+
+#if SIMD_X86
+// Prefetch the x entries one vector ahead needs, lane by lane
+#define PREFETCH_LANES(base, idx, i, dist, lanes, N, rw)                          \
+	if(dist && (i) + (dist) + (lanes) <= (N)){                                    \
+		for(size_t l = 0; l < (lanes); l++) __builtin_prefetch((base) + (idx)[(i) + (dist) + l], rw) ; \
+	}
+
+// ---------------------------------- AVX2 ---------------------------------
+__attribute__((target("avx2,fma")))
+static void gather_saxpy_avx2(float a, const float* x, const int32_t* idx, float* y, size_t N, size_t dist){
+	__m256 va = _mm256_set1_ps(a) ;
+	size_t i = 0 ;
+	for(; i + 8 <= N; i += 8){
+		PREFETCH_LANES(x, idx, i, dist, 8, N, 0)
+		__m256i vi = _mm256_loadu_si256((const __m256i*)(idx + i)) ;
+		__m256 vx = _mm256_i32gather_ps(x, vi, 4) ;
+		_mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, vx, _mm256_loadu_ps(y + i))) ;
+	}
+	for(; i < N; i++) y[i] = a * x[idx[i]] + y[i] ;
+}
+
+// AVX2 has no scatter: products are vectorized, the indexed adds stay
+// scalar (which is also what keeps duplicate indices correct)
+__attribute__((target("avx2,fma")))
+static void scatter_add_avx2(float a, const float* x, const int32_t* idx, float* y, size_t N, size_t dist){
+	__m256 va = _mm256_set1_ps(a) ;
+	alignas(32) float prod[8] ;
+	size_t i = 0 ;
+	for(; i + 8 <= N; i += 8){
+		PREFETCH_LANES(y, idx, i, dist, 8, N, 1)
+		_mm256_store_ps(prod, _mm256_mul_ps(va, _mm256_loadu_ps(x + i))) ;
+		for(size_t l = 0; l < 8; l++) y[idx[i + l]] += prod[l] ;
+	}
+	for(; i < N; i++) y[idx[i]] += a * x[i] ;
+}
+
+__attribute__((target("avx2,fma")))
+static void spmv_avx2(size_t rows, const int32_t* rowPtr, const int32_t* col, const float* val, const float* x, float* y, size_t dist){
+	size_t nnz = (size_t)rowPtr[rows] ;
+	for(size_t r = 0; r < rows; r++){
+		size_t k = (size_t)rowPtr[r], end = (size_t)rowPtr[r + 1] ;
+		__m256 acc = _mm256_setzero_ps() ;
+		for(; k + 8 <= end; k += 8){
+			PREFETCH_LANES(x, col, k, dist, 8, nnz, 0)
+			__m256i vi = _mm256_loadu_si256((const __m256i*)(col + k)) ;
+			acc = _mm256_fmadd_ps(_mm256_loadu_ps(val + k), _mm256_i32gather_ps(x, vi, 4), acc) ;
+		}
+		float sum = hsum256(acc) ;
+		for(; k < end; k++) sum += val[k] * x[col[k]] ;
+		y[r] = sum ;
+	}
+}
+
+// -------------------------------- AVX-512 --------------------------------
+__attribute__((target("avx512f")))
+static void gather_saxpy_avx512(float a, const float* x, const int32_t* idx, float* y, size_t N, size_t dist){
+	__m512 va = _mm512_set1_ps(a) ;
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		PREFETCH_LANES(x, idx, i, dist, 16, N, 0)
+		__m512i vi = _mm512_loadu_si512((const void*)(idx + i)) ;
+		__m512 vx = _mm512_i32gather_ps(vi, x, 4) ;
+		_mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, vx, _mm512_loadu_ps(y + i))) ;
+	}
+	if(i < N){
+		__mmask16 m = tailMask16(N - i) ;
+		__m512i vi = _mm512_maskz_loadu_epi32(m, idx + i) ;
+		__m512 vx = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), m, vi, x, 4) ;
+		_mm512_mask_storeu_ps(y + i, m, _mm512_fmadd_ps(va, vx, _mm512_maskz_loadu_ps(m, y + i))) ;
+	}
+}
+
+// Gather-add-scatter is only valid when the 16 indices are distinct;
+// vpconflictd finds duplicates and those vectors take the scalar path
+__attribute__((target("avx512f,avx512cd")))
+static void scatter_add_avx512(float a, const float* x, const int32_t* idx, float* y, size_t N, size_t dist){
+	__m512 va = _mm512_set1_ps(a) ;
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		PREFETCH_LANES(y, idx, i, dist, 16, N, 1)
+		__m512i vi = _mm512_loadu_si512((const void*)(idx + i)) ;
+		if(_mm512_test_epi32_mask(_mm512_conflict_epi32(vi), _mm512_set1_epi32(-1)) == 0){
+			__m512 vy = _mm512_i32gather_ps(vi, y, 4) ;
+			vy = _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), vy) ;
+			_mm512_i32scatter_ps(y, vi, vy, 4) ;
+		}else{
+			for(size_t l = 0; l < 16; l++) y[idx[i + l]] += a * x[i + l] ;
+		}
+	}
+	for(; i < N; i++) y[idx[i]] += a * x[i] ;
+}
+
+__attribute__((target("avx512f")))
+static void spmv_avx512(size_t rows, const int32_t* rowPtr, const int32_t* col, const float* val, const float* x, float* y, size_t dist){
+	size_t nnz = (size_t)rowPtr[rows] ;
+	for(size_t r = 0; r < rows; r++){
+		size_t k = (size_t)rowPtr[r], end = (size_t)rowPtr[r + 1] ;
+		__m512 acc = _mm512_setzero_ps() ;
+		for(; k + 16 <= end; k += 16){
+			PREFETCH_LANES(x, col, k, dist, 16, nnz, 0)
+			__m512i vi = _mm512_loadu_si512((const void*)(col + k)) ;
+			acc = _mm512_fmadd_ps(_mm512_loadu_ps(val + k), _mm512_i32gather_ps(vi, x, 4), acc) ;
+		}
+		if(k < end){
+			__mmask16 m = tailMask16(end - k) ;
+			__m512i vi = _mm512_maskz_loadu_epi32(m, col + k) ;
+			__m512 vx = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), m, vi, x, 4) ;
+			acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, val + k), vx, acc) ;
+		}
+		y[r] = _mm512_reduce_add_ps(acc) ;
+	}
+}
+#undef PREFETCH_LANES
+#endif // SIMD_X86
+
+// Scalar plus every hardware-gather variant the host supports
+static inline std::vector<GatherKernels> gatherKernels(){
+	std::vector<GatherKernels> out = {{"scalar", gather_saxpy_scalar, scatter_add_scalar, spmv_scalar}} ;
+#if SIMD_X86
+	const CpuFeatures& f = cpuFeatures() ;
+	if(f.avx2 && f.fma) out.push_back({"avx2", gather_saxpy_avx2, scatter_add_avx2, spmv_avx2}) ;
+	if(f.avx512f && f.avx512cd) out.push_back({"avx512", gather_saxpy_avx512, scatter_add_avx512, spmv_avx512}) ;
+#endif
+	return out ;
+}
+
+// ----------------------------- Index patterns ----------------------------
+enum IndexPattern { IDX_RANDOM, IDX_CLUSTERED, IDX_SORTED } ;
+
+static inline const char* indexPatternName(IndexPattern p){
+	switch(p){
+		case IDX_RANDOM: return "random" ;
+		case IDX_CLUSTERED: return "clustered" ;
+		case IDX_SORTED: return "sorted" ;
+	}
+	return "?" ;
+}
+
+// Indices into a table of tableSize floats.
+//   random    : uniform over the table
+//   clustered : runs of 16 indices inside one random 4 KiB page
+//   sorted    : uniform, then sorted ascending (monotone but gappy)
+static inline std::vector<int32_t> makeIndices(IndexPattern p, size_t N, size_t tableSize, uint32_t seed){
+	std::vector<int32_t> idx(N) ;
+	std::mt19937 engine(seed) ;
+	std::uniform_int_distribution<int32_t> any(0, (int32_t)tableSize - 1) ;
+	if(p == IDX_CLUSTERED){
+		const int32_t page = 1024 ;
+		std::uniform_int_distribution<int32_t> inPage(0, page - 1) ;
+		int32_t base = 0 ;
+		for(size_t i = 0; i < N; i++){
+			if(i % 16 == 0) base = any(engine) / page * page ;
+			idx[i] = std::min<int32_t>(base + inPage(engine), (int32_t)tableSize - 1) ;
+		}
+	}else{
+		for(size_t i = 0; i < N; i++) idx[i] = any(engine) ;
+		if(p == IDX_SORTED) std::sort(idx.begin(), idx.end()) ;
+	}
+	return idx ;
+}
+
+// CSR matrix with nnzPerRow entries per row, columns drawn from the pattern
+struct CsrMatrix {
+	size_t rows ;
+	size_t cols ;
+	std::vector<int32_t> rowPtr ;
+	std::vector<int32_t> col ;
+	std::vector<float> val ;
+} ;
+
+static inline CsrMatrix makeCsr(IndexPattern p, size_t rows, size_t cols, size_t nnzPerRow, uint32_t seed){
+	CsrMatrix m ;
+	m.rows = rows ;
+	m.cols = cols ;
+	m.col = makeIndices(p, rows * nnzPerRow, cols, seed) ;
+	m.rowPtr.resize(rows + 1) ;
+	for(size_t r = 0; r <= rows; r++) m.rowPtr[r] = (int32_t)(r * nnzPerRow) ;
+	// Columns ascend within a row, as in any real CSR matrix
+	for(size_t r = 0; r < rows; r++) std::sort(m.col.begin() + m.rowPtr[r], m.col.begin() + m.rowPtr[r + 1]) ;
+	std::mt19937 engine(seed + 1) ;
+	std::uniform_real_distribution<float> dist(0.0, 1.0) ;
+	m.val.resize(m.col.size()) ;
+	for(float& v : m.val) v = dist(engine) ;
+	return m ;
+}
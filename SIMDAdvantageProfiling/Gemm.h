@@ -0,0 +1,411 @@
+// Register- and cache-blocked GEMV/GEMM for float and double, next to the
+// naive loops they are measured against, plus a peak FMA throughput probe.
+//
+// GEMM follows the usual Goto/BLIS layering: an NC-wide panel of B is packed
+// to live in L3, a KC x NR sliver of it in L1, and an MC x KC block of A in
+// L2; an MR x NR micro-kernel keeps C in registers. Block sizes come from the
+// host's cache sizes unless overridden. Like Reduction.h, the blocked kernels
+// are written once and instantiated per ISA in target-attributed wrappers.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <cstring>
+
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+#include "../Common/BenchResult.h"
+#include "SimdKernels.h"
+
+#define GEMM_INLINE __attribute__((always_inline)) inline
+
+// Micro-kernel shape: MR rows of C by NR columns (64 bytes of T per row)
+#define GEMM_MR 6
+template <typename T> struct GemmShape { static const size_t NR = 64 / sizeof(T) ; } ;
+
+// ------------------------------ Cache sizes ------------------------------
+struct CacheSizes {
+	size_t l1d ;
+	size_t l2 ;
+	size_t l3 ;
+} ;
+
+static inline size_t cacheSizeOr(long queried, size_t fallback){
+	return queried > 0 ? (size_t)queried : fallback ;
+}
+
+// Sizes the OS reports. Unknown or absent levels get typical sizes for
+// blocking, or stay 0 without fallback so callers can tell they are missing.
+static inline CacheSizes hostCacheSizes(bool fallback = true){
+	CacheSizes c = {32 * 1024, 1024 * 1024, 32 * 1024 * 1024} ;
+	if(!fallback) c = {0, 0, 0} ;
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+	c.l1d = cacheSizeOr(sysconf(_SC_LEVEL1_DCACHE_SIZE), c.l1d) ;
+	c.l2 = cacheSizeOr(sysconf(_SC_LEVEL2_CACHE_SIZE), c.l2) ;
+	c.l3 = cacheSizeOr(sysconf(_SC_LEVEL3_CACHE_SIZE), c.l3) ;
+#elif defined(__APPLE__)
+	int64_t v = 0 ;
+	size_t len = sizeof(v) ;
+	if(sysctlbyname("hw.l1dcachesize", &v, &len, nullptr, 0) == 0) c.l1d = cacheSizeOr((long)v, c.l1d) ;
+	len = sizeof(v) ;
+	if(sysctlbyname("hw.l2cachesize", &v, &len, nullptr, 0) == 0) c.l2 = cacheSizeOr((long)v, c.l2) ;
+	len = sizeof(v) ;
+	if(sysctlbyname("hw.l3cachesize", &v, &len, nullptr, 0) == 0) c.l3 = cacheSizeOr((long)v, c.l3) ;
+#endif
+	return c ;
+}
+
+// ------------------------------ Block sizes ------------------------------
+struct GemmBlocking {
+	size_t MC ;
+	size_t KC ;
+	size_t NC ;
+} ;
+
+// Each packed operand gets half of its target cache level; the other half
+// is left for C and whatever else is streaming through.
+template <typename T>
+static inline GemmBlocking defaultBlocking(const CacheSizes& c){
+	const size_t NR = GemmShape<T>::NR ;
+	GemmBlocking b ;
+	b.KC = std::max<size_t>(16, (c.l1d / 2) / (NR * sizeof(T))) ;
+	b.MC = std::max<size_t>(GEMM_MR, (c.l2 / 2) / (b.KC * sizeof(T)) / GEMM_MR * GEMM_MR) ;
+	b.NC = std::max<size_t>(NR, (c.l3 / 2) / (b.KC * sizeof(T)) / NR * NR) ;
+	return b ;
+}
+
+// --------------------------------- Naive ---------------------------------
+// Row-major A (M x K), B (K x N), C (M x N): C += A * B
+template <typename T>
+void gemm_naive(size_t M, size_t N, size_t K, const T* A, const T* B, T* C){
+	for(size_t i = 0; i < M; i++){
+		for(size_t j = 0; j < N; j++){
+			T sum = C[i*N + j] ;
+			for(size_t k = 0; k < K; k++){
+				sum += A[i*K + k] * B[k*N + j] ;
+			}
+			C[i*N + j] = sum ;
+		}
+	}
+}
+
+// Row-major A (M x N): y += A * x
+template <typename T>
+void gemv_naive(size_t M, size_t N, const T* A, const T* x, T* y){
+	for(size_t i = 0; i < M; i++){
+		T sum = y[i] ;
+		for(size_t j = 0; j < N; j++){
+			sum += A[i*N + j] * x[j] ;
+		}
+		y[i] = sum ;
+	}
+}
+
+// -------------------------------- Blocked --------------------------------
+// Pack an mc x kc block of A into MR-row slivers, k-major inside each sliver
+template <typename T>
+GEMM_INLINE void packA(size_t mc, size_t kc, const T* A, size_t lda, T* Ap){
+	for(size_t ir = 0; ir < mc; ir += GEMM_MR){
+		size_t mr = std::min<size_t>(GEMM_MR, mc - ir) ;
+		for(size_t k = 0; k < kc; k++){
+			for(size_t r = 0; r < GEMM_MR; r++){
+				*Ap++ = r < mr ? A[(ir + r)*lda + k] : T(0) ;
+			}
+		}
+	}
+}
+
+// Pack a kc x nc panel of B into NR-column slivers, k-major inside each sliver
+template <typename T>
+GEMM_INLINE void packB(size_t kc, size_t nc, const T* B, size_t ldb, T* Bp){
+	const size_t NR = GemmShape<T>::NR ;
+	for(size_t jr = 0; jr < nc; jr += NR){
+		size_t nr = std::min(NR, nc - jr) ;
+		for(size_t k = 0; k < kc; k++){
+			for(size_t c = 0; c < NR; c++){
+				*Bp++ = c < nr ? B[k*ldb + jr + c] : T(0) ;
+			}
+		}
+	}
+}
+
+// MR x NR block of C kept in registers across the whole kc loop. VB is the
+// native vector size in bytes of the ISA being compiled for, so one row of
+// the block is 64/VB real registers rather than a generic wide vector the
+// compiler would spill.
+template <typename T, int VB>
+GEMM_INLINE void microKernel(size_t kc, const T* Ap, const T* Bp, T* C, size_t ldc, size_t mr, size_t nr){
+	const size_t NR = GemmShape<T>::NR ;
+	const int PER_ROW = 64 / VB ;
+	const int W = VB / (int)sizeof(T) ;
+	typedef T Vec __attribute__((vector_size(VB))) ;
+	typedef T VecU __attribute__((vector_size(VB), aligned(sizeof(T)))) ;
+	// Accumulators are only touched by value or lane index; taking their
+	// address makes GCC keep them in memory across the k loop
+	Vec acc[GEMM_MR][PER_ROW] ;
+	for(size_t r = 0; r < GEMM_MR; r++){
+		for(int v = 0; v < PER_ROW; v++) acc[r][v] = Vec{} ;
+	}
+	for(size_t k = 0; k < kc; k++){
+		Vec b[PER_ROW] ;
+		for(int v = 0; v < PER_ROW; v++) b[v] = *(const VecU*)(Bp + k*NR + v*W) ;
+		for(size_t r = 0; r < GEMM_MR; r++){
+			T a = Ap[k*GEMM_MR + r] ;
+			for(int v = 0; v < PER_ROW; v++) acc[r][v] += a * b[v] ;
+		}
+	}
+	for(size_t r = 0; r < mr; r++){
+		for(size_t c = 0; c < nr; c++) C[r*ldc + c] += acc[r][c / W][c % W] ;
+	}
+}
+
+// Packing buffers, kept per thread and only ever grown, so the timed calls
+// after the first allocate nothing
+template <typename T>
+struct GemmWorkspace {
+	std::vector<T> Ap ;
+	std::vector<T> Bp ;
+} ;
+
+template <typename T>
+static inline GemmWorkspace<T>& gemmWorkspace(size_t apSize, size_t bpSize){
+	static thread_local GemmWorkspace<T> ws ;
+	if(ws.Ap.size() < apSize) ws.Ap.resize(apSize) ;
+	if(ws.Bp.size() < bpSize) ws.Bp.resize(bpSize) ;
+	return ws ;
+}
+
+template <typename T, int VB>
+GEMM_INLINE void gemmBlockedBody(size_t M, size_t N, size_t K, const T* A, const T* B, T* C, const GemmBlocking& bs){
+	const size_t NR = GemmShape<T>::NR ;
+	size_t mcMax = std::min(bs.MC, (M + GEMM_MR - 1) / GEMM_MR * GEMM_MR) ;
+	size_t ncMax = std::min(bs.NC, (N + NR - 1) / NR * NR) ;
+	size_t kcMax = std::min(bs.KC, K) ;
+	GemmWorkspace<T>& ws = gemmWorkspace<T>(mcMax * kcMax, kcMax * ncMax) ;
+	T* Ap = ws.Ap.data() ;
+	T* Bp = ws.Bp.data() ;
+
+	for(size_t jc = 0; jc < N; jc += bs.NC){
+		size_t nc = std::min(bs.NC, N - jc) ;
+		for(size_t pc = 0; pc < K; pc += bs.KC){
+			size_t kc = std::min(bs.KC, K - pc) ;
+			packB(kc, nc, B + pc*N + jc, N, Bp) ;
+			for(size_t ic = 0; ic < M; ic += bs.MC){
+				size_t mc = std::min(bs.MC, M - ic) ;
+				packA(mc, kc, A + ic*K + pc, K, Ap) ;
+				for(size_t jr = 0; jr < nc; jr += NR){
+					for(size_t ir = 0; ir < mc; ir += GEMM_MR){
+						microKernel<T, VB>(kc, Ap + ir*kc, Bp + jr*kc,
+								C + (ic + ir)*N + jc + jr, N,
+								std::min<size_t>(GEMM_MR, mc - ir), std::min(NR, nc - jr)) ;
+					}
+				}
+			}
+		}
+	}
+}
+
+// GEMV: GEMV_ROWS rows share every load of x, and x is walked in KC-long
+// column blocks so the slice being reused stays in L1
+#define GEMV_ROWS 4
+#define GEMV_LANES 16
+
+template <typename T>
+GEMM_INLINE void gemvBlockedBody(size_t M, size_t N, const T* A, const T* x, T* y, const GemmBlocking& bs){
+	size_t kb = std::max<size_t>(GEMV_LANES, bs.KC * GemmShape<T>::NR / GEMV_LANES * GEMV_LANES) ;
+	for(size_t jb = 0; jb < N; jb += kb){
+		size_t jend = std::min(N, jb + kb) ;
+		size_t i = 0 ;
+		for(; i + GEMV_ROWS <= M; i += GEMV_ROWS){
+			T acc[GEMV_ROWS][GEMV_LANES] = {} ;
+			size_t j = jb ;
+			for(; j + GEMV_LANES <= jend; j += GEMV_LANES){
+				for(size_t r = 0; r < GEMV_ROWS; r++){
+					for(size_t l = 0; l < GEMV_LANES; l++) acc[r][l] += A[(i + r)*N + j + l] * x[j + l] ;
+				}
+			}
+			for(size_t r = 0; r < GEMV_ROWS; r++){
+				T sum = 0 ;
+				for(size_t l = 0; l < GEMV_LANES; l++) sum += acc[r][l] ;
+				for(size_t jt = j; jt < jend; jt++) sum += A[(i + r)*N + jt] * x[jt] ;
+				y[i + r] += sum ;
+			}
+		}
+		for(; i < M; i++){
+			T sum = 0 ;
+			for(size_t j = jb; j < jend; j++) sum += A[i*N + j] * x[j] ;
+			y[i] += sum ;
+		}
+	}
+}
+
+// Per-ISA instantiations
+template <typename T>
+static void gemm_blocked_base(size_t M, size_t N, size_t K, const T* A, const T* B, T* C, const GemmBlocking& bs){
+	gemmBlockedBody<T, 16>(M, N, K, A, B, C, bs) ;
+}
+template <typename T>
+static void gemv_blocked_base(size_t M, size_t N, const T* A, const T* x, T* y, const GemmBlocking& bs){
+	gemvBlockedBody(M, N, A, x, y, bs) ;
+}
+
+#if SIMD_X86
+template <typename T>
+__attribute__((target("avx2,fma")))
+static void gemm_blocked_avx2(size_t M, size_t N, size_t K, const T* A, const T* B, T* C, const GemmBlocking& bs){
+	gemmBlockedBody<T, 32>(M, N, K, A, B, C, bs) ;
+}
+template <typename T>
+__attribute__((target("avx2,fma")))
+static void gemv_blocked_avx2(size_t M, size_t N, const T* A, const T* x, T* y, const GemmBlocking& bs){
+	gemvBlockedBody(M, N, A, x, y, bs) ;
+}
+template <typename T>
+__attribute__((target("avx512f")))
+static void gemm_blocked_avx512(size_t M, size_t N, size_t K, const T* A, const T* B, T* C, const GemmBlocking& bs){
+	gemmBlockedBody<T, 64>(M, N, K, A, B, C, bs) ;
+}
+template <typename T>
+__attribute__((target("avx512f")))
+static void gemv_blocked_avx512(size_t M, size_t N, const T* A, const T* x, T* y, const GemmBlocking& bs){
+	gemvBlockedBody(M, N, A, x, y, bs) ;
+}
+#endif
+
+template <typename T>
+struct GemmKernels {
+	void (*gemm)(size_t M, size_t N, size_t K, const T* A, const T* B, T* C, const GemmBlocking& bs) ;
+	void (*gemv)(size_t M, size_t N, const T* A, const T* x, T* y, const GemmBlocking& bs) ;
+} ;
+
+template <typename T>
+static inline GemmKernels<T> gemmKernels(const SimdBackend& b){
+#if SIMD_X86
+	if(b.isa == ISA_AVX512) return {gemm_blocked_avx512<T>, gemv_blocked_avx512<T>} ;
+	if(b.isa == ISA_AVX2) return {gemm_blocked_avx2<T>, gemv_blocked_avx2<T>} ;
+#endif
+	(void)b ;
+	return {gemm_blocked_base<T>, gemv_blocked_base<T>} ;
+}
+
+// --------------------------- Peak FMA throughput -------------------------
+// PEAK_CHAINS independent accumulators cover FMA latency x FMA ports on
+// current cores (4 cycles x 2 ports). Returns GFLOP/s, counting an FMA as 2.
+#define PEAK_CHAINS 12
+#define PEAK_ITERS 20000000ull
+
+static volatile double peakSink ;
+
+#if SIMD_X86
+#define DEFINE_PEAK_FMA(fn, tgt, VT, ET, lanes, set1, fmadd, add)            \
+	__attribute__((target(tgt))) static double fn(uint64_t iters){           \
+		VT acc[PEAK_CHAINS] ;                                                \
+		for(int k = 0; k < PEAK_CHAINS; k++) acc[k] = set1((ET)(k + 1)) ;    \
+		VT m = set1((ET)0.999999), c = set1((ET)1e-6) ;                      \
+		for(uint64_t it = 0; it < iters; it++){                              \
+			for(int k = 0; k < PEAK_CHAINS; k++) acc[k] = fmadd(acc[k], m, c) ; \
+		}                                                                    \
+		for(int k = 1; k < PEAK_CHAINS; k++) acc[0] = add(acc[0], acc[k]) ;  \
+		ET out[lanes] ;                                                      \
+		std::memcpy(out, &acc[0], sizeof(out)) ;                             \
+		peakSink = (double)out[0] ;                                          \
+		return 2.0 * PEAK_CHAINS * lanes * (double)iters ;                   \
+	}
+
+__attribute__((target("sse2"))) static inline __m128 sse_fma_ps(__m128 a, __m128 b, __m128 c){ return _mm_add_ps(_mm_mul_ps(a, b), c) ; }
+__attribute__((target("sse2"))) static inline __m128d sse_fma_pd(__m128d a, __m128d b, __m128d c){ return _mm_add_pd(_mm_mul_pd(a, b), c) ; }
+
+DEFINE_PEAK_FMA(peak_sse2_ps, "sse2", __m128, float, 4, _mm_set1_ps, sse_fma_ps, _mm_add_ps)
+DEFINE_PEAK_FMA(peak_sse2_pd, "sse2", __m128d, double, 2, _mm_set1_pd, sse_fma_pd, _mm_add_pd)
+DEFINE_PEAK_FMA(peak_avx2_ps, "avx2,fma", __m256, float, 8, _mm256_set1_ps, _mm256_fmadd_ps, _mm256_add_ps)
+DEFINE_PEAK_FMA(peak_avx2_pd, "avx2,fma", __m256d, double, 4, _mm256_set1_pd, _mm256_fmadd_pd, _mm256_add_pd)
+DEFINE_PEAK_FMA(peak_avx512_ps, "avx512f", __m512, float, 16, _mm512_set1_ps, _mm512_fmadd_ps, _mm512_add_ps)
+DEFINE_PEAK_FMA(peak_avx512_pd, "avx512f", __m512d, double, 8, _mm512_set1_pd, _mm512_fmadd_pd, _mm512_add_pd)
+#undef DEFINE_PEAK_FMA
+#endif
+
+#if SIMD_NEON
+static double peak_neon_ps(uint64_t iters){
+	float32x4_t acc[PEAK_CHAINS] ;
+	for(int k = 0; k < PEAK_CHAINS; k++) acc[k] = vdupq_n_f32((float)(k + 1)) ;
+	float32x4_t m = vdupq_n_f32(0.999999f), c = vdupq_n_f32(1e-6f) ;
+	for(uint64_t it = 0; it < iters; it++){
+		for(int k = 0; k < PEAK_CHAINS; k++) acc[k] = vfmaq_f32(c, acc[k], m) ;
+	}
+	for(int k = 1; k < PEAK_CHAINS; k++) acc[0] = vaddq_f32(acc[0], acc[k]) ;
+	peakSink = vgetq_lane_f32(acc[0], 0) ;
+	return 2.0 * PEAK_CHAINS * 4 * (double)iters ;
+}
+
+static double peak_neon_pd(uint64_t iters){
+	float64x2_t acc[PEAK_CHAINS] ;
+	for(int k = 0; k < PEAK_CHAINS; k++) acc[k] = vdupq_n_f64((double)(k + 1)) ;
+	float64x2_t m = vdupq_n_f64(0.999999), c = vdupq_n_f64(1e-6) ;
+	for(uint64_t it = 0; it < iters; it++){
+		for(int k = 0; k < PEAK_CHAINS; k++) acc[k] = vfmaq_f64(c, acc[k], m) ;
+	}
+	for(int k = 1; k < PEAK_CHAINS; k++) acc[0] = vaddq_f64(acc[0], acc[k]) ;
+	peakSink = vgetq_lane_f64(acc[0], 0) ;
+	return 2.0 * PEAK_CHAINS * 2 * (double)iters ;
+}
+#endif
+
+typedef double (*peak_fn)(uint64_t iters) ;
+
+// FMA kernel of the given ISA and precision, or nullptr if none exists
+static inline peak_fn peakKernel(SimdIsa isa, bool doublePrecision){
+	switch(isa){
+#if SIMD_X86
+		case ISA_SSE2: return doublePrecision ? peak_sse2_pd : peak_sse2_ps ;
+		case ISA_AVX2: return doublePrecision ? peak_avx2_pd : peak_avx2_ps ;
+		case ISA_AVX512: return doublePrecision ? peak_avx512_pd : peak_avx512_ps ;
+#endif
+#if SIMD_NEON
+		case ISA_NEON: return doublePrecision ? peak_neon_pd : peak_neon_ps ;
+#endif
+		default: return nullptr ;
+	}
+}
+
+// Nominal core clock in Hz: cpufreq's maximum, else "cpu MHz" from
+// /proc/cpuinfo, else the TSC rate (the base clock on most x86 parts)
+static inline double nominalClockHz(){
+	char line[256] ;
+	benchReadLine("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq", line, sizeof(line)) ;
+	if(atof(line) > 0.0) return atof(line) * 1e3 ;
+	FILE* f = fopen("/proc/cpuinfo", "r") ;
+	if(f){
+		double mhz = 0.0 ;
+		while(mhz <= 0.0 && fgets(line, sizeof(line), f)){
+			const char* colon = strchr(line, ':') ;
+			if(colon && strncmp(line, "cpu MHz", 7) == 0) mhz = atof(colon + 1) ;
+		}
+		fclose(f) ;
+		if(mhz > 0.0) return mhz * 1e6 ;
+	}
+	return benchTickHz() ;
+}
+
+// Theoretical single-core peak in GFLOP/s: clock x FMA ports x lanes x 2.
+// Two FMA ports for AVX2/AVX-512/NEON (parts with one 512-bit port reach
+// half); SSE2 has no FMA, so its separate mul and add ports count as one.
+// 0 when the ISA or the clock is unknown.
+static inline double theoreticalGflops(SimdIsa isa, bool doublePrecision){
+	double bytes = 0.0, ports = 2.0 ;
+	switch(isa){
+		case ISA_SSE2: bytes = 16.0 ; ports = 1.0 ; break ;
+		case ISA_AVX2: bytes = 32.0 ; break ;
+		case ISA_AVX512: bytes = 64.0 ; break ;
+		case ISA_NEON: bytes = 16.0 ; break ;
+		default: return 0.0 ;
+	}
+	double lanes = bytes / (doublePrecision ? 8.0 : 4.0) ;
+	return nominalClockHz() * ports * lanes * 2.0 / 1e9 ;
+}
@@ -0,0 +1,306 @@
+// Timing harness for the SIMD tests. A measurement is a set of samples; each
+// sample repeats the kernel enough times to run for at least minSampleSec so
+// clock resolution and call overhead vanish, and the calibration pass that
+// finds that count doubles as warm-up. Cold runs instead flush the caches
+// with a large buffer before every single call. Per-call time is reported as
+// min/median/p90/p99/mean/stddev in ns, next to raw ticks of the hardware
+// counter and, with --counters, perf_event counts per call; every record
+// goes out as one CSV row or JSON object and, with --results, as a record
+// of the raw per-call samples in the shared schema of Common/BenchResult.h.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../Common/BenchResult.h"
+#include "../Common/PerfCounters.h"
+
+// The shared clock: hardware ticks (benchTicks, the TSC on x86 or the
+// virtual counter on AArch64) scaled by a rate calibrated against
+// CLOCK_MONOTONIC
+static inline double nowSeconds(){
+	return (double)benchClockNs() * 1e-9 ;
+}
+
+enum OutputFormat { OUT_CSV, OUT_JSON } ;
+
+struct HarnessOptions {
+	double minSampleSec = 0.01 ;	// warm samples repeat the kernel at least this long
+	int samples = 15 ;
+	int minSamples = 5 ;			// kept even when the budget runs out
+	double budgetSec = 2.0 ;		// per measurement, calibration excluded
+	bool cold = false ;				// flush caches before each call, one call per sample
+	size_t flushBytes = 64u << 20 ;
+	OutputFormat format = OUT_CSV ;
+} ;
+
+// Seconds per kernel call, plus median ticks per call
+struct TimingStats {
+	int samples ;
+	uint64_t iters ;				// calls per sample
+	double min ;
+	double median ;
+	double p90 ;
+	double p99 ;
+	double mean ;
+	double stddev ;
+	double ticks ;
+	double counters[PC_COUNT] ;	// mean per call over all samples
+	bool counterValid[PC_COUNT] ;
+	std::vector<double> perCall ;	// seconds per call of each sample, in run order
+} ;
+
+// Linear interpolation between closest ranks of a sorted sample
+static inline double quantile(const std::vector<double>& sorted, double q){
+	if(sorted.empty()) return 0.0 ;
+	double pos = q * (double)(sorted.size() - 1) ;
+	size_t lo = (size_t)pos ;
+	size_t hi = std::min(lo + 1, sorted.size() - 1) ;
+	return sorted[lo] + (pos - (double)lo) * (sorted[hi] - sorted[lo]) ;
+}
+
+// One key/value in a record. Numbers stay unquoted in JSON.
+struct Field {
+	std::string key ;
+	std::string value ;
+	bool numeric ;
+	Field(const char* k, const char* v) : key(k), value(v), numeric(false) {}
+	Field(const char* k, const std::string& v) : key(k), value(v), numeric(false) {}
+	Field(const char* k, double v) : key(k), value(formatNumber(v)), numeric(true) {}
+	Field(const char* k, int v) : Field(k, (double)v) {}
+	Field(const char* k, size_t v) : Field(k, (double)v) {}
+
+	static std::string formatNumber(double v){
+		char buf[32] ;
+		if(!std::isfinite(v)) return "null" ;
+		if(v == std::floor(v) && std::fabs(v) < 1e15) std::snprintf(buf, sizeof(buf), "%.0f", v) ;
+		else std::snprintf(buf, sizeof(buf), "%.6g", v) ;
+		return buf ;
+	}
+} ;
+typedef std::vector<Field> Fields ;
+
+class Harness {
+public:
+	HarnessOptions opts ;
+
+	explicit Harness(std::ostream& os = std::cout) : out(os) {}
+	~Harness(){
+		countThreads({}) ;
+		perfCountersClose(&counters) ;
+		benchResultsClose(&results) ;
+	}
+
+	// Opens the perf_event counters; records then carry per-call counts
+	void enableCounters(){ perfCountersOpen(&counters, 0) ; }
+
+	// Adds these threads' counts to every sample until the next call; an
+	// empty list detaches. For pool workers, which outlive every sample, so
+	// inherited counters would only see their work once they exit.
+	void countThreads(const std::vector<int>& tids){
+		for(perf_counters_t& pc : threadCounters) perfCountersClose(&pc) ;
+		threadCounters.clear() ;
+		// nothing to add where the calling thread got no counter either
+		if(std::none_of(counters.fd, counters.fd + PC_COUNT, [](int fd){ return fd >= 0 ; })) return ;
+		for(int tid : tids){
+			threadCounters.push_back(perf_counters_t()) ;
+			perfCountersOpenThread(&threadCounters.back(), tid, 0) ;
+		}
+	}
+
+	// Appends every record's samples to path as well (--results)
+	bool openResults(const char* path){ return benchResultsOpen(&results, path) == 0 ; }
+
+	TimingStats measure(const std::function<void()>& f){
+		uint64_t iters = opts.cold ? 1 : calibrate(f) ;
+		std::vector<double> secs, ticks ;
+		double counts[PC_COUNT] = {} ;
+		bool countValid[PC_COUNT] ;
+		std::fill(countValid, countValid + PC_COUNT, true) ;
+		double start = nowSeconds() ;
+		for(int s = 0; s < opts.samples; s++){
+			if(s >= opts.minSamples && nowSeconds() - start > opts.budgetSec) break ;
+			if(opts.cold) flushCaches() ;
+			perfCountersStart(&counters) ;
+			for(perf_counters_t& pc : threadCounters) perfCountersStart(&pc) ;
+			uint64_t t0 = benchTicks() ;
+			double s0 = nowSeconds() ;
+			for(uint64_t i = 0; i < iters; i++) f() ;
+			double s1 = nowSeconds() ;
+			uint64_t t1 = benchTicks() ;
+			perfCountersStop(&counters) ;
+			for(perf_counters_t& pc : threadCounters) perfCountersStop(&pc) ;
+			for(int c = 0; c < PC_COUNT; c++){
+				counts[c] += counters.value[c] ;
+				countValid[c] = countValid[c] && counters.valid[c] ;
+				for(const perf_counters_t& pc : threadCounters){
+					counts[c] += pc.value[c] ;
+					countValid[c] = countValid[c] && pc.valid[c] ;
+				}
+			}
+			secs.push_back((s1 - s0) / (double)iters) ;
+			ticks.push_back((double)(t1 - t0) / (double)iters) ;
+		}
+		TimingStats t = summarize(secs, ticks, iters) ;
+		for(int c = 0; c < PC_COUNT; c++){
+			t.counterValid[c] = t.samples > 0 && countValid[c] ;
+			t.counters[c] = t.counterValid[c] ? counts[c] / ((double)t.samples * (double)iters) : 0.0 ;
+		}
+		return t ;
+	}
+
+	// One result row: what ran (test, kernel, params), how long, and the
+	// rates derived from the median (metrics)
+	void record(const char* test, const std::string& kernel, const Fields& params, const TimingStats& t, const Fields& metrics){
+		if(opts.format == OUT_JSON) recordJson(test, kernel, params, t, metrics) ;
+		else recordCsv(test, kernel, params, t, metrics) ;
+		recordShared(test, kernel, params, t) ;
+		records++ ;
+	}
+
+	// Closes the JSON array; a no-op for CSV
+	void finish(){
+		if(opts.format != OUT_JSON) return ;
+		out << (records ? "\n]\n" : "[]\n") ;
+		out.flush() ;
+	}
+
+private:
+	std::ostream& out ;
+	std::vector<unsigned char> flushBuf ;
+	size_t records = 0 ;
+	volatile unsigned char flushSink = 0 ;
+	perf_counters_t counters = {} ;
+	std::vector<perf_counters_t> threadCounters ;
+	bench_results_t results = {} ;
+
+	// Doubles the call count until one batch runs minSampleSec, then scales
+	// the last count to the target. A batch too quick for the clock to tick
+	// (elapsed 0) gives no rate to scale by, so it only keeps doubling.
+	uint64_t calibrate(const std::function<void()>& f){
+		uint64_t iters = 1 ;
+		for(;;){
+			double s0 = nowSeconds() ;
+			for(uint64_t i = 0; i < iters; i++) f() ;
+			double elapsed = nowSeconds() - s0 ;
+			if(elapsed >= opts.minSampleSec) return iters ;
+			bool scalable = elapsed > 0.0 ;
+			if(scalable && elapsed * 10.0 >= opts.minSampleSec) return scaled(iters, elapsed) ;
+			if(iters >= ((uint64_t)1 << 30)) return scalable ? scaled(iters, elapsed) : iters ;
+			iters *= 2 ;
+		}
+	}
+
+	uint64_t scaled(uint64_t iters, double elapsed) const {
+		return std::max<uint64_t>(iters, (uint64_t)std::ceil(iters * opts.minSampleSec / elapsed)) ;
+	}
+
+	// Read-modify-write every line of a buffer larger than the LLC so the
+	// next call starts from DRAM
+	void flushCaches(){
+		if(flushBuf.size() != opts.flushBytes) flushBuf.assign(opts.flushBytes, 1) ;
+		unsigned char acc = 0 ;
+		for(size_t i = 0; i < flushBuf.size(); i += 64){
+			flushBuf[i]++ ;
+			acc ^= flushBuf[i] ;
+		}
+		flushSink = acc ;
+	}
+
+	static TimingStats summarize(std::vector<double> secs, std::vector<double> ticks, uint64_t iters){
+		TimingStats t = {} ;
+		t.samples = (int)secs.size() ;
+		t.iters = iters ;
+		t.perCall = secs ;
+		if(secs.empty()) return t ;
+		double sum = 0.0 ;
+		for(double s : secs) sum += s ;
+		t.mean = sum / secs.size() ;
+		double var = 0.0 ;
+		for(double s : secs) var += (s - t.mean) * (s - t.mean) ;
+		t.stddev = secs.size() > 1 ? std::sqrt(var / (secs.size() - 1)) : 0.0 ;
+		std::sort(secs.begin(), secs.end()) ;
+		std::sort(ticks.begin(), ticks.end()) ;
+		t.min = secs.front() ;
+		t.median = quantile(secs, 0.5) ;
+		t.p90 = quantile(secs, 0.9) ;
+		t.p99 = quantile(secs, 0.99) ;
+		t.ticks = quantile(ticks, 0.5) ;
+		return t ;
+	}
+
+	// Params and metrics vary per test, so CSV packs them as key=value;...
+	// into one column each to keep a single fixed header
+	void recordCsv(const char* test, const std::string& kernel, const Fields& params, const TimingStats& t, const Fields& metrics){
+		if(!records){
+			out << "test,kernel,params,samples,iters,min_ns,median_ns,p90_ns,p99_ns,mean_ns,stddev_ns,median_ticks,metrics"
+				<< perfCountersCsvHeader(&counters) << "\n" ;
+		}
+		out << test << "," << kernel << "," << packed(params) << "," << t.samples << "," << t.iters << ","
+			<< Field::formatNumber(t.min * 1e9) << "," << Field::formatNumber(t.median * 1e9) << ","
+			<< Field::formatNumber(t.p90 * 1e9) << "," << Field::formatNumber(t.p99 * 1e9) << ","
+			<< Field::formatNumber(t.mean * 1e9) << "," << Field::formatNumber(t.stddev * 1e9) << ","
+			<< Field::formatNumber(t.ticks) << "," << packed(metrics) ;
+		for(int c = 0; counters.enabled && c < PC_COUNT; c++){
+			out << "," << (t.counterValid[c] ? Field::formatNumber(t.counters[c]) : "") ;
+		}
+		out << "\n" ;
+	}
+
+	void recordJson(const char* test, const std::string& kernel, const Fields& params, const TimingStats& t, const Fields& metrics){
+		out << (records ? ",\n" : "[\n") ;
+		out << "{\"test\":\"" << test << "\",\"kernel\":\"" << kernel << "\",\"params\":" << object(params)
+			<< ",\"samples\":" << t.samples << ",\"iters\":" << t.iters
+			<< ",\"ns\":{\"min\":" << Field::formatNumber(t.min * 1e9) << ",\"median\":" << Field::formatNumber(t.median * 1e9)
+			<< ",\"p90\":" << Field::formatNumber(t.p90 * 1e9) << ",\"p99\":" << Field::formatNumber(t.p99 * 1e9)
+			<< ",\"mean\":" << Field::formatNumber(t.mean * 1e9) << ",\"stddev\":" << Field::formatNumber(t.stddev * 1e9)
+			<< "},\"median_ticks\":" << Field::formatNumber(t.ticks) << ",\"metrics\":" << object(metrics) ;
+		if(counters.enabled){
+			Fields per ;
+			for(int c = 0; c < PC_COUNT; c++) per.push_back(Field(perfCounterNames[c], t.counterValid[c] ? t.counters[c] : NAN)) ;
+			out << ",\"counters\":" << object(per) ;
+		}
+		out << "}" ;
+	}
+
+	// benchmark simd.<test>, the kernel and params as parameters, ns per call
+	void recordShared(const char* test, const std::string& kernel, const Fields& params, const TimingStats& t){
+		if(!results.file) return ;
+		benchResultBegin(&results, ("simd." + std::string(test)).c_str(), "ns_per_call", 1) ;
+		benchResultParam(&results, "kernel", kernel.c_str()) ;
+		for(const Field& f : params){
+			if(f.numeric) benchResultParamNum(&results, f.key.c_str(), std::atof(f.value.c_str())) ;
+			else benchResultParam(&results, f.key.c_str(), f.value.c_str()) ;
+		}
+		benchResultParam(&results, "mode", opts.cold ? "cold" : "warm") ;
+		for(double s : t.perCall) benchResultSample(&results, s * 1e9) ;
+		benchResultEnd(&results) ;
+	}
+
+	static std::string packed(const Fields& fields){
+		std::string s ;
+		for(size_t i = 0; i < fields.size(); i++){
+			if(i) s += ";" ;
+			s += fields[i].key + "=" + fields[i].value ;
+		}
+		return s ;
+	}
+
+	static std::string object(const Fields& fields){
+		std::string s = "{" ;
+		for(size_t i = 0; i < fields.size(); i++){
+			if(i) s += "," ;
+			s += "\"" + fields[i].key + "\":" ;
+			s += fields[i].numeric ? fields[i].value : "\"" + fields[i].value + "\"" ;
+		}
+		return s + "}" ;
+	}
+} ;
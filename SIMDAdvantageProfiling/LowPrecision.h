@@ -0,0 +1,325 @@
+// Reduced-precision storage types (fp16, bf16, int8) for the saxpy_dataTyped
+// templates. Data is stored narrow and widened for arithmetic: fp16/bf16
+// compute and accumulate in fp32, int8 in int32. StorageTraits describes the
+// conversion so the generic templates work for every type; hand-written
+// F16C / AVX-512 BF16 / VNNI kernels are picked at runtime when available.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "SimdKernels.h"
+
+struct half_t { uint16_t bits ; } ;
+struct bf16_t { uint16_t bits ; } ;
+
+// ------------------------- Portable conversions --------------------------
+static inline float halfToFloat(uint16_t h){
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16 ;
+	uint32_t exp = (h >> 10) & 0x1f ;
+	uint32_t mant = h & 0x3ff ;
+	uint32_t bits ;
+	if(exp == 0){
+		if(mant == 0){
+			bits = sign ;
+		}else{
+			// Subnormal half: normalize into a float exponent
+			exp = 113 ;
+			while((mant & 0x400) == 0){ mant <<= 1 ; exp-- ; }
+			bits = sign | (exp << 23) | ((mant & 0x3ff) << 13) ;
+		}
+	}else if(exp == 31){
+		bits = sign | 0x7f800000 | (mant << 13) ;
+	}else{
+		bits = sign | ((exp + 112) << 23) | (mant << 13) ;
+	}
+	float f ;
+	std::memcpy(&f, &bits, sizeof(f)) ;
+	return f ;
+}
+
+// Round to nearest even, matching vcvtps2ph with _MM_FROUND_TO_NEAREST_INT
+static inline uint16_t floatToHalf(float f){
+	uint32_t x ;
+	std::memcpy(&x, &f, sizeof(x)) ;
+	uint32_t sign = (x >> 16) & 0x8000 ;
+	uint32_t absx = x & 0x7fffffff ;
+	if(absx >= 0x7f800000) return (uint16_t)(sign | 0x7c00 | (absx > 0x7f800000 ? 0x200 : 0)) ;
+	if(absx >= 0x477ff000) return (uint16_t)(sign | 0x7c00) ;
+	if(absx < 0x38800000){
+		if(absx < 0x33000000) return (uint16_t)sign ;
+		uint32_t e = absx >> 23 ;
+		uint32_t m = (absx & 0x7fffff) | 0x800000 ;
+		uint32_t shift = 126 - e ;
+		uint32_t h = m >> shift ;
+		uint32_t rem = m & ((1u << shift) - 1) ;
+		uint32_t halfway = 1u << (shift - 1) ;
+		if(rem > halfway || (rem == halfway && (h & 1))) h++ ;
+		return (uint16_t)(sign | h) ;
+	}
+	uint32_t h = (absx >> 13) - (112u << 10) ;
+	uint32_t rem = absx & 0x1fff ;
+	if(rem > 0x1000 || (rem == 0x1000 && (h & 1))) h++ ;
+	return (uint16_t)(sign | h) ;
+}
+
+static inline float bf16ToFloat(uint16_t b){
+	uint32_t bits = (uint32_t)b << 16 ;
+	float f ;
+	std::memcpy(&f, &bits, sizeof(f)) ;
+	return f ;
+}
+
+// Round to nearest even, matching vcvtneps2bf16
+static inline uint16_t floatToBf16(float f){
+	uint32_t x ;
+	std::memcpy(&x, &f, sizeof(x)) ;
+	if((x & 0x7fffffff) > 0x7f800000) return (uint16_t)((x >> 16) | 0x40) ;
+	x += 0x7fff + ((x >> 16) & 1) ;
+	return (uint16_t)(x >> 16) ;
+}
+
+static inline int8_t saturateInt8(int32_t v){
+	return (int8_t)(v < -128 ? -128 : (v > 127 ? 127 : v)) ;
+}
+
+// ---------------------------- Storage traits -----------------------------
+// Acc is the type arithmetic and accumulation happen in
+template <typename T> struct StorageTraits {
+	typedef T Acc ;
+	static Acc load(T v){ return v ; }
+	static T store(Acc v){ return v ; }
+} ;
+
+template <> struct StorageTraits<half_t> {
+	typedef float Acc ;
+	static Acc load(half_t v){ return halfToFloat(v.bits) ; }
+	static half_t store(Acc v){ return half_t{floatToHalf(v)} ; }
+} ;
+
+template <> struct StorageTraits<bf16_t> {
+	typedef float Acc ;
+	static Acc load(bf16_t v){ return bf16ToFloat(v.bits) ; }
+	static bf16_t store(Acc v){ return bf16_t{floatToBf16(v)} ; }
+} ;
+
+template <> struct StorageTraits<int8_t> {
+	typedef int32_t Acc ;
+	static Acc load(int8_t v){ return v ; }
+	static int8_t store(Acc v){ return saturateInt8(v) ; }
+} ;
+
+// ------------------------- Hand-written kernels --------------------------
+template <typename T>
+struct LowPrecisionKernels {
+	typedef typename StorageTraits<T>::Acc Acc ;
+	const char* name ;
+	void (*saxpy)(Acc a, const T* x, T* y, size_t N) ;
+	Acc (*dot)(const T* x, const T* y, size_t N) ;
+} ;
+
+#if SIMD_X86
+// fp16 via F16C: 8 halves widen to one ymm of floats
+__attribute__((target("avx2,fma,f16c")))
+static void saxpy_fp16_f16c(float a, const half_t* x, half_t* y, size_t N){
+	__m256 va = _mm256_set1_ps(a) ;
+	size_t i = 0 ;
+	for(; i + 8 <= N; i += 8){
+		__m256 vx = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(x + i))) ;
+		__m256 vy = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(y + i))) ;
+		_mm_storeu_si128((__m128i*)(y + i), _mm256_cvtps_ph(_mm256_fmadd_ps(va, vx, vy), _MM_FROUND_TO_NEAREST_INT)) ;
+	}
+	for(; i < N; i++) y[i].bits = floatToHalf(a * halfToFloat(x[i].bits) + halfToFloat(y[i].bits)) ;
+}
+
+__attribute__((target("avx2,fma,f16c")))
+static float dot_fp16_f16c(const half_t* x, const half_t* y, size_t N){
+	__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps() ;
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		acc0 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(x + i))),
+				_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(y + i))), acc0) ;
+		acc1 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(x + i + 8))),
+				_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(y + i + 8))), acc1) ;
+	}
+	float sum = hsum256(_mm256_add_ps(acc0, acc1)) ;
+	for(; i < N; i++) sum += halfToFloat(x[i].bits) * halfToFloat(y[i].bits) ;
+	return sum ;
+}
+
+// bf16 widen is a 16-bit shift, so AVX2 handles loads; the narrowing store
+// does round-to-nearest-even in integer lanes
+__attribute__((target("avx2,fma")))
+static inline __m256 loadBf16x8(const bf16_t* p){
+	__m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p)) ;
+	return _mm256_castsi256_ps(_mm256_slli_epi32(w, 16)) ;
+}
+
+__attribute__((target("avx2,fma")))
+static inline void storeBf16x8(bf16_t* p, __m256 v){
+	__m256i x = _mm256_castps_si256(v) ;
+	__m256i lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(1)) ;
+	x = _mm256_add_epi32(x, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7fff))) ;
+	x = _mm256_srli_epi32(x, 16) ;
+	__m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1)) ;
+	_mm_storeu_si128((__m128i*)p, packed) ;
+}
+
+__attribute__((target("avx2,fma")))
+static void saxpy_bf16_avx2(float a, const bf16_t* x, bf16_t* y, size_t N){
+	__m256 va = _mm256_set1_ps(a) ;
+	size_t i = 0 ;
+	for(; i + 8 <= N; i += 8){
+		storeBf16x8(y + i, _mm256_fmadd_ps(va, loadBf16x8(x + i), loadBf16x8(y + i))) ;
+	}
+	for(; i < N; i++) y[i].bits = floatToBf16(a * bf16ToFloat(x[i].bits) + bf16ToFloat(y[i].bits)) ;
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_bf16_avx2(const bf16_t* x, const bf16_t* y, size_t N){
+	__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps() ;
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		acc0 = _mm256_fmadd_ps(loadBf16x8(x + i), loadBf16x8(y + i), acc0) ;
+		acc1 = _mm256_fmadd_ps(loadBf16x8(x + i + 8), loadBf16x8(y + i + 8), acc1) ;
+	}
+	float sum = hsum256(_mm256_add_ps(acc0, acc1)) ;
+	for(; i < N; i++) sum += bf16ToFloat(x[i].bits) * bf16ToFloat(y[i].bits) ;
+	return sum ;
+}
+
+// bf16 with AVX-512 BF16: hardware narrowing and a pairwise bf16 dot into fp32
+__attribute__((target("avx512f,avx512bw,avx512bf16")))
+static void saxpy_bf16_avx512(float a, const bf16_t* x, bf16_t* y, size_t N){
+	__m512 va = _mm512_set1_ps(a) ;
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		__m512 vx = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(x + i))), 16)) ;
+		__m512 vy = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(y + i))), 16)) ;
+		__m256bh r = _mm512_cvtneps_pbh(_mm512_fmadd_ps(va, vx, vy)) ;
+		std::memcpy(y + i, &r, sizeof(r)) ;
+	}
+	for(; i < N; i++) y[i].bits = floatToBf16(a * bf16ToFloat(x[i].bits) + bf16ToFloat(y[i].bits)) ;
+}
+
+__attribute__((target("avx512f,avx512bw,avx512bf16")))
+static float dot_bf16_avx512(const bf16_t* x, const bf16_t* y, size_t N){
+	__m512 acc = _mm512_setzero_ps() ;
+	size_t i = 0 ;
+	for(; i + 32 <= N; i += 32){
+		__m512bh vx, vy ;
+		std::memcpy(&vx, x + i, sizeof(vx)) ;
+		std::memcpy(&vy, y + i, sizeof(vy)) ;
+		acc = _mm512_dpbf16_ps(acc, vx, vy) ;
+	}
+	float sum = _mm512_reduce_add_ps(acc) ;
+	for(; i < N; i++) sum += bf16ToFloat(x[i].bits) * bf16ToFloat(y[i].bits) ;
+	return sum ;
+}
+
+// int8: widen to int32, multiply, saturate back
+__attribute__((target("avx2")))
+static void saxpy_int8_avx2(int32_t a, const int8_t* x, int8_t* y, size_t N){
+	__m256i va = _mm256_set1_epi32(a) ;
+	size_t i = 0 ;
+	for(; i + 8 <= N; i += 8){
+		__m256i vx = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(x + i))) ;
+		__m256i vy = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(y + i))) ;
+		__m256i r = _mm256_add_epi32(_mm256_mullo_epi32(va, vx), vy) ;
+		// packs saturate; they work per 128-bit lane, so each lane holds 4 results
+		__m256i p = _mm256_packs_epi16(_mm256_packs_epi32(r, r), _mm256_setzero_si256()) ;
+		int32_t lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(p)) ;
+		int32_t hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(p, 1)) ;
+		std::memcpy(y + i, &lo, 4) ;
+		std::memcpy(y + i + 4, &hi, 4) ;
+	}
+	for(; i < N; i++) y[i] = saturateInt8(a * x[i] + y[i]) ;
+}
+
+__attribute__((target("avx2")))
+static int32_t dot_int8_avx2(const int8_t* x, const int8_t* y, size_t N){
+	__m256i acc = _mm256_setzero_si256() ;
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		__m256i vx = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(x + i))) ;
+		__m256i vy = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y + i))) ;
+		acc = _mm256_add_epi32(acc, _mm256_madd_epi16(vx, vy)) ;
+	}
+	int32_t lanes[8] ;
+	_mm256_storeu_si256((__m256i*)lanes, acc) ;
+	int32_t sum = 0 ;
+	for(int l = 0; l < 8; l++) sum += lanes[l] ;
+	for(; i < N; i++) sum += x[i] * y[i] ;
+	return sum ;
+}
+
+__attribute__((target("avx512f")))
+static void saxpy_int8_avx512(int32_t a, const int8_t* x, int8_t* y, size_t N){
+	__m512i va = _mm512_set1_epi32(a) ;
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		__m512i vx = _mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)(x + i))) ;
+		__m512i vy = _mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)(y + i))) ;
+		_mm_storeu_si128((__m128i*)(y + i), _mm512_cvtsepi32_epi8(_mm512_add_epi32(_mm512_mullo_epi32(va, vx), vy))) ;
+	}
+	for(; i < N; i++) y[i] = saturateInt8(a * x[i] + y[i]) ;
+}
+
+// VNNI multiplies unsigned by signed bytes. Bias x by +128 to make it
+// unsigned and subtract 128*sum(y) afterwards; int32 wraparound cancels.
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+static int32_t dot_int8_vnni(const int8_t* x, const int8_t* y, size_t N){
+	const __m512i bias = _mm512_set1_epi8((char)0x80) ;
+	__m512i acc = _mm512_setzero_si512() ;
+	__m512i corr = _mm512_setzero_si512() ;
+	size_t i = 0 ;
+	for(; i + 64 <= N; i += 64){
+		__m512i vx = _mm512_loadu_si512((const void*)(x + i)) ;
+		__m512i vy = _mm512_loadu_si512((const void*)(y + i)) ;
+		acc = _mm512_dpbusd_epi32(acc, _mm512_xor_si512(vx, bias), vy) ;
+		corr = _mm512_dpbusd_epi32(corr, bias, vy) ;
+	}
+	int32_t sum = _mm512_reduce_add_epi32(_mm512_sub_epi32(acc, corr)) ;
+	for(; i < N; i++) sum += x[i] * y[i] ;
+	return sum ;
+}
+#endif // SIMD_X86
+
+// Best hand-written kernels for T on this host; null members mean "use the
+// portable template"
+static inline LowPrecisionKernels<half_t> lowPrecisionKernels(const half_t*){
+#if SIMD_X86
+	const CpuFeatures& f = cpuFeatures() ;
+	if(f.avx2 && f.fma && f.f16c) return {"f16c", saxpy_fp16_f16c, dot_fp16_f16c} ;
+#endif
+	return {"portable", nullptr, nullptr} ;
+}
+
+static inline LowPrecisionKernels<bf16_t> lowPrecisionKernels(const bf16_t*){
+#if SIMD_X86
+	const CpuFeatures& f = cpuFeatures() ;
+	if(f.avx512bf16 && f.avx512bw) return {"avx512bf16", saxpy_bf16_avx512, dot_bf16_avx512} ;
+	if(f.avx2 && f.fma) return {"avx2", saxpy_bf16_avx2, dot_bf16_avx2} ;
+#endif
+	return {"portable", nullptr, nullptr} ;
+}
+
+static inline LowPrecisionKernels<int8_t> lowPrecisionKernels(const int8_t*){
+#if SIMD_X86
+	const CpuFeatures& f = cpuFeatures() ;
+	if(f.avx512vnni && f.avx512bw) return {"avx512vnni", saxpy_int8_avx512, dot_int8_vnni} ;
+	if(f.avx2) return {"avx2", saxpy_int8_avx2, dot_int8_avx2} ;
+#endif
+	return {"portable", nullptr, nullptr} ;
+}
+
+static inline LowPrecisionKernels<float> lowPrecisionKernels(const float*){
+	const SimdBackend* b = bestBackend() ;
+	if(b) return {b->name, b->saxpy, b->dot} ;
+	return {"portable", nullptr, nullptr} ;
+}
+
+static inline LowPrecisionKernels<double> lowPrecisionKernels(const double*){
+	return {"portable", nullptr, nullptr} ;
+}
@@ -0,0 +1,207 @@
+// Dot-product reduction engine: K independent vector accumulators (4/8/16)
+// combined with a summation mode (naive, pairwise or Kahan-compensated).
+//
+// One accumulator serializes every add behind the previous one, so throughput
+// is capped at one vector FMA per FMA latency. K accumulators keep K FMAs in
+// flight. The body is written once against GCC/Clang vector extensions and
+// instantiated inside target-attributed wrappers, so each ISA gets its own
+// register width without a second copy of the algorithm.
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "SimdKernels.h"
+
+enum SumMode { SUM_NAIVE, SUM_PAIRWISE, SUM_KAHAN } ;
+
+static inline const char* sumModeName(SumMode m){
+	switch(m){
+		case SUM_NAIVE: return "naive" ;
+		case SUM_PAIRWISE: return "pairwise" ;
+		case SUM_KAHAN: return "kahan" ;
+	}
+	return "?" ;
+}
+
+typedef float vf4 __attribute__((vector_size(16))) ;
+typedef float vf8 __attribute__((vector_size(32))) ;
+typedef float vf16 __attribute__((vector_size(64))) ;
+
+// Elements handled by one pairwise leaf per accumulator lane
+#define PAIRWISE_LEAF_STEPS 16
+
+template <typename V>
+__attribute__((always_inline)) static inline V vload(const float* p){
+	V v ;
+	std::memcpy(&v, p, sizeof(V)) ;
+	return v ;
+}
+
+// Tree-sum the lanes of one vector. Taken by reference: a 32/64-byte vector
+// passed by value draws GCC's -Wpsabi ABI-change note outside -march=native
+template <typename V>
+__attribute__((always_inline)) static inline float hsumTree(const V& v){
+	constexpr int W = sizeof(V) / sizeof(float) ;
+	float lanes[W] ;
+	std::memcpy(lanes, &v, sizeof(V)) ;
+	for(int width = W / 2; width > 0; width /= 2){
+		for(int l = 0; l < width; l++) lanes[l] += lanes[l + width] ;
+	}
+	return lanes[0] ;
+}
+
+// Tree-combine K accumulators into acc[0]
+template <typename V, int K>
+__attribute__((always_inline)) static inline void combineTree(V* acc){
+	for(int width = K / 2; width > 0; width /= 2){
+		for(int k = 0; k < width; k++) acc[k] += acc[k + width] ;
+	}
+}
+
+// Naive: K accumulators, tree combine at the end
+template <typename V, int K>
+__attribute__((always_inline)) static inline float dotNaive(const float* x, const float* y, size_t N){
+	constexpr size_t W = sizeof(V) / sizeof(float) ;
+	V acc[K] ;
+	for(int k = 0; k < K; k++) acc[k] = V{} ;
+	size_t i = 0 ;
+	for(; i + K * W <= N; i += K * W){
+		for(int k = 0; k < K; k++){
+			acc[k] += vload<V>(x + i + k * W) * vload<V>(y + i + k * W) ;
+		}
+	}
+	for(; i + W <= N; i += W) acc[0] += vload<V>(x + i) * vload<V>(y + i) ;
+	combineTree<V, K>(acc) ;
+	float sum = hsumTree(acc[0]) ;
+	for(; i < N; i++) sum += x[i] * y[i] ;
+	return sum ;
+}
+
+// Pairwise: fixed-size leaves merged like a binary counter, which gives the
+// same tree as recursive halving without recursion (so it can stay inlined).
+// Error grows with log(N) instead of N.
+template <typename V, int K>
+__attribute__((always_inline)) static inline float dotPairwise(const float* x, const float* y, size_t N){
+	constexpr size_t W = sizeof(V) / sizeof(float) ;
+	constexpr size_t leaf = PAIRWISE_LEAF_STEPS * K * W ;
+	float stack[64] ;
+	int depth = 0 ;
+	size_t leaves = 0 ;
+	size_t i = 0 ;
+	for(; i + leaf <= N; i += leaf){
+		stack[depth++] = dotNaive<V, K>(x + i, y + i, leaf) ;
+		for(size_t c = ++leaves; (c & 1) == 0; c >>= 1){
+			depth-- ;
+			stack[depth - 1] += stack[depth] ;
+		}
+	}
+	float sum = dotNaive<V, K>(x + i, y + i, N - i) ;
+	while(depth > 0) sum += stack[--depth] ;
+	return sum ;
+}
+
+// Kahan: each accumulator lane carries its own running compensation
+template <typename V, int K>
+__attribute__((always_inline)) static inline float dotKahan(const float* x, const float* y, size_t N){
+	constexpr size_t W = sizeof(V) / sizeof(float) ;
+	V sum[K], comp[K] ;
+	for(int k = 0; k < K; k++){ sum[k] = V{} ; comp[k] = V{} ; }
+	size_t i = 0 ;
+	for(; i + K * W <= N; i += K * W){
+		for(int k = 0; k < K; k++){
+			V term = vload<V>(x + i + k * W) * vload<V>(y + i + k * W) - comp[k] ;
+			V t = sum[k] + term ;
+			comp[k] = (t - sum[k]) - term ;
+			sum[k] = t ;
+		}
+	}
+
+	// Fold the lanes and the tail with a scalar Kahan pass
+	float s = 0.0f, c = 0.0f ;
+	auto add = [&](float v){
+		float term = v - c ;
+		float t = s + term ;
+		c = (t - s) - term ;
+		s = t ;
+	} ;
+	for(int k = 0; k < K; k++){
+		float lanes[W], lanesComp[W] ;
+		std::memcpy(lanes, &sum[k], sizeof(V)) ;
+		std::memcpy(lanesComp, &comp[k], sizeof(V)) ;
+		for(size_t l = 0; l < W; l++){ add(lanes[l]) ; add(-lanesComp[l]) ; }
+	}
+	for(; i < N; i++) add(x[i] * y[i]) ;
+	return s ;
+}
+
+template <typename V, int K, SumMode M>
+__attribute__((always_inline)) static inline float dotReduce(const float* x, const float* y, size_t N){
+	if(M == SUM_PAIRWISE) return dotPairwise<V, K>(x, y, N) ;
+	if(M == SUM_KAHAN) return dotKahan<V, K>(x, y, N) ;
+	return dotNaive<V, K>(x, y, N) ;
+}
+
+// Per-ISA instantiations. The 128-bit baseline needs no target attribute.
+template <int K, SumMode M>
+static float dot_reduce_base(const float* x, const float* y, size_t N){
+	return dotReduce<vf4, K, M>(x, y, N) ;
+}
+
+#if SIMD_X86
+template <int K, SumMode M>
+__attribute__((target("avx2,fma")))
+static float dot_reduce_avx2(const float* x, const float* y, size_t N){
+	return dotReduce<vf8, K, M>(x, y, N) ;
+}
+
+template <int K, SumMode M>
+__attribute__((target("avx512f")))
+static float dot_reduce_avx512(const float* x, const float* y, size_t N){
+	return dotReduce<vf16, K, M>(x, y, N) ;
+}
+#endif
+
+struct ReductionVariant {
+	const char* isa ;
+	int accumulators ;
+	SumMode mode ;
+	dot_fn fn ;
+} ;
+
+template <int K>
+static inline void addReductionModes(std::vector<ReductionVariant>& out, const SimdBackend& b){
+	switch(b.isa){
+#if SIMD_X86
+		case ISA_AVX512:
+			out.push_back({b.name, K, SUM_NAIVE, dot_reduce_avx512<K, SUM_NAIVE>}) ;
+			out.push_back({b.name, K, SUM_PAIRWISE, dot_reduce_avx512<K, SUM_PAIRWISE>}) ;
+			out.push_back({b.name, K, SUM_KAHAN, dot_reduce_avx512<K, SUM_KAHAN>}) ;
+			break ;
+		case ISA_AVX2:
+			out.push_back({b.name, K, SUM_NAIVE, dot_reduce_avx2<K, SUM_NAIVE>}) ;
+			out.push_back({b.name, K, SUM_PAIRWISE, dot_reduce_avx2<K, SUM_PAIRWISE>}) ;
+			out.push_back({b.name, K, SUM_KAHAN, dot_reduce_avx2<K, SUM_KAHAN>}) ;
+			break ;
+#endif
+		case ISA_SSE2: case ISA_NEON:
+			out.push_back({b.name, K, SUM_NAIVE, dot_reduce_base<K, SUM_NAIVE>}) ;
+			out.push_back({b.name, K, SUM_PAIRWISE, dot_reduce_base<K, SUM_PAIRWISE>}) ;
+			out.push_back({b.name, K, SUM_KAHAN, dot_reduce_base<K, SUM_KAHAN>}) ;
+			break ;
+		default:
+			break ;
+	}
+}
+
+// Every accumulator count and summation mode for the given backends
+static inline std::vector<ReductionVariant> reductionVariants(const std::vector<SimdBackend>& backends){
+	std::vector<ReductionVariant> out ;
+	for(const SimdBackend& b : backends){
+		addReductionModes<4>(out, b) ;
+		addReductionModes<8>(out, b) ;
+		addReductionModes<16>(out, b) ;
+	}
+	return out ;
+}
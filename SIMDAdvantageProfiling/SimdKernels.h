@@ -0,0 +1,309 @@
+// Hand-written SIMD backends for SAXPY, dot and elementwise multiply with
+// runtime CPU dispatch. Every x86 variant is compiled with a per-function
+// target attribute, so a single binary built without -march=native carries
+// SSE2, AVX2+FMA and AVX-512 code and picks the widest one the host supports.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Kernel signatures shared by every backend
+typedef void (*saxpy_fn)(float a, const float* x, float* y, size_t N) ;
+typedef float (*dot_fn)(const float* x, const float* y, size_t N) ;
+typedef void (*element_fn)(const float* x, const float* y, float* result, size_t N) ;
+
+enum SimdIsa { ISA_SCALAR, ISA_AUTO, ISA_SSE2, ISA_AVX2, ISA_AVX512, ISA_NEON } ;
+
+struct SimdBackend {
+	const char* name ;
+	SimdIsa isa ;
+	int widthFloats ;
+	saxpy_fn saxpy ;
+	dot_fn dot ;
+	element_fn element ;
+} ;
+
+// ----------------------------- CPU detection -----------------------------
+struct CpuFeatures {
+	bool sse2 = false ;
+	bool avx = false ;
+	bool avx2 = false ;
+	bool fma = false ;
+	bool f16c = false ;
+	bool avx512f = false ;
+	bool avx512bw = false ;
+	bool avx512cd = false ;
+	bool avx512vnni = false ;
+	bool avx512bf16 = false ;
+	bool neon = false ;
+} ;
+
+#if SIMD_X86
+// XCR0 tells us which register state the OS saves on context switch.
+// cpuid alone is not enough: AVX-512 can be present but disabled by the kernel.
+static inline uint64_t readXcr0(){
+	uint32_t eax, edx ;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0)) ;
+	return ((uint64_t)edx << 32) | eax ;
+}
+#endif
+
+static inline CpuFeatures detectCpuFeatures(){
+	CpuFeatures f ;
+#if SIMD_X86
+	unsigned eax, ebx, ecx, edx ;
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return f ;
+	f.sse2 = (edx >> 26) & 1 ;
+	bool osxsave = (ecx >> 27) & 1 ;
+	bool cpuAvx = (ecx >> 28) & 1 ;
+	bool cpuFma = (ecx >> 12) & 1 ;
+	uint64_t xcr0 = osxsave ? readXcr0() : 0 ;
+	bool osYmm = (xcr0 & 0x6) == 0x6 ;
+	bool osZmm = (xcr0 & 0xe6) == 0xe6 ;
+
+	f.avx = cpuAvx && osYmm ;
+	f.fma = cpuFma && osYmm ;
+	f.f16c = ((ecx >> 29) & 1) && osYmm ;
+	if(__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)){
+		unsigned maxSubleaf = eax ;
+		f.avx2 = ((ebx >> 5) & 1) && osYmm ;
+		f.avx512f = ((ebx >> 16) & 1) && osZmm ;
+		f.avx512bw = f.avx512f && ((ebx >> 30) & 1) ;
+		f.avx512cd = f.avx512f && ((ebx >> 28) & 1) ;
+		f.avx512vnni = f.avx512f && ((ecx >> 11) & 1) ;
+		if(maxSubleaf >= 1 && __get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)){
+			f.avx512bf16 = f.avx512f && ((eax >> 5) & 1) ;
+		}
+	}
+#elif SIMD_NEON
+	f.neon = true ;
+#endif
+	return f ;
+}
+
+static inline const CpuFeatures& cpuFeatures(){
+	static const CpuFeatures f = detectCpuFeatures() ;
+	return f ;
+}
+
+// --------------------------------- SSE2 ----------------------------------
+#if SIMD_X86
+__attribute__((target("sse2")))
+static void saxpy_sse2(float a, const float* x, float* y, size_t N){
+	__m128 va = _mm_set1_ps(a) ;
+	size_t i = 0 ;
+	for(; i + 4 <= N; i += 4){
+		__m128 vy = _mm_add_ps(_mm_mul_ps(va, _mm_loadu_ps(x + i)), _mm_loadu_ps(y + i)) ;
+		_mm_storeu_ps(y + i, vy) ;
+	}
+	for(; i < N; i++) y[i] = a * x[i] + y[i] ;
+}
+
+__attribute__((target("sse2")))
+static float dot_sse2(const float* x, const float* y, size_t N){
+	__m128 acc = _mm_setzero_ps() ;
+	size_t i = 0 ;
+	for(; i + 4 <= N; i += 4){
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i))) ;
+	}
+	float lanes[4] ;
+	_mm_storeu_ps(lanes, acc) ;
+	float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) ;
+	for(; i < N; i++) sum += x[i] * y[i] ;
+	return sum ;
+}
+
+__attribute__((target("sse2")))
+static void element_sse2(const float* x, const float* y, float* result, size_t N){
+	size_t i = 0 ;
+	for(; i + 4 <= N; i += 4){
+		_mm_storeu_ps(result + i, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i))) ;
+	}
+	for(; i < N; i++) result[i] = x[i] * y[i] ;
+}
+
+// -------------------------------- AVX2+FMA -------------------------------
+__attribute__((target("avx2,fma")))
+static inline float hsum256(__m256 v){
+	__m128 lo = _mm256_castps256_ps128(v) ;
+	__m128 hi = _mm256_extractf128_ps(v, 1) ;
+	lo = _mm_add_ps(lo, hi) ;
+	lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo)) ;
+	lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1)) ;
+	return _mm_cvtss_f32(lo) ;
+}
+
+__attribute__((target("avx2,fma")))
+static void saxpy_avx2(float a, const float* x, float* y, size_t N){
+	__m256 va = _mm256_set1_ps(a) ;
+	size_t i = 0 ;
+	for(; i + 8 <= N; i += 8){
+		_mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i))) ;
+	}
+	for(; i < N; i++) y[i] = a * x[i] + y[i] ;
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_avx2(const float* x, const float* y, size_t N){
+	__m256 acc = _mm256_setzero_ps() ;
+	size_t i = 0 ;
+	for(; i + 8 <= N; i += 8){
+		acc = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc) ;
+	}
+	float sum = hsum256(acc) ;
+	for(; i < N; i++) sum += x[i] * y[i] ;
+	return sum ;
+}
+
+__attribute__((target("avx2,fma")))
+static void element_avx2(const float* x, const float* y, float* result, size_t N){
+	size_t i = 0 ;
+	for(; i + 8 <= N; i += 8){
+		_mm256_storeu_ps(result + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i))) ;
+	}
+	for(; i < N; i++) result[i] = x[i] * y[i] ;
+}
+
+// -------------------------------- AVX-512 --------------------------------
+// Tails use masked loads/stores instead of a scalar epilogue.
+__attribute__((target("avx512f")))
+static inline __mmask16 tailMask16(size_t remaining){
+	return (__mmask16)((1u << remaining) - 1u) ;
+}
+
+__attribute__((target("avx512f")))
+static void saxpy_avx512(float a, const float* x, float* y, size_t N){
+	__m512 va = _mm512_set1_ps(a) ;
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		_mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i))) ;
+	}
+	if(i < N){
+		__mmask16 m = tailMask16(N - i) ;
+		__m512 vy = _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(m, x + i), _mm512_maskz_loadu_ps(m, y + i)) ;
+		_mm512_mask_storeu_ps(y + i, m, vy) ;
+	}
+}
+
+__attribute__((target("avx512f")))
+static float dot_avx512(const float* x, const float* y, size_t N){
+	__m512 acc = _mm512_setzero_ps() ;
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		acc = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), acc) ;
+	}
+	if(i < N){
+		__mmask16 m = tailMask16(N - i) ;
+		acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x + i), _mm512_maskz_loadu_ps(m, y + i), acc) ;
+	}
+	return _mm512_reduce_add_ps(acc) ;
+}
+
+__attribute__((target("avx512f")))
+static void element_avx512(const float* x, const float* y, float* result, size_t N){
+	size_t i = 0 ;
+	for(; i + 16 <= N; i += 16){
+		_mm512_storeu_ps(result + i, _mm512_mul_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i))) ;
+	}
+	if(i < N){
+		__mmask16 m = tailMask16(N - i) ;
+		_mm512_mask_storeu_ps(result + i, m, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, x + i), _mm512_maskz_loadu_ps(m, y + i))) ;
+	}
+}
+#endif // SIMD_X86
+
+// --------------------------------- NEON ----------------------------------
+#if SIMD_NEON
+static void saxpy_neon(float a, const float* x, float* y, size_t N){
+	float32x4_t va = vdupq_n_f32(a) ;
+	size_t i = 0 ;
+	for(; i + 4 <= N; i += 4){
+		vst1q_f32(y + i, vfmaq_f32(vld1q_f32(y + i), va, vld1q_f32(x + i))) ;
+	}
+	for(; i < N; i++) y[i] = a * x[i] + y[i] ;
+}
+
+static float dot_neon(const float* x, const float* y, size_t N){
+	float32x4_t acc = vdupq_n_f32(0.0f) ;
+	size_t i = 0 ;
+	for(; i + 4 <= N; i += 4){
+		acc = vfmaq_f32(acc, vld1q_f32(x + i), vld1q_f32(y + i)) ;
+	}
+	float sum = vaddvq_f32(acc) ;
+	for(; i < N; i++) sum += x[i] * y[i] ;
+	return sum ;
+}
+
+static void element_neon(const float* x, const float* y, float* result, size_t N){
+	size_t i = 0 ;
+	for(; i + 4 <= N; i += 4){
+		vst1q_f32(result + i, vmulq_f32(vld1q_f32(x + i), vld1q_f32(y + i))) ;
+	}
+	for(; i < N; i++) result[i] = x[i] * y[i] ;
+}
+#endif // SIMD_NEON
+
+// ------------------------------- Dispatch --------------------------------
+// Backends compiled into this binary. Whether the host can run one is a
+// separate question answered by backendSupported().
+static inline const std::vector<SimdBackend>& compiledBackends(){
+	static const std::vector<SimdBackend> backends = {
+#if SIMD_X86
+		{"sse2", ISA_SSE2, 4, saxpy_sse2, dot_sse2, element_sse2},
+		{"avx2", ISA_AVX2, 8, saxpy_avx2, dot_avx2, element_avx2},
+		{"avx512", ISA_AVX512, 16, saxpy_avx512, dot_avx512, element_avx512},
+#elif SIMD_NEON
+		{"neon", ISA_NEON, 4, saxpy_neon, dot_neon, element_neon},
+#endif
+	} ;
+	return backends ;
+}
+
+static inline bool backendSupported(const SimdBackend& b){
+	const CpuFeatures& f = cpuFeatures() ;
+	switch(b.isa){
+		case ISA_SCALAR: case ISA_AUTO: return true ;
+		case ISA_SSE2: return f.sse2 ;
+		case ISA_AVX2: return f.avx2 && f.fma ;
+		case ISA_AVX512: return f.avx512f ;
+		case ISA_NEON: return f.neon ;
+	}
+	return false ;
+}
+
+// Hand-written backends the host can run, narrowest first
+static inline std::vector<SimdBackend> availableBackends(){
+	std::vector<SimdBackend> out ;
+	for(const SimdBackend& b : compiledBackends()){
+		if(backendSupported(b)) out.push_back(b) ;
+	}
+	return out ;
+}
+
+// Look up a backend by name; returns nullptr if unknown or unsupported here
+static inline const SimdBackend* findBackend(const char* name){
+	for(const SimdBackend& b : compiledBackends()){
+		if(std::strcmp(b.name, name) == 0) return backendSupported(b) ? &b : nullptr ;
+	}
+	return nullptr ;
+}
+
+// Widest backend the host supports; nullptr when none was compiled in
+static inline const SimdBackend* bestBackend(){
+	const SimdBackend* best = nullptr ;
+	for(const SimdBackend& b : compiledBackends()){
+		if(backendSupported(b)) best = &b ;
+	}
+	return best ;
+}
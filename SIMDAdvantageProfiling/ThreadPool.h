@@ -0,0 +1,216 @@
+// Persistent, pinned worker pool and the parallel SAXPY/dot/elementwise
+// kernels built on it. Workers are created once and parked between jobs, so
+// a timed call measures the kernel rather than pthread_create.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "SimdKernels.h"
+
+// CPUs this process may run on, in order. Workers are pinned round-robin.
+static inline std::vector<int> allowedCpus(){
+	std::vector<int> cpus ;
+#if defined(__linux__)
+	cpu_set_t set ;
+	CPU_ZERO(&set) ;
+	if(sched_getaffinity(0, sizeof(set), &set) == 0){
+		for(int c = 0; c < CPU_SETSIZE; c++){
+			if(CPU_ISSET(c, &set)) cpus.push_back(c) ;
+		}
+	}
+#endif
+	if(cpus.empty()){
+		unsigned n = std::thread::hardware_concurrency() ;
+		for(unsigned c = 0; c < (n ? n : 1); c++) cpus.push_back((int)c) ;
+	}
+	return cpus ;
+}
+
+// Pin the calling thread; a no-op where the OS has no hard affinity (macOS)
+static inline bool pinCurrentThread(int cpu){
+#if defined(__linux__)
+	cpu_set_t set ;
+	CPU_ZERO(&set) ;
+	CPU_SET(cpu, &set) ;
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ;
+#else
+	(void)cpu ;
+	return false ;
+#endif
+}
+
+// Per-thread partial sums, one cache line each, combined by the caller
+struct alignas(64) PaddedPartial { float value ; } ;
+
+class ThreadPool {
+public:
+	typedef std::function<void(int tid, int active)> Job ;
+
+	explicit ThreadPool(int threads) : cpus_(allowedCpus()){
+		if(threads < 1) threads = 1 ;
+		tids_.assign((size_t)threads, 0) ;
+		partials_.resize((size_t)threads) ;
+		for(int t = 0; t < threads; t++){
+			workers_.emplace_back([this, t](){ workerLoop(t) ; }) ;
+		}
+		std::unique_lock<std::mutex> lock(mutex_) ;
+		done_.wait(lock, [this](){ return started_ == (int)workers_.size() ; }) ;
+	}
+
+	~ThreadPool(){
+		{
+			std::lock_guard<std::mutex> lock(mutex_) ;
+			shutdown_ = true ;
+			generation_++ ;
+		}
+		wake_.notify_all() ;
+		for(std::thread& w : workers_) w.join() ;
+	}
+
+	ThreadPool(const ThreadPool&) = delete ;
+	ThreadPool& operator=(const ThreadPool&) = delete ;
+
+	int size() const { return (int)workers_.size() ; }
+
+	// Kernel thread ids of the workers, for per-thread perf counters; 0
+	// where the OS has none
+	const std::vector<int>& threadIds() const { return tids_ ; }
+
+	// One padded reduction slot per worker, owned by the pool so reductions
+	// allocate nothing inside the timed region
+	PaddedPartial* partials(){ return partials_.data() ; }
+
+	// Run job(tid, active) on workers 0..active-1 and wait for all of them
+	void run(int active, const Job& job){
+		if(active < 1) active = 1 ;
+		if(active > size()) active = size() ;
+		{
+			std::lock_guard<std::mutex> lock(mutex_) ;
+			job_ = &job ;
+			active_ = active ;
+			pending_ = active ;
+			generation_++ ;
+		}
+		wake_.notify_all() ;
+		std::unique_lock<std::mutex> lock(mutex_) ;
+		done_.wait(lock, [this](){ return pending_ == 0 ; }) ;
+		job_ = nullptr ;
+	}
+
+private:
+	void workerLoop(int tid){
+		pinCurrentThread(cpus_[(size_t)tid % cpus_.size()]) ;
+		{
+			std::lock_guard<std::mutex> lock(mutex_) ;
+#if defined(__linux__)
+			tids_[(size_t)tid] = (int)syscall(SYS_gettid) ;
+#endif
+			started_++ ;
+		}
+		done_.notify_all() ;
+		uint64_t seen = 0 ;
+		for(;;){
+			const Job* job ;
+			int active ;
+			{
+				std::unique_lock<std::mutex> lock(mutex_) ;
+				wake_.wait(lock, [&](){ return generation_ != seen ; }) ;
+				seen = generation_ ;
+				if(shutdown_) return ;
+				if(tid >= active_) continue ;
+				job = job_ ;
+				active = active_ ;
+			}
+			(*job)(tid, active) ;
+			{
+				std::lock_guard<std::mutex> lock(mutex_) ;
+				if(--pending_ == 0) done_.notify_one() ;
+			}
+		}
+	}
+
+	std::vector<int> cpus_ ;
+	std::vector<std::thread> workers_ ;
+	std::vector<int> tids_ ;
+	std::vector<PaddedPartial> partials_ ;
+	std::mutex mutex_ ;
+	std::condition_variable wake_ ;
+	std::condition_variable done_ ;
+	const Job* job_ = nullptr ;
+	int active_ = 0 ;
+	int pending_ = 0 ;
+	int started_ = 0 ;
+	uint64_t generation_ = 0 ;
+	bool shutdown_ = false ;
+} ;
+
+// Contiguous chunk for thread tid, rounded to 64-byte (16 float) boundaries
+// so neighbouring threads never write the same cache line.
+static inline void chunkRange(size_t N, int tid, int active, size_t& begin, size_t& end){
+	const size_t align = 16 ;
+	size_t per = (N + (size_t)active - 1) / (size_t)active ;
+	per = (per + align - 1) / align * align ;
+	begin = per * (size_t)tid ;
+	end = begin + per ;
+	if(begin > N) begin = N ;
+	if(end > N) end = N ;
+}
+
+// Page-aligned, uninitialized buffer. Pages are placed by whichever thread
+// first writes them, so initialize through firstTouch() before timing.
+static inline float* allocFloats(size_t N){
+	void* ptr = nullptr ;
+	if(posix_memalign(&ptr, 4096, N * sizeof(float) + 64) != 0) return nullptr ;
+	return (float*)ptr ;
+}
+
+// Each worker writes its own chunk so its pages land on its NUMA node
+static inline void firstTouch(ThreadPool& pool, int active, float* p, size_t N, const std::function<void(float*, size_t, int)>& init){
+	pool.run(active, [&](int tid, int n){
+		size_t begin, end ;
+		chunkRange(N, tid, n, begin, end) ;
+		if(end > begin) init(p + begin, end - begin, tid) ;
+	}) ;
+}
+
+static inline void saxpy_parallel(ThreadPool& pool, int active, const SimdBackend& b, float a, const float* x, float* y, size_t N){
+	pool.run(active, [&](int tid, int n){
+		size_t begin, end ;
+		chunkRange(N, tid, n, begin, end) ;
+		if(end > begin) b.saxpy(a, x + begin, y + begin, end - begin) ;
+	}) ;
+}
+
+static inline void element_parallel(ThreadPool& pool, int active, const SimdBackend& b, const float* x, const float* y, float* result, size_t N){
+	pool.run(active, [&](int tid, int n){
+		size_t begin, end ;
+		chunkRange(N, tid, n, begin, end) ;
+		if(end > begin) b.element(x + begin, y + begin, result + begin, end - begin) ;
+	}) ;
+}
+
+static inline float dot_parallel(ThreadPool& pool, int active, const SimdBackend& b, const float* x, const float* y, size_t N){
+	PaddedPartial* partial = pool.partials() ;
+	pool.run(active, [&](int tid, int n){
+		size_t begin, end ;
+		chunkRange(N, tid, n, begin, end) ;
+		partial[(size_t)tid].value = end > begin ? b.dot(x + begin, y + begin, end - begin) : 0.0f ;
+	}) ;
+	float sum = 0.0f ;
+	for(int t = 0; t < active && t < pool.size(); t++) sum += partial[(size_t)t].value ;
+	return sum ;
+}
@@ -0,0 +1,242 @@
+// Minimal io_uring over the raw syscalls, so the storage tests need nothing
+// beyond the kernel UAPI header (no liburing). One IoUring owns one ring and
+// is driven by one thread: the SQ tail and CQ head are only ever written from
+// here, and the kernel's side is read with acquire loads. Calls that fail
+// return -errno, like the syscalls underneath.
+#pragma once
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+static inline int sysIoUringSetup(unsigned entries, io_uring_params* p){
+	return (int)syscall(__NR_io_uring_setup, entries, p) ;
+}
+
+static inline int sysIoUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags){
+	return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0) ;
+}
+
+static inline int sysIoUringEnterArg(int fd, unsigned minComplete, unsigned flags, const io_uring_getevents_arg* arg){
+	return (int)syscall(__NR_io_uring_enter, fd, 0, minComplete, flags | IORING_ENTER_EXT_ARG, arg, sizeof(*arg)) ;
+}
+
+static inline int sysIoUringRegister(int fd, unsigned opcode, const void* arg, unsigned nrArgs){
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs) ;
+}
+
+class IoUring {
+public:
+	IoUring() {}
+	~IoUring(){ close() ; }
+	IoUring(const IoUring&) = delete ;
+	IoUring& operator=(const IoUring&) = delete ;
+
+	// Entries is rounded up to a power of two by the kernel. With sqpoll a
+	// kernel thread polls the SQ, so submission needs no syscall while it is
+	// awake; it sleeps after idleMs without work.
+	int init(unsigned entries, bool sqpoll = false, unsigned idleMs = 2000){
+		io_uring_params p ;
+		std::memset(&p, 0, sizeof(p)) ;
+		if(sqpoll){
+			p.flags |= IORING_SETUP_SQPOLL ;
+			p.sq_thread_idle = idleMs ;
+		}
+		ringFd = sysIoUringSetup(entries, &p) ;
+		if(ringFd < 0){
+			ringFd = -1 ;
+			return -errno ;
+		}
+		polled = sqpoll ;
+		features = p.features ;
+		sqEntries = p.sq_entries ;
+		sqRingBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned) ;
+		cqRingBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe) ;
+		singleMmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0 ;
+		if(singleMmap) sqRingBytes = cqRingBytes = sqRingBytes > cqRingBytes ? sqRingBytes : cqRingBytes ;
+		sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING) ;
+		if(sqRing == MAP_FAILED){
+			sqRing = nullptr ;
+			return fail() ;
+		}
+		if(singleMmap) cqRing = sqRing ;
+		else {
+			cqRing = mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING) ;
+			if(cqRing == MAP_FAILED){
+				cqRing = nullptr ;
+				return fail() ;
+			}
+		}
+		sqeBytes = p.sq_entries * sizeof(io_uring_sqe) ;
+		void* s = mmap(nullptr, sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES) ;
+		if(s == MAP_FAILED) return fail() ;
+		sqes = (io_uring_sqe*)s ;
+
+		char* sq = (char*)sqRing ;
+		sqHead = (unsigned*)(sq + p.sq_off.head) ;
+		sqTail = (unsigned*)(sq + p.sq_off.tail) ;
+		sqMask = *(unsigned*)(sq + p.sq_off.ring_mask) ;
+		sqFlags = (unsigned*)(sq + p.sq_off.flags) ;
+		// SQE slot i is always published through array slot i
+		unsigned* array = (unsigned*)(sq + p.sq_off.array) ;
+		for(unsigned i = 0; i < p.sq_entries; i++) array[i] = i ;
+		char* cq = (char*)cqRing ;
+		cqHead = (unsigned*)(cq + p.cq_off.head) ;
+		cqTail = (unsigned*)(cq + p.cq_off.tail) ;
+		cqMask = *(unsigned*)(cq + p.cq_off.ring_mask) ;
+		cqes = (io_uring_cqe*)(cq + p.cq_off.cqes) ;
+		localTail = *sqTail ;
+		return 0 ;
+	}
+
+	void close(){
+		if(sqes) munmap(sqes, sqeBytes) ;
+		if(cqRing && !singleMmap) munmap(cqRing, cqRingBytes) ;
+		if(sqRing) munmap(sqRing, sqRingBytes) ;
+		if(ringFd >= 0) ::close(ringFd) ;
+		sqes = nullptr ;
+		sqRing = cqRing = nullptr ;
+		ringFd = -1 ;
+	}
+
+	bool ready() const { return ringFd >= 0 ; }
+	bool sqPolling() const { return polled ; }
+	unsigned entries() const { return sqEntries ; }
+
+	// Pins the buffers once so *_FIXED ops skip the per-I/O page walk
+	int registerBuffers(const iovec* iov, unsigned n){
+		return sysIoUringRegister(ringFd, IORING_REGISTER_BUFFERS, iov, n) < 0 ? -errno : 0 ;
+	}
+
+	// Fixed files skip the per-I/O fget/fput; SQEs then carry the index
+	int registerFiles(const int* fds, unsigned n){
+		return sysIoUringRegister(ringFd, IORING_REGISTER_FILES, fds, n) < 0 ? -errno : 0 ;
+	}
+
+	// Next free SQE, zeroed, or nullptr while the SQ is full
+	io_uring_sqe* getSqe(){
+		unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) ;
+		if(localTail - head >= sqEntries) return nullptr ;
+		io_uring_sqe* sqe = &sqes[localTail & sqMask] ;
+		localTail++ ;
+		std::memset(sqe, 0, sizeof(*sqe)) ;
+		return sqe ;
+	}
+
+	// Publishes every SQE taken since the last call and, if waitNr > 0,
+	// blocks until at least that many completions are ready. Returns the
+	// number submitted or -errno.
+	int submit(unsigned waitNr = 0){
+		unsigned pending = localTail - *sqTail ;
+		__atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE) ;
+		unsigned flags = waitNr ? IORING_ENTER_GETEVENTS : 0 ;
+		if(polled){
+			// The tail store must be visible before the wakeup flag is read
+			__atomic_thread_fence(__ATOMIC_SEQ_CST) ;
+			if(__atomic_load_n(sqFlags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) flags |= IORING_ENTER_SQ_WAKEUP ;
+			if(!flags) return (int)pending ;
+		}
+		for(;;){
+			int r = sysIoUringEnter(ringFd, polled ? 0 : pending, waitNr, flags) ;
+			if(r >= 0) return polled ? (int)pending : r ;
+			if(errno != EINTR) return -errno ;
+		}
+	}
+
+	// Hands out ready CQEs without blocking; call cqeSeen() after each
+	io_uring_cqe* peekCqe(){
+		unsigned head = *cqHead ;
+		if(head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return nullptr ;
+		return &cqes[head & cqMask] ;
+	}
+
+	void cqeSeen(){
+		__atomic_store_n(cqHead, *cqHead + 1, __ATOMIC_RELEASE) ;
+	}
+
+	// Blocks for one CQE; nullptr only on a syscall error
+	io_uring_cqe* waitCqe(){
+		for(;;){
+			io_uring_cqe* cqe = peekCqe() ;
+			if(cqe) return cqe ;
+			if(sysIoUringEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) return nullptr ;
+		}
+	}
+
+	// Blocks for one CQE at most timeoutNs; nullptr on timeout. Kernels
+	// without IORING_FEAT_EXT_ARG (before 5.11) return at once, so callers
+	// degrade to polling.
+	io_uring_cqe* waitCqeTimeout(uint64_t timeoutNs){
+		io_uring_cqe* cqe = peekCqe() ;
+		if(cqe || !(features & IORING_FEAT_EXT_ARG)) return cqe ;
+		__kernel_timespec ts ;
+		ts.tv_sec = (long long)(timeoutNs / 1000000000ull) ;
+		ts.tv_nsec = (long long)(timeoutNs % 1000000000ull) ;
+		io_uring_getevents_arg arg ;
+		std::memset(&arg, 0, sizeof(arg)) ;
+		arg.ts = (uint64_t)(uintptr_t)&ts ;
+		sysIoUringEnterArg(ringFd, 1, IORING_ENTER_GETEVENTS, &arg) ;
+		return peekCqe() ;
+	}
+
+private:
+	int ringFd = -1 ;
+	bool polled = false ;
+	bool singleMmap = false ;
+	unsigned features = 0 ;
+	unsigned sqEntries = 0 ;
+	size_t sqRingBytes = 0, cqRingBytes = 0, sqeBytes = 0 ;
+	void* sqRing = nullptr ;
+	void* cqRing = nullptr ;
+	io_uring_sqe* sqes = nullptr ;
+	unsigned* sqHead = nullptr ;
+	unsigned* sqTail = nullptr ;
+	unsigned* sqFlags = nullptr ;
+	unsigned sqMask = 0 ;
+	unsigned localTail = 0 ;
+	unsigned* cqHead = nullptr ;
+	unsigned* cqTail = nullptr ;
+	unsigned cqMask = 0 ;
+	io_uring_cqe* cqes = nullptr ;
+
+	int fail(){
+		int e = -errno ;
+		close() ;
+		return e ;
+	}
+} ;
+
+// Read or write of len bytes at off. With a registered buffer bufIndex >= 0
+// selects it (READ_FIXED/WRITE_FIXED); with fixedFile fd is the index into
+// the registered file table.
+static inline void prepRw(io_uring_sqe* sqe, bool write, int fd, void* buf, unsigned len, uint64_t off, int bufIndex, bool fixedFile){
+	if(bufIndex >= 0){
+		sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED ;
+		sqe->buf_index = (uint16_t)bufIndex ;
+	}
+	else sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ ;
+	sqe->fd = fd ;
+	sqe->addr = (uint64_t)(uintptr_t)buf ;
+	sqe->len = len ;
+	sqe->off = off ;
+	if(fixedFile) sqe->flags |= IOSQE_FIXED_FILE ;
+}
+
+// fsync, or fdatasync with datasync. Setting IOSQE_IO_LINK on the SQE
+// before it makes it wait for that one, so write+sync goes in one submit.
+static inline void prepFsync(io_uring_sqe* sqe, int fd, bool datasync){
+	sqe->opcode = IORING_OP_FSYNC ;
+	sqe->fd = fd ;
+	if(datasync) sqe->fsync_flags = IORING_FSYNC_DATASYNC ;
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Log-linear latency histogram in the style of HdrHistogram. Values below
+// 2^subBits are counted exactly; above that every power-of-two range is
+// split into 2^(subBits-1) equal buckets, so a reported value is never more
+// than 1/2^(subBits-1) above what was recorded (0.2% at the default 10)
+// whatever its magnitude. Recording is an index computation and an
+// increment, cheap enough for every I/O, and histograms from different
+// threads or runs merge by adding counts.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class LatencyHistogram {
+public:
+	explicit LatencyHistogram(int subBits = 10)
+		: bits(subBits), half((uint64_t)1 << (subBits - 1)),
+		  counts((size_t)(64 - subBits) * ((size_t)1 << (subBits - 1)) + ((size_t)1 << subBits)) {}
+
+	void record(uint64_t v){
+		counts[index(v)]++ ;
+		total++ ;
+		sum += v ;
+		if(v < lo) lo = v ;
+		if(v > hi) hi = v ;
+	}
+
+	// Adds another histogram's counts; both must use the same subBits
+	void merge(const LatencyHistogram& o){
+		for(size_t i = 0; i < counts.size() && i < o.counts.size(); i++) counts[i] += o.counts[i] ;
+		total += o.total ;
+		sum += o.sum ;
+		lo = std::min(lo, o.lo) ;
+		hi = std::max(hi, o.hi) ;
+	}
+
+	void clear(){
+		std::fill(counts.begin(), counts.end(), 0) ;
+		total = sum = hi = 0 ;
+		lo = UINT64_MAX ;
+	}
+
+	uint64_t count() const { return total ; }
+	uint64_t min() const { return total ? lo : 0 ; }
+	uint64_t max() const { return hi ; }
+	double mean() const { return total ? (double)sum / (double)total : 0.0 ; }
+
+	// Smallest recorded value v with at least q of the samples <= v, reported
+	// as the top of its bucket (never above the true maximum)
+	uint64_t valueAt(double q) const {
+		if(!total) return 0 ;
+		if(q >= 1.0) return hi ;
+		uint64_t rank = (uint64_t)std::ceil(q * (double)total) ;
+		if(rank == 0) rank = 1 ;
+		uint64_t seen = 0 ;
+		for(size_t i = 0; i < counts.size(); i++){
+			seen += counts[i] ;
+			if(seen >= rank) return std::min(upper(i), hi) ;
+		}
+		return hi ;
+	}
+
+	// Percentile spectrum at HdrHistogram's usual spacing: quarter decades of
+	// 1-q from the median out to q = 0.99999, then the maximum
+	std::vector<std::pair<double, uint64_t>> curve() const {
+		std::vector<std::pair<double, uint64_t>> pts ;
+		for(int k = 0; k <= 20; k++){
+			double q = 1.0 - std::pow(10.0, -(double)k / 4.0) ;
+			if(q < 0.5) q = 0.5 ;
+			if(!pts.empty() && pts.back().first == q) continue ;
+			pts.push_back({q, valueAt(q)}) ;
+		}
+		pts.push_back({1.0, hi}) ;
+		return pts ;
+	}
+
+private:
+	int bits ;
+	uint64_t half ;
+	std::vector<uint64_t> counts ;
+	uint64_t total = 0 ;
+	uint64_t sum = 0 ;
+	uint64_t lo = UINT64_MAX ;
+	uint64_t hi = 0 ;
+
+	size_t index(uint64_t v) const {
+		if(v < 2 * half) return (size_t)v ;
+		int shift = 63 - __builtin_clzll(v) - bits + 1 ;
+		return (size_t)shift * half + (size_t)(v >> shift) ;
+	}
+
+	uint64_t upper(size_t i) const {
+		if(i < 2 * half) return i ;
+		uint64_t shift = i / half - 1 ;
+		uint64_t m = i - shift * half ;
+		return ((m + 1) << shift) - 1 ;
+	}
+} ;
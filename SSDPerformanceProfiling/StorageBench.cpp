@@ -0,0 +1,1864 @@
+// Native block-I/O engine for the SSD suite. runFioSweeps.sh drives fio's
+// posixaio engine, which emulates AIO with a thread pool: latency includes a
+// thread handoff per I/O and deep queues flatten early. This issues the same
+// jobs straight through io_uring (IoUring.h, raw syscalls) with O_DIRECT,
+// registered buffers and files and optional SQPOLL, and writes rows with the
+// columns of summary.csv so the same plots apply.
+//
+// Build: g++ -O2 -std=c++17 -Wall -Wextra -o StorageBench StorageBench.cpp
+// Linux only; everything below needs io_uring.
+//
+// Writes overwrite the target. Point --target at a scratch file (it is
+// created and filled to --size when short) or at a device you can wipe.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../Common/BenchResult.h"
+#include "IoUring.h"
+#include "LatencyHistogram.h"
+
+// The shared TSC clock; main calibrates it before any thread starts
+static inline uint64_t nowNs(){
+	return benchClockNs() ;
+}
+
+// xorshift64*: cheap enough to pick an offset per I/O at millions of IOPS
+struct Rng {
+	uint64_t s ;
+	explicit Rng(uint64_t seed) : s(seed ? seed : 0x9e3779b97f4a7c15ull) {}
+	uint64_t next(){
+		s ^= s >> 12 ;
+		s ^= s << 25 ;
+		s ^= s >> 27 ;
+		return s * 0x2545f4914f6cdd1dull ;
+	}
+	uint64_t below(uint64_t n){ return n ? next() % n : 0 ; }
+} ;
+
+// "4k", "128K", "1g", "512" -> bytes
+static size_t parseSize(const char* s){
+	char* end = nullptr ;
+	double v = std::strtod(s, &end) ;
+	switch(end && *end ? *end : ' '){
+		case 'k': case 'K': v *= 1024.0 ; break ;
+		case 'm': case 'M': v *= 1024.0 * 1024.0 ; break ;
+		case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0 ; break ;
+		default: break ;
+	}
+	return (size_t)v ;
+}
+
+// One fio-style job: what the device sees
+struct JobSpec {
+	std::string name ;
+	bool random = true ;
+	int readPct = 100 ;			// fio rwmixread: 100 read-only, 0 write-only
+	size_t bs = 4096 ;
+	unsigned qd = 1 ;
+	size_t span = (size_t)1 << 30 ;	// bytes of the target exercised (fio --size)
+	uint64_t offset = 0 ;			// where that range starts (fio --offset)
+	double runtime = 30.0 ;
+} ;
+
+// How the engine issues it
+struct EngineOptions {
+	bool direct = true ;		// O_DIRECT, the script's --direct=1
+	bool fixed = true ;			// registered buffers and files
+	bool sqpoll = false ;
+} ;
+
+struct JobResult {
+	uint64_t ios = 0 ;
+	uint64_t bytes = 0 ;
+	uint64_t reads = 0 ;
+	uint64_t writes = 0 ;
+	double seconds = 0.0 ;
+	double avgNs = 0.0 ;
+	double p95Ns = 0.0 ;
+	double p99Ns = 0.0 ;
+	double p999Ns = 0.0 ;
+	bool ok = false ;
+} ;
+
+// Opens the target read/write; O_DIRECT falls back to buffered with a warning
+// where the filesystem refuses it (tmpfs before 6.6). *bytes gets the device
+// or file size.
+static int openTarget(const std::string& path, bool& direct, uint64_t* bytes){
+	int flags = O_RDWR | O_CREAT ;
+	int fd = open(path.c_str(), flags | (direct ? O_DIRECT : 0), 0644) ;
+	if(fd < 0 && direct && errno == EINVAL){
+		std::cerr << "O_DIRECT not supported on " << path << "; falling back to buffered I/O\n" ;
+		direct = false ;
+		fd = open(path.c_str(), flags, 0644) ;
+	}
+	if(fd < 0){
+		std::cerr << "open " << path << ": " << std::strerror(errno) << "\n" ;
+		return -1 ;
+	}
+	struct stat st ;
+	fstat(fd, &st) ;
+	*bytes = (uint64_t)st.st_size ;
+	if(S_ISBLK(st.st_mode)){
+		uint64_t dev = 0 ;
+		if(ioctl(fd, BLKGETSIZE64, &dev) == 0) *bytes = dev ;
+	}
+	return fd ;
+}
+
+// Granularity direct I/O offsets and lengths must keep on path: the logical
+// block size of a block device; for a file, the direct-I/O alignment statx
+// reports (Linux 6.1+), else st_blksize. 512 when nothing answers.
+static uint64_t ioAlignment(const std::string& path){
+	uint64_t align = 0 ;
+	int fd = open(path.c_str(), O_RDONLY) ;
+	if(fd < 0) return 512 ;
+	struct stat st ;
+	if(fstat(fd, &st) == 0){
+		if(S_ISBLK(st.st_mode)){
+			int lbs = 0 ;
+			if(ioctl(fd, BLKSSZGET, &lbs) == 0 && lbs > 0) align = (uint64_t)lbs ;
+		}else{
+#ifdef STATX_DIOALIGN
+			struct statx sx ;
+			if(statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &sx) == 0 && (sx.stx_mask & STATX_DIOALIGN) && sx.stx_dio_offset_align){
+				align = sx.stx_dio_offset_align ;
+			}
+#endif
+			if(!align && st.st_blksize > 0) align = (uint64_t)st.st_blksize ;
+		}
+	}
+	close(fd) ;
+	return align ? align : 512 ;
+}
+
+// Fills a regular file out to span with incompressible data so reads hit
+// real blocks, unlike the sparse file the fio runs were made against
+static bool layoutFile(const std::string& path, uint64_t span){
+	struct stat st ;
+	if(stat(path.c_str(), &st) == 0 && (S_ISBLK(st.st_mode) || (uint64_t)st.st_size >= span)) return true ;
+	int fd = open(path.c_str(), O_WRONLY | O_CREAT, 0644) ;
+	if(fd < 0){
+		std::cerr << "open " << path << ": " << std::strerror(errno) << "\n" ;
+		return false ;
+	}
+	std::cerr << "Laying out " << path << " to " << span << " bytes\n" ;
+	std::vector<uint64_t> chunk((size_t)1 << 17) ;	// 1 MiB
+	Rng rng(span) ;
+	uint64_t off = 0 ;
+	if(fstat(fd, &st) == 0) off = (uint64_t)st.st_size & ~(uint64_t)4095 ;
+	while(off < span){
+		for(auto& w : chunk) w = rng.next() ;
+		size_t n = (size_t)std::min<uint64_t>(chunk.size() * sizeof(uint64_t), span - off) ;
+		ssize_t w = pwrite(fd, chunk.data(), n, (off_t)off) ;
+		if(w <= 0){
+			std::cerr << "layout write: " << std::strerror(errno) << "\n" ;
+			close(fd) ;
+			return false ;
+		}
+		off += (uint64_t)w ;
+	}
+	fsync(fd) ;
+	close(fd) ;
+	return true ;
+}
+
+// Everything a job needs to issue I/O: the open target, a ring with one
+// entry per slot and one aligned buffer per slot, registered when asked.
+// issue() picks the next offset and direction for a slot and queues it.
+struct IoSession {
+	JobSpec job ;
+	EngineOptions eng ;
+	int fd = -1 ;
+	IoUring ring ;
+	unsigned char* bufs = nullptr ;
+	size_t slotBytes = 0 ;
+	uint64_t blocks = 0 ;
+	bool fixedBufs = false ;
+	bool fixedFile = false ;
+	Rng rng{1} ;
+	uint64_t seqBlock = 0 ;
+	std::vector<uint64_t> issuedAt ;
+	std::vector<uint8_t> isWrite ;
+
+	~IoSession(){
+		ring.close() ;
+		free(bufs) ;
+		if(fd >= 0) close(fd) ;
+	}
+
+	bool open(const std::string& target, const JobSpec& j, const EngineOptions& e){
+		job = j ;
+		eng = e ;
+		uint64_t targetBytes = 0 ;
+		fd = openTarget(target, eng.direct, &targetBytes) ;
+		if(fd < 0) return false ;
+		blocks = targetBytes > job.offset ? std::min<uint64_t>(job.span, targetBytes - job.offset) / job.bs : 0 ;
+		if(blocks == 0){
+			std::cerr << job.name << ": target smaller than one block\n" ;
+			return false ;
+		}
+		int r = ring.init(job.qd, eng.sqpoll) ;
+		if(r < 0){
+			std::cerr << "io_uring_setup: " << std::strerror(-r) << "\n" ;
+			return false ;
+		}
+
+		// Random bytes so writes are incompressible
+		slotBytes = (job.bs + 4095) & ~(size_t)4095 ;
+		void* mem = nullptr ;
+		if(posix_memalign(&mem, 4096, slotBytes * job.qd) != 0){
+			std::cerr << "alloc failed for qd=" << job.qd << " bs=" << job.bs << "\n" ;
+			return false ;
+		}
+		bufs = (unsigned char*)mem ;
+		Rng fill(job.bs * 131 + job.qd) ;
+		for(size_t i = 0; i + 8 <= slotBytes * job.qd; i += 8){
+			uint64_t v = fill.next() ;
+			std::memcpy(bufs + i, &v, 8) ;
+		}
+
+		if(eng.fixed){
+			std::vector<iovec> iov(job.qd) ;
+			for(unsigned i = 0; i < job.qd; i++) iov[i] = {bufs + i * slotBytes, job.bs} ;
+			r = ring.registerBuffers(iov.data(), job.qd) ;
+			if(r < 0) std::cerr << "buffer registration failed (" << std::strerror(-r) << "); using plain buffers\n" ;
+			fixedBufs = r == 0 ;
+			r = ring.registerFiles(&fd, 1) ;
+			if(r < 0) std::cerr << "file registration failed (" << std::strerror(-r) << "); using the plain fd\n" ;
+			fixedFile = r == 0 ;
+		}
+		issuedAt.assign(job.qd, 0) ;
+		isWrite.assign(job.qd, 0) ;
+		rng = Rng(nowNs()) ;
+		return true ;
+	}
+
+	bool issue(unsigned slot){
+		io_uring_sqe* sqe = ring.getSqe() ;
+		if(!sqe) return false ;
+		uint64_t block = job.random ? rng.below(blocks) : seqBlock++ % blocks ;
+		bool write = job.readPct <= 0 || (job.readPct < 100 && (int)rng.below(100) >= job.readPct) ;
+		prepRw(sqe, write, fixedFile ? 0 : fd, bufs + slot * slotBytes, (unsigned)job.bs, job.offset + block * job.bs,
+			fixedBufs ? (int)slot : -1, fixedFile) ;
+		sqe->user_data = slot ;
+		isWrite[slot] = write ;
+		issuedAt[slot] = nowNs() ;
+		return true ;
+	}
+
+	// A full-length transfer; anything else is reported once per job
+	bool completed(int rc, bool& reported) const {
+		if(rc == (int)job.bs) return true ;
+		if(!reported) std::cerr << job.name << ": I/O returned " << (rc < 0 ? std::strerror(-rc) : std::to_string(rc).c_str()) << "\n" ;
+		reported = true ;
+		return false ;
+	}
+} ;
+
+static void finishResult(JobResult& res, const JobSpec& job, uint64_t start, uint64_t end, const LatencyHistogram& lat, bool failed){
+	res.ios = res.reads + res.writes ;
+	res.bytes = res.ios * job.bs ;
+	res.seconds = (double)(end - start) / 1e9 ;
+	res.avgNs = lat.mean() ;
+	res.p95Ns = (double)lat.valueAt(0.95) ;
+	res.p99Ns = (double)lat.valueAt(0.99) ;
+	res.p999Ns = (double)lat.valueAt(0.999) ;
+	res.ok = !failed && res.ios > 0 ;
+}
+
+// Closed-loop run at a fixed queue depth: every completion immediately
+// reissues its slot until runtime is up, then the queue drains. Latency is
+// per I/O from just before submission to reaping, fio's clat.
+static void closedLoop(IoSession& s, JobResult& res, LatencyHistogram& lat){
+	const JobSpec& job = s.job ;
+	uint64_t start = nowNs() ;
+	uint64_t deadline = start + (uint64_t)(job.runtime * 1e9) ;
+	unsigned inflight = 0 ;
+	for(unsigned slot = 0; slot < job.qd; slot++) inflight += s.issue(slot) ;
+	bool failed = false ;
+	while(inflight){
+		int r = s.ring.submit(1) ;
+		if(r < 0){
+			std::cerr << "io_uring_enter: " << std::strerror(-r) << "\n" ;
+			failed = true ;
+			break ;
+		}
+		io_uring_cqe* cqe ;
+		while((cqe = s.ring.peekCqe())){
+			uint64_t now = nowNs() ;
+			unsigned slot = (unsigned)cqe->user_data ;
+			int rc = cqe->res ;
+			s.ring.cqeSeen() ;
+			inflight-- ;
+			if(!s.completed(rc, failed)) continue ;
+			lat.record(now - s.issuedAt[slot]) ;
+			if(s.isWrite[slot]) res.writes++ ;
+			else res.reads++ ;
+			if(!failed && now < deadline) inflight += s.issue(slot) ;
+		}
+	}
+	finishResult(res, job, start, nowNs(), lat, failed) ;
+}
+
+static JobResult runJob(const std::string& target, const JobSpec& job, EngineOptions eng){
+	JobResult res ;
+	IoSession s ;
+	if(!s.open(target, job, eng)) return res ;
+	LatencyHistogram lat ;
+	closedLoop(s, res, lat) ;
+	return res ;
+}
+
+// Open loop: I/Os are due on a schedule at the offered rate, Poisson or
+// evenly spaced, whatever the device is doing. job.qd caps what may be
+// outstanding; past that, due I/Os wait for a slot but keep their scheduled
+// time. Latency counts from that intended time, so a stall shows up in
+// every I/O queued behind it instead of being hidden by a closed loop that
+// simply stops issuing (coordinated omission). Service time from the actual
+// submission and the issue delay are kept alongside for comparison.
+struct OpenLoopResult {
+	JobResult io ;
+	double offered = 0.0 ;
+	LatencyHistogram lat ;		// intended send -> completion
+	LatencyHistogram svc ;		// submission -> completion
+	LatencyHistogram delay ;	// intended send -> submission
+} ;
+
+static bool runOpenLoop(const std::string& target, const JobSpec& job, EngineOptions eng, double rate, bool poisson, OpenLoopResult& out){
+	IoSession s ;
+	if(!s.open(target, job, eng)) return false ;
+	out.offered = rate ;
+	std::vector<unsigned> freeSlots ;
+	for(unsigned slot = job.qd; slot-- > 0;) freeSlots.push_back(slot) ;
+	std::vector<uint64_t> intendedAt(job.qd) ;
+	Rng arrivals(nowNs() ^ 0x5bd1e995ull) ;
+	double meanGap = 1e9 / rate ;
+	auto gap = [&]() -> double {
+		if(!poisson) return meanGap ;
+		double u = (double)(arrivals.next() >> 11) * 0x1.0p-53 ;
+		return -std::log1p(-u) * meanGap ;
+	} ;
+
+	uint64_t start = nowNs() ;
+	uint64_t deadline = start + (uint64_t)(job.runtime * 1e9) ;
+	double next = (double)start ;
+	unsigned inflight = 0 ;
+	bool failed = false ;
+	for(;;){
+		uint64_t now = nowNs() ;
+		bool queued = false ;
+		while(!failed && next < (double)deadline && next <= (double)now && !freeSlots.empty()){
+			unsigned slot = freeSlots.back() ;
+			if(!s.issue(slot)) break ;
+			freeSlots.pop_back() ;
+			intendedAt[slot] = (uint64_t)next ;
+			out.delay.record(s.issuedAt[slot] - intendedAt[slot]) ;
+			inflight++ ;
+			queued = true ;
+			next += gap() ;
+		}
+		if(queued){
+			int r = s.ring.submit(0) ;
+			if(r < 0){
+				std::cerr << "io_uring_enter: " << std::strerror(-r) << "\n" ;
+				failed = true ;
+				break ;
+			}
+		}
+		bool reaped = false ;
+		io_uring_cqe* cqe ;
+		while((cqe = s.ring.peekCqe())){
+			uint64_t done = nowNs() ;
+			unsigned slot = (unsigned)cqe->user_data ;
+			int rc = cqe->res ;
+			s.ring.cqeSeen() ;
+			inflight-- ;
+			freeSlots.push_back(slot) ;
+			reaped = true ;
+			if(!s.completed(rc, failed)) continue ;
+			out.lat.record(done - intendedAt[slot]) ;
+			out.svc.record(done - s.issuedAt[slot]) ;
+			if(s.isWrite[slot]) out.io.writes++ ;
+			else out.io.reads++ ;
+		}
+		bool moreDue = !failed && next < (double)deadline ;
+		if(!moreDue && !inflight) break ;
+		if(reaped || queued) continue ;
+
+		// Idle until the next due time or a completion, whichever is first.
+		// Short gaps are spun; sleeping that close would overshoot.
+		now = nowNs() ;
+		uint64_t wait = moreDue && !freeSlots.empty() ? (next > (double)now ? (uint64_t)(next - (double)now) : 0) : UINT64_MAX ;
+		if(wait < 20000) continue ;
+		if(inflight) s.ring.waitCqeTimeout(wait == UINT64_MAX ? 1000000000ull : wait) ;
+		else {
+			timespec ts = {(time_t)(wait / 1000000000ull), (long)(wait % 1000000000ull)} ;
+			nanosleep(&ts, nullptr) ;
+		}
+	}
+	finishResult(out.io, job, start, nowNs(), out.lat, failed) ;
+	return out.io.ok ;
+}
+
+// ---- File-read access methods ----
+// The same read workload through each way a service can read a file:
+// buffered pread, mmap under three madvise hints, O_DIRECT pread and
+// io_uring (O_DIRECT, --qd deep). Every method consumes what it reads the
+// same way, one word per cache line, which for mmap is also what faults the
+// pages in. Runs start warm (file read through the page cache first) or
+// cold (clean pages dropped with POSIX_FADV_DONTNEED); cached_pct records
+// what mincore saw so a filesystem that ignores the drop (tmpfs) is visible.
+
+enum ReadMethod { RM_PREAD, RM_MMAP_SEQ, RM_MMAP_RANDOM, RM_MMAP_HUGE, RM_DIRECT, RM_URING, RM_COUNT } ;
+
+static const char* const readMethodNames[RM_COUNT] = {
+	"pread", "mmap_seq", "mmap_random", "mmap_huge", "odirect", "io_uring"
+} ;
+
+// One workload: a single sequential pass in bs chunks, or random bs reads
+struct ReadWorkload {
+	std::string name ;
+	bool random ;
+	size_t bs ;
+} ;
+
+struct AccessRun {
+	LatencyHistogram lat ;
+	uint64_t ops = 0 ;
+	uint64_t bytes = 0 ;
+	double seconds = 0.0 ;
+	double cpuSeconds = 0.0 ;	// user + system, all threads (io-wq included)
+	bool ok = false ;
+} ;
+
+static volatile uint64_t consumeSink ;
+
+static inline void consume(const unsigned char* p, size_t n){
+	uint64_t sum = 0 ;
+	for(size_t i = 0; i < n; i += 64){
+		uint64_t v ;
+		std::memcpy(&v, p + i, sizeof(v)) ;
+		sum += v ;
+	}
+	consumeSink = consumeSink + sum ;
+}
+
+static double cpuSeconds(){
+	rusage ru ;
+	getrusage(RUSAGE_SELF, &ru) ;
+	return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) + (double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6 ;
+}
+
+// TSC ticks per second, so CPU time converts to (reference) cycles; 0 off
+// x86, where the shared clock's counter does not tick with the core
+static double tscHz(){
+#if defined(__x86_64__) || defined(__i386__)
+	return benchTickHz() ;
+#else
+	return 0.0 ;
+#endif
+}
+
+// Share of [0, span) resident in the page cache
+static double cachedPct(int fd, uint64_t span){
+	void* m = mmap(nullptr, span, PROT_READ, MAP_SHARED, fd, 0) ;
+	if(m == MAP_FAILED) return NAN ;
+	size_t pages = (size_t)((span + 4095) / 4096) ;
+	std::vector<unsigned char> vec(pages) ;
+	double pct = NAN ;
+	if(mincore(m, span, vec.data()) == 0){
+		size_t in = 0 ;
+		for(unsigned char v : vec) in += v & 1 ;
+		pct = 100.0 * (double)in / (double)pages ;
+	}
+	munmap(m, span) ;
+	return pct ;
+}
+
+// Warm: one buffered pass over span. Cold: write back and drop it.
+static void prepareCache(const std::string& path, uint64_t span, bool warm){
+	int fd = open(path.c_str(), O_RDONLY) ;
+	if(fd < 0) return ;
+	if(warm){
+		std::vector<unsigned char> buf((size_t)1 << 20) ;
+		for(uint64_t off = 0; off < span; off += buf.size()){
+			if(pread(fd, buf.data(), buf.size(), (off_t)off) <= 0) break ;
+		}
+	}
+	else {
+		fdatasync(fd) ;
+		posix_fadvise(fd, 0, (off_t)span, POSIX_FADV_DONTNEED) ;
+	}
+	close(fd) ;
+}
+
+// Runs op(i) for op index i until runtime, limit ops or a failed op; op
+// returns bytes read, 0 to stop
+template<typename Op>
+static void timedOps(AccessRun& run, uint64_t limit, double runtime, Op op){
+	double cpu0 = cpuSeconds() ;
+	uint64_t start = nowNs() ;
+	uint64_t deadline = start + (uint64_t)(runtime * 1e9) ;
+	uint64_t t1 = start ;
+	run.ok = true ;
+	for(uint64_t i = 0; i < limit; i++){
+		uint64_t t0 = nowNs() ;
+		size_t n = op(i) ;
+		t1 = nowNs() ;
+		if(n == 0){
+			run.ok = run.ops > 0 ;
+			break ;
+		}
+		run.lat.record(t1 - t0) ;
+		run.ops++ ;
+		run.bytes += n ;
+		if(t1 >= deadline) break ;
+	}
+	run.seconds = (double)(t1 - start) / 1e9 ;
+	run.cpuSeconds = cpuSeconds() - cpu0 ;
+}
+
+static AccessRun runSyncRead(const std::string& path, uint64_t span, const ReadWorkload& w, ReadMethod m, double runtime){
+	AccessRun run ;
+	uint64_t blocks = span / w.bs ;
+	uint64_t limit = w.random ? UINT64_MAX : blocks ;
+	Rng rng(nowNs()) ;
+	auto offsetOf = [&](uint64_t i){ return (w.random ? rng.below(blocks) : i) * w.bs ; } ;
+
+	if(m == RM_PREAD || m == RM_DIRECT){
+		int fd = open(path.c_str(), O_RDONLY | (m == RM_DIRECT ? O_DIRECT : 0)) ;
+		if(fd < 0){
+			std::cerr << readMethodNames[m] << ": open " << path << ": " << std::strerror(errno) << "\n" ;
+			return run ;
+		}
+		void* mem = nullptr ;
+		if(posix_memalign(&mem, 4096, w.bs) != 0){
+			close(fd) ;
+			return run ;
+		}
+		unsigned char* buf = (unsigned char*)mem ;
+		timedOps(run, limit, runtime, [&](uint64_t i) -> size_t {
+			ssize_t n = pread(fd, buf, w.bs, (off_t)offsetOf(i)) ;
+			if(n <= 0) return 0 ;
+			consume(buf, (size_t)n) ;
+			return (size_t)n ;
+		}) ;
+		free(mem) ;
+		close(fd) ;
+		return run ;
+	}
+
+	int fd = open(path.c_str(), O_RDONLY) ;
+	if(fd < 0){
+		std::cerr << readMethodNames[m] << ": open " << path << ": " << std::strerror(errno) << "\n" ;
+		return run ;
+	}
+	unsigned char* map = (unsigned char*)mmap(nullptr, span, PROT_READ, MAP_SHARED, fd, 0) ;
+	if(map == MAP_FAILED){
+		std::cerr << readMethodNames[m] << ": mmap: " << std::strerror(errno) << "\n" ;
+		close(fd) ;
+		return run ;
+	}
+	int advice = m == RM_MMAP_SEQ ? MADV_SEQUENTIAL : m == RM_MMAP_RANDOM ? MADV_RANDOM : MADV_HUGEPAGE ;
+	// File THP needs filesystem support; without it this is only a hint
+	if(madvise(map, span, advice) != 0){
+		std::cerr << readMethodNames[m] << ": madvise: " << std::strerror(errno) << " (continuing without)\n" ;
+	}
+	timedOps(run, limit, runtime, [&](uint64_t i) -> size_t {
+		consume(map + offsetOf(i), w.bs) ;
+		return w.bs ;
+	}) ;
+	munmap(map, span) ;
+	close(fd) ;
+	return run ;
+}
+
+// io_uring reads at job.qd through IoSession, consuming each buffer as it
+// completes; a sequential workload stops after one pass
+static AccessRun runUringRead(const std::string& path, uint64_t span, const ReadWorkload& w, unsigned qd, double runtime){
+	AccessRun run ;
+	JobSpec job ;
+	job.name = w.name ;
+	job.random = w.random ;
+	job.readPct = 100 ;
+	job.bs = w.bs ;
+	job.qd = qd ;
+	job.span = span ;
+	EngineOptions eng ;
+	IoSession s ;
+	if(!s.open(path, job, eng)) return run ;
+	uint64_t limit = w.random ? UINT64_MAX : s.blocks ;
+	uint64_t issued = 0 ;
+	double cpu0 = cpuSeconds() ;
+	uint64_t start = nowNs() ;
+	uint64_t deadline = start + (uint64_t)(runtime * 1e9) ;
+	unsigned inflight = 0 ;
+	bool failed = false ;
+	for(unsigned slot = 0; slot < qd && issued < limit; slot++){
+		inflight += s.issue(slot) ;
+		issued++ ;
+	}
+	while(inflight){
+		if(s.ring.submit(1) < 0){
+			failed = true ;
+			break ;
+		}
+		io_uring_cqe* cqe ;
+		while((cqe = s.ring.peekCqe())){
+			uint64_t now = nowNs() ;
+			unsigned slot = (unsigned)cqe->user_data ;
+			int rc = cqe->res ;
+			s.ring.cqeSeen() ;
+			inflight-- ;
+			if(!s.completed(rc, failed)) continue ;
+			consume(s.bufs + slot * s.slotBytes, w.bs) ;
+			run.lat.record(now - s.issuedAt[slot]) ;
+			run.ops++ ;
+			run.bytes += w.bs ;
+			if(!failed && now < deadline && issued < limit){
+				inflight += s.issue(slot) ;
+				issued++ ;
+			}
+		}
+	}
+	run.seconds = (double)(nowNs() - start) / 1e9 ;
+	run.cpuSeconds = cpuSeconds() - cpu0 ;
+	run.ok = !failed && run.ops > 0 ;
+	return run ;
+}
+
+// ---- Multi-threaded scaling ----
+// N workers, each pinned to its own CPU with its own ring, buffers and
+// target: a disjoint region of the one target, or with --files a file of
+// its own (target.0, target.1, ...). Nothing is shared while they run; each
+// writes only its own cache-line-aligned stats, merged after join, so the
+// measurement cannot serialize them. A worker's CPU use is its thread CPU
+// time over its wall time. That covers the submission syscalls and the
+// block-layer work done inline in them. Work punted to io-wq kernel workers
+// is not charged to the worker; buffered files and tmpfs punt.
+
+// CPUs this process may run on, in order; workers take them compactly
+static std::vector<int> allowedCpus(){
+	std::vector<int> cpus ;
+	cpu_set_t set ;
+	CPU_ZERO(&set) ;
+	if(sched_getaffinity(0, sizeof(set), &set) == 0){
+		for(int c = 0; c < CPU_SETSIZE; c++){
+			if(CPU_ISSET(c, &set)) cpus.push_back(c) ;
+		}
+	}
+	if(cpus.empty()) cpus.push_back(0) ;
+	return cpus ;
+}
+
+static bool pinCurrentThread(int cpu){
+	cpu_set_t set ;
+	CPU_ZERO(&set) ;
+	CPU_SET(cpu, &set) ;
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ;
+}
+
+static double threadCpuSeconds(){
+	timespec ts ;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) ;
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9 ;
+}
+
+struct alignas(64) ScaleWorker {
+	JobSpec job ;
+	std::string target ;
+	int cpu = 0 ;
+	bool ok = false ;
+	JobResult res ;
+	LatencyHistogram lat ;
+	double cpuSeconds = 0.0 ;
+} ;
+
+// Opens its session before the start flag so setup is not timed, then runs
+// the same closed loop as a single job
+static void scaleWorker(ScaleWorker* w, const EngineOptions* eng, std::atomic<int>* ready, std::atomic<bool>* go){
+	if(!pinCurrentThread(w->cpu)) std::cerr << "could not pin worker to cpu " << w->cpu << "\n" ;
+	IoSession s ;
+	bool opened = s.open(w->target, w->job, *eng) ;
+	s.rng = Rng(nowNs() + 0x9e3779b97f4a7c15ull * (uint64_t)(w->cpu + 1)) ;
+	ready->fetch_add(1) ;
+	while(!go->load(std::memory_order_acquire)) sched_yield() ;
+	if(!opened) return ;
+	double cpu0 = threadCpuSeconds() ;
+	closedLoop(s, w->res, w->lat) ;
+	w->cpuSeconds = threadCpuSeconds() - cpu0 ;
+	w->ok = w->res.ok ;
+}
+
+static std::string fileFor(const std::string& target, int t, bool perThreadFiles){
+	return perThreadFiles ? target + "." + std::to_string(t) : target ;
+}
+
+// One point of the sweep: job.qd is per worker. Regions split job.span
+// evenly in whole blocks; separate files each get all of job.span.
+static bool runScaling(const std::string& target, const JobSpec& job, const EngineOptions& eng, const std::vector<int>& cpus,
+	int threads, bool perThreadFiles, std::vector<ScaleWorker>& workers){
+	workers = std::vector<ScaleWorker>(threads) ;
+	uint64_t region = perThreadFiles ? job.span : job.span / (uint64_t)threads / job.bs * job.bs ;
+	for(int t = 0; t < threads; t++){
+		ScaleWorker& w = workers[t] ;
+		w.job = job ;
+		w.job.span = region ;
+		w.job.offset = perThreadFiles ? 0 : (uint64_t)t * region ;
+		w.target = fileFor(target, t, perThreadFiles) ;
+		w.cpu = cpus[t % cpus.size()] ;
+	}
+	std::atomic<int> ready(0) ;
+	std::atomic<bool> go(false) ;
+	std::vector<std::thread> pool ;
+	for(int t = 0; t < threads; t++) pool.emplace_back(scaleWorker, &workers[t], &eng, &ready, &go) ;
+	while(ready.load() < threads) sched_yield() ;
+	go.store(true, std::memory_order_release) ;
+	for(std::thread& th : pool) th.join() ;
+	for(const ScaleWorker& w : workers) if(!w.ok) return false ;
+	return true ;
+}
+
+// ---- Write-ahead-log durability ----
+// Commits append fixed-size records to a preallocated log (overwritten in a
+// ring, as WAL segments are recycled), and a commit returns only once its
+// record is durable under the chosen method:
+//   fsync / fdatasync   pwrite, then the sync call
+//   odsync              pwrite on an O_DSYNC descriptor
+//   sync_file_range     pwrite, then WAIT_BEFORE|WRITE|WAIT_AFTER on the
+//                       range. Not durable: neither metadata nor the device
+//                       cache is flushed. It is here as the cost floor.
+//   io_uring            WRITE linked to FSYNC(DATASYNC), one submit
+// Group commit: committer threads enqueue records; whichever finds no
+// leader becomes one, waits up to the batch window for batch_max records,
+// writes the batch as one contiguous append and syncs it once, then wakes
+// every committer it covered. batch_max 1 is one sync per commit.
+
+enum SyncMethod { SM_FSYNC, SM_FDATASYNC, SM_ODSYNC, SM_SYNC_FILE_RANGE, SM_URING, SM_COUNT } ;
+
+static const char* const syncMethodNames[SM_COUNT] = {
+	"fsync", "fdatasync", "odsync", "sync_file_range", "io_uring"
+} ;
+
+class GroupLog {
+public:
+	uint64_t batches = 0 ;
+	bool failed = false ;
+
+	GroupLog(SyncMethod m, size_t recordBytes, uint64_t logBytes, uint64_t maxBatch, uint64_t windowNs)
+		: method(m), record(recordBytes), span(logBytes / recordBytes * recordBytes), batchMax(maxBatch), window(windowNs) {}
+
+	~GroupLog(){
+		free(buf) ;
+		if(fd >= 0) close(fd) ;
+	}
+
+	bool open(const std::string& path){
+		if(span < record * batchMax){
+			std::cerr << "wal: log of " << span << " bytes cannot hold one batch of " << batchMax << " x " << record
+				<< "-byte records\n" ;
+			return false ;
+		}
+		fd = ::open(path.c_str(), O_WRONLY | (method == SM_ODSYNC ? O_DSYNC : 0)) ;
+		if(fd < 0){
+			std::cerr << "open " << path << ": " << std::strerror(errno) << "\n" ;
+			return false ;
+		}
+		void* mem = nullptr ;
+		if(posix_memalign(&mem, 4096, record * batchMax) != 0){
+			std::cerr << "wal: cannot allocate a " << record * batchMax << "-byte batch buffer\n" ;
+			return false ;
+		}
+		buf = (unsigned char*)mem ;
+		Rng fill(record) ;
+		for(size_t i = 0; i + 8 <= record * batchMax; i += 8){
+			uint64_t v = fill.next() ;
+			std::memcpy(buf + i, &v, 8) ;
+		}
+		if(method == SM_URING){
+			int r = ring.init(4) ;
+			if(r < 0){
+				std::cerr << "io_uring_setup: " << std::strerror(-r) << "\n" ;
+				return false ;
+			}
+		}
+		return true ;
+	}
+
+	// Blocks until this committer's record is durable; false on an I/O error
+	bool commit(){
+		std::unique_lock<std::mutex> lk(mutex) ;
+		uint64_t seq = nextSeq++ ;
+		fill.notify_one() ;
+		while(durableSeq <= seq && !failed){
+			if(leader){
+				done.wait(lk) ;
+				continue ;
+			}
+			leader = true ;
+			auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(window) ;
+			while(nextSeq - batchedSeq < batchMax && window){
+				if(fill.wait_until(lk, until) == std::cv_status::timeout) break ;
+			}
+			uint64_t from = batchedSeq ;
+			uint64_t n = std::min(nextSeq - batchedSeq, batchMax) ;
+			batchedSeq += n ;
+			lk.unlock() ;
+			bool ok = append(n * record) ;
+			lk.lock() ;
+			durableSeq = from + n ;
+			batches++ ;
+			failed = failed || !ok ;
+			leader = false ;
+			done.notify_all() ;
+		}
+		return !failed ;
+	}
+
+private:
+	SyncMethod method ;
+	size_t record ;
+	uint64_t span ;
+	uint64_t batchMax ;
+	uint64_t window ;
+	int fd = -1 ;
+	unsigned char* buf = nullptr ;
+	IoUring ring ;
+	uint64_t logOff = 0 ;		// leader only
+	std::mutex mutex ;
+	std::condition_variable fill ;	// leader waits for the batch to fill
+	std::condition_variable done ;	// committers wait for durability
+	uint64_t nextSeq = 0 ;
+	uint64_t batchedSeq = 0 ;
+	uint64_t durableSeq = 0 ;
+	bool leader = false ;
+
+	// One contiguous append of len bytes, then the sync; leader only
+	bool append(size_t len){
+		if(logOff + len > span) logOff = 0 ;
+		uint64_t off = logOff ;
+		logOff += len ;
+		if(method == SM_URING){
+			io_uring_sqe* w = ring.getSqe() ;
+			io_uring_sqe* f = ring.getSqe() ;
+			prepRw(w, true, fd, buf, (unsigned)len, off, -1, false) ;
+			w->flags |= IOSQE_IO_LINK ;
+			prepFsync(f, fd, true) ;
+			if(ring.submit(2) < 0) return false ;
+			bool ok = true ;
+			for(int i = 0; i < 2; i++){
+				io_uring_cqe* cqe = ring.waitCqe() ;
+				if(!cqe) return false ;
+				ok = ok && cqe->res >= 0 && (i == 1 || (size_t)cqe->res == len) ;
+				ring.cqeSeen() ;
+			}
+			return ok ;
+		}
+		for(size_t done = 0; done < len;){
+			ssize_t n = pwrite(fd, buf + done, len - done, (off_t)(off + done)) ;
+			if(n <= 0) return false ;
+			done += (size_t)n ;
+		}
+		switch(method){
+			case SM_FSYNC: return fsync(fd) == 0 ;
+			case SM_FDATASYNC: return fdatasync(fd) == 0 ;
+			case SM_SYNC_FILE_RANGE:
+				return sync_file_range(fd, (off_t)off, (off_t)len,
+					SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) == 0 ;
+			default: return true ;	// O_DSYNC: the write was the sync
+		}
+	}
+} ;
+
+struct alignas(64) Committer {
+	LatencyHistogram lat ;
+	uint64_t commits = 0 ;
+} ;
+
+struct WalResult {
+	LatencyHistogram lat ;
+	uint64_t commits = 0 ;
+	uint64_t batches = 0 ;
+	double seconds = 0.0 ;
+	bool ok = false ;
+} ;
+
+// committers threads commit back to back for runtime seconds
+static WalResult runWal(const std::string& path, SyncMethod m, size_t record, uint64_t span, int committers,
+	uint64_t batchMax, uint64_t windowNs, double runtime){
+	WalResult res ;
+	GroupLog log(m, record, span, batchMax, windowNs) ;
+	if(!log.open(path)) return res ;
+	std::vector<Committer> stats(committers) ;
+	uint64_t start = nowNs() ;
+	uint64_t deadline = start + (uint64_t)(runtime * 1e9) ;
+	std::vector<std::thread> pool ;
+	for(int t = 0; t < committers; t++){
+		pool.emplace_back([&, t](){
+			Committer& c = stats[t] ;
+			for(uint64_t now = nowNs(); now < deadline;){
+				if(!log.commit()) return ;
+				uint64_t end = nowNs() ;
+				c.lat.record(end - now) ;
+				c.commits++ ;
+				now = end ;
+			}
+		}) ;
+	}
+	for(std::thread& th : pool) th.join() ;
+	res.seconds = (double)(nowNs() - start) / 1e9 ;
+	for(const Committer& c : stats){
+		res.lat.merge(c.lat) ;
+		res.commits += c.commits ;
+	}
+	res.batches = log.batches ;
+	res.ok = !log.failed && res.commits > 0 ;
+	if(log.failed) std::cerr << syncMethodNames[m] << ": log write or sync failed\n" ;
+	return res ;
+}
+
+// The jobs of runFioSweeps.sh under the same names, minus preconditioning.
+// span 0 keeps the script's --size per job; the tail runs are 10x runtime
+// where the script runs 300 s against a 30 s default.
+static std::vector<JobSpec> fioSweepJobs(size_t span, double runtime){
+	const size_t G = (size_t)1 << 30 ;
+	std::vector<JobSpec> jobs ;
+	auto add = [&](const std::string& name, bool random, int readPct, size_t bs, unsigned qd, size_t size, double secs){
+		JobSpec j ;
+		j.name = name ;
+		j.random = random ;
+		j.readPct = readPct ;
+		j.bs = bs ;
+		j.qd = qd ;
+		j.span = span ? span : size ;
+		j.runtime = secs ;
+		jobs.push_back(j) ;
+	} ;
+	add("randread_4k_qd1", true, 100, 4096, 1, G, runtime) ;
+	add("randwrite_4k_qd1", true, 0, 4096, 1, G, runtime) ;
+	add("seqread_128k_qd1", false, 100, 128 << 10, 1, 4 * G, runtime) ;
+	add("seqwrite_128k_qd1", false, 0, 128 << 10, 1, 4 * G, runtime) ;
+	for(size_t kb : {4, 16, 32, 64, 128, 256}){
+		add("randread_bs_" + std::to_string(kb) + "k", true, 100, kb << 10, 32, 4 * G, runtime) ;
+		add("seqread_bs_" + std::to_string(kb) + "k", false, 100, kb << 10, 32, 4 * G, runtime) ;
+	}
+	add("rand_read_100", true, 100, 4096, 32, 4 * G, runtime) ;
+	add("rand_write_100", true, 0, 4096, 32, 4 * G, runtime) ;
+	add("rand_mix_70r", true, 70, 4096, 32, 4 * G, runtime) ;
+	add("rand_mix_50r", true, 50, 4096, 32, 4 * G, runtime) ;
+	for(unsigned qd : {1, 2, 4, 8, 16, 32, 64}){
+		add("randread_qd" + std::to_string(qd), true, 100, 4096, qd, 4 * G, runtime) ;
+	}
+	add("tail_randread", true, 100, 4096, 32, 4 * G, runtime * 10) ;
+	add("tail_randwrite", true, 0, 4096, 32, 4 * G, runtime * 10) ;
+	return jobs ;
+}
+
+// summary.csv's columns: file is the job name where fio had its JSON file,
+// name is the engine, rw is read/write/mixed, bw in MiB/s like the fio parse
+static const char* summaryHeader = "file,name,rw,bw_MB_s,iops,avg_lat_ns,p95_ns,p99_ns,p99.9_ns\n" ;
+
+static std::string engineName(const EngineOptions& eng){
+	return std::string("io_uring") + (eng.direct ? "" : "_buffered") + (eng.sqpoll ? "_sqpoll" : "") ;
+}
+
+static const char* rwName(const JobResult& res){
+	return res.writes == 0 ? "read" : res.reads == 0 ? "write" : "mixed" ;
+}
+
+// Shared-schema records (--results): IOPS and mean latency keyed by the job
+// and engine, one sample per independent run (--repeats). Slices of a single
+// run would be autocorrelated (same file layout, device state and GC phase),
+// which the comparison's test cannot take as independent samples.
+static void jobResults(bench_results_t& results, const JobSpec& job, const EngineOptions& eng, const std::vector<JobResult>& runs){
+	for(int latency = 0; latency < 2; latency++){
+		benchResultBegin(&results, latency ? "storage.mean_latency" : "storage.iops", latency ? "ns" : "iops", latency) ;
+		benchResultParam(&results, "job", job.name.c_str()) ;
+		benchResultParam(&results, "engine", engineName(eng).c_str()) ;
+		benchResultParam(&results, "pattern", job.random ? "random" : "sequential") ;
+		benchResultParamNum(&results, "read_pct", job.readPct) ;
+		benchResultParamNum(&results, "bs", (double)job.bs) ;
+		benchResultParamNum(&results, "qd", job.qd) ;
+		for(const JobResult& res : runs) benchResultSample(&results, latency ? res.avgNs : (double)res.ios / res.seconds) ;
+		benchResultEnd(&results) ;
+	}
+}
+
+static std::string summaryRow(const JobSpec& job, const EngineOptions& eng, const JobResult& res){
+	char line[512] ;
+	std::snprintf(line, sizeof(line), "%s,%s,%s,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g\n",
+		job.name.c_str(), engineName(eng).c_str(), rwName(res),
+		(double)res.bytes / res.seconds / (1024.0 * 1024.0), (double)res.ios / res.seconds,
+		res.avgNs, res.p95Ns, res.p99Ns, res.p999Ns) ;
+	return line ;
+}
+
+// One row per offered rate: the latency-vs-offered-load curve. Latency
+// columns are from the intended send time; svc_* from actual submission.
+static const char* openLoopHeader = "file,name,rw,arrival,offered_iops,iops,bw_MB_s,avg_lat_ns,p50_ns,p90_ns,p99_ns,"
+	"p99.9_ns,p99.99_ns,p99.999_ns,max_ns,svc_avg_ns,svc_p50_ns,svc_p99_ns,svc_p99.9_ns,delay_p99_ns,delay_max_ns\n" ;
+
+static std::string openLoopRow(const JobSpec& job, const EngineOptions& eng, bool poisson, const OpenLoopResult& r){
+	char line[1024] ;
+	const LatencyHistogram& l = r.lat ;
+	const LatencyHistogram& s = r.svc ;
+	std::snprintf(line, sizeof(line), "%s,%s,%s,%s,%.10g,%.10g,%.10g,%.10g,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.10g,%llu,%llu,%llu,%llu,%llu\n",
+		job.name.c_str(), engineName(eng).c_str(), rwName(r.io), poisson ? "poisson" : "fixed", r.offered,
+		(double)r.io.ios / r.io.seconds, (double)r.io.bytes / r.io.seconds / (1024.0 * 1024.0), l.mean(),
+		(unsigned long long)l.valueAt(0.5), (unsigned long long)l.valueAt(0.9), (unsigned long long)l.valueAt(0.99),
+		(unsigned long long)l.valueAt(0.999), (unsigned long long)l.valueAt(0.9999), (unsigned long long)l.valueAt(0.99999),
+		(unsigned long long)l.max(), s.mean(), (unsigned long long)s.valueAt(0.5), (unsigned long long)s.valueAt(0.99),
+		(unsigned long long)s.valueAt(0.999), (unsigned long long)r.delay.valueAt(0.99), (unsigned long long)r.delay.max()) ;
+	return line ;
+}
+
+// Full percentile spectrum per offered rate, for --curves
+static const char* curveHeader = "file,offered_iops,percentile,lat_ns,svc_ns\n" ;
+
+static std::string curveRows(const JobSpec& job, const OpenLoopResult& r){
+	std::string rows ;
+	char line[256] ;
+	for(const auto& pt : r.lat.curve()){
+		std::snprintf(line, sizeof(line), "%s,%.10g,%.10g,%llu,%llu\n", job.name.c_str(), r.offered, pt.first * 100.0,
+			(unsigned long long)pt.second, (unsigned long long)r.svc.valueAt(pt.first)) ;
+		rows += line ;
+	}
+	return rows ;
+}
+
+// stdout plus an optional copy on disk, flushed per row so a long sweep can
+// be watched or cut short
+struct CsvOut {
+	std::ofstream file ;
+
+	bool open(const std::string& path){
+		if(path.empty()) return true ;
+		file.open(path) ;
+		if(!file) std::cerr << "cannot write " << path << "\n" ;
+		return (bool)file ;
+	}
+
+	void emit(const std::string& s){
+		std::cout << s ;
+		std::cout.flush() ;
+		if(file.is_open()){
+			file << s ;
+			file.flush() ;
+		}
+	}
+} ;
+
+// Offered rates as given, or fractions of the closed-loop peak at the same
+// queue-depth cap, run first for up to 5 s, reaching just past saturation
+static std::vector<double> openLoopRates(const std::string& target, const JobSpec& job, const EngineOptions& eng, const std::vector<double>& given){
+	if(!given.empty()) return given ;
+	JobSpec peakJob = job ;
+	peakJob.runtime = std::min(job.runtime, 5.0) ;
+	JobResult peak = runJob(target, peakJob, eng) ;
+	if(!peak.ok) return {} ;
+	double iops = (double)peak.ios / peak.seconds ;
+	std::cerr << "closed-loop peak at qd=" << job.qd << ": " << iops << " IOPS\n" ;
+	std::vector<double> rates ;
+	for(double f : {0.1, 0.25, 0.5, 0.7, 0.8, 0.9, 0.95, 1.0, 1.1}) rates.push_back(std::round(iops * f)) ;
+	return rates ;
+}
+
+static int benchmarkOpenLoop(const std::string& target, const JobSpec& job, const EngineOptions& eng, const std::vector<double>& given,
+	bool poisson, CsvOut& out, const std::string& curvesPath){
+	// Sleeps toward a send time must not be rounded up by the default 50us slack
+	prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0) ;
+	CsvOut curves ;
+	if(!curvesPath.empty()){
+		curves.file.open(curvesPath) ;
+		if(!curves.file){
+			std::cerr << "cannot write " << curvesPath << "\n" ;
+			return 1 ;
+		}
+		curves.file << curveHeader ;
+	}
+	std::vector<double> rates = openLoopRates(target, job, eng, given) ;
+	if(rates.empty()) return 1 ;
+	out.emit(openLoopHeader) ;
+	int failures = 0 ;
+	for(double rate : rates){
+		std::cerr << job.name << ": offered " << rate << " IOPS " << (poisson ? "poisson" : "fixed") << " cap qd=" << job.qd << "\n" ;
+		OpenLoopResult r ;
+		if(rate <= 0.0 || !runOpenLoop(target, job, eng, rate, poisson, r)){
+			failures++ ;
+			continue ;
+		}
+		out.emit(openLoopRow(job, eng, poisson, r)) ;
+		if(curves.file.is_open()){
+			curves.file << curveRows(job, r) ;
+			curves.file.flush() ;
+		}
+	}
+	return failures ? 1 : 0 ;
+}
+
+static const char* accessHeader = "file,method,workload,cache,size,bs,qd,cached_pct,ops,bw_MB_s,iops,avg_lat_ns,p50_ns,p99_ns,p99.9_ns,"
+	"cpu_pct,cpu_ns_per_byte,cycles_per_byte\n" ;
+
+static std::string accessRow(const std::string& file, ReadMethod m, const ReadWorkload& w, bool warm, uint64_t span,
+	unsigned qd, double cached, const AccessRun& r){
+	char line[1024] ;
+	double cyclesPerByte = tscHz() > 0.0 ? r.cpuSeconds * tscHz() / (double)r.bytes : NAN ;
+	std::snprintf(line, sizeof(line), "%s,%s,%s,%s,%llu,%zu,%u,%.4g,%llu,%.10g,%.10g,%.10g,%llu,%llu,%llu,%.4g,%.6g,%.6g\n",
+		file.c_str(), readMethodNames[m], w.name.c_str(), warm ? "warm" : "cold", (unsigned long long)span, w.bs,
+		m == RM_URING ? qd : 1, cached, (unsigned long long)r.ops,
+		(double)r.bytes / r.seconds / (1024.0 * 1024.0), (double)r.ops / r.seconds, r.lat.mean(),
+		(unsigned long long)r.lat.valueAt(0.5), (unsigned long long)r.lat.valueAt(0.99), (unsigned long long)r.lat.valueAt(0.999),
+		100.0 * r.cpuSeconds / r.seconds, r.cpuSeconds * 1e9 / (double)r.bytes, cyclesPerByte) ;
+	return line ;
+}
+
+// File sizes for --sizes auto: a quarter of RAM up to one and a half times
+// RAM, so the later sizes no longer fit in the page cache
+static std::vector<size_t> autoFileSizes(){
+	long pages = sysconf(_SC_PHYS_PAGES) ;
+	long pageSize = sysconf(_SC_PAGESIZE) ;
+	double ram = pages > 0 && pageSize > 0 ? (double)pages * (double)pageSize : 8.0 * (1 << 30) ;
+	std::vector<size_t> sizes ;
+	for(double f : {0.25, 0.5, 1.0, 1.5}) sizes.push_back((size_t)(ram * f) & ~(((size_t)1 << 20) - 1)) ;
+	return sizes ;
+}
+
+// Sizes x workloads x warm/cold x methods. The random workloads use bsList
+// (default 4k-1M); the scan always reads 1 MiB chunks.
+static int benchmarkAccess(const std::string& target, const std::vector<size_t>& sizes, const std::vector<size_t>& bsList,
+	const std::vector<int>& methods, const std::vector<bool>& caches, unsigned qd, double runtime, CsvOut& out){
+	std::vector<ReadWorkload> workloads = {{"seq_scan", false, (size_t)1 << 20}} ;
+	for(size_t bs : bsList) workloads.push_back({"rand_" + std::to_string(bs >> 10) + "k", true, bs}) ;
+	std::string file = target.substr(target.find_last_of('/') + 1) ;
+	out.emit(accessHeader) ;
+	int failures = 0 ;
+	for(size_t size : sizes){
+		if(!layoutFile(target, size)) return 1 ;
+		for(const ReadWorkload& w : workloads){
+			if(w.bs > size) continue ;
+			for(bool warm : caches){
+				for(int mi : methods){
+					ReadMethod m = (ReadMethod)mi ;
+					prepareCache(target, size, warm) ;
+					int fd = open(target.c_str(), O_RDONLY) ;
+					double cached = fd >= 0 ? cachedPct(fd, size) : NAN ;
+					if(fd >= 0) close(fd) ;
+					std::cerr << readMethodNames[m] << " " << w.name << " " << (warm ? "warm" : "cold") << " size=" << size
+						<< " cached=" << cached << "%\n" ;
+					AccessRun r = m == RM_URING ? runUringRead(target, size, w, qd, runtime) : runSyncRead(target, size, w, m, runtime) ;
+					if(!r.ok){
+						failures++ ;
+						continue ;
+					}
+					out.emit(accessRow(file, m, w, warm, size, qd, cached, r)) ;
+				}
+			}
+		}
+	}
+	return failures ? 1 : 0 ;
+}
+
+// Aggregates over the workers of one point; thread_cpu_pct lists each
+// worker's CPU utilisation, ';'-separated in CPU order
+static const char* scaleHeader = "file,name,rw,threads,qd_per_thread,bw_MB_s,iops,iops_per_thread,avg_lat_ns,p50_ns,p99_ns,p99.9_ns,"
+	"cpu_pct_avg,cpu_pct_min,cpu_pct_max,cpu_us_per_io,thread_cpu_pct\n" ;
+
+static std::string scaleRow(const JobSpec& job, const EngineOptions& eng, const std::vector<ScaleWorker>& workers){
+	LatencyHistogram lat ;
+	JobResult all ;
+	double iops = 0.0, bw = 0.0, cpuSum = 0.0, cpuMin = 1e300, cpuMax = 0.0, cpuSeconds = 0.0 ;
+	std::string perThread ;
+	char num[32] ;
+	for(const ScaleWorker& w : workers){
+		lat.merge(w.lat) ;
+		all.reads += w.res.reads ;
+		all.writes += w.res.writes ;
+		iops += (double)w.res.ios / w.res.seconds ;
+		bw += (double)w.res.bytes / w.res.seconds ;
+		double pct = 100.0 * w.cpuSeconds / w.res.seconds ;
+		cpuSum += pct ;
+		cpuMin = std::min(cpuMin, pct) ;
+		cpuMax = std::max(cpuMax, pct) ;
+		cpuSeconds += w.cpuSeconds ;
+		std::snprintf(num, sizeof(num), "%s%.4g", perThread.empty() ? "" : ";", pct) ;
+		perThread += num ;
+	}
+	double n = (double)workers.size() ;
+	char line[1024] ;
+	std::snprintf(line, sizeof(line), "%s,%s,%s,%zu,%u,%.10g,%.10g,%.10g,%.10g,%llu,%llu,%llu,%.4g,%.4g,%.4g,%.6g,%s\n",
+		job.name.c_str(), engineName(eng).c_str(), rwName(all), workers.size(), job.qd, bw / (1024.0 * 1024.0), iops, iops / n,
+		lat.mean(), (unsigned long long)lat.valueAt(0.5), (unsigned long long)lat.valueAt(0.99), (unsigned long long)lat.valueAt(0.999),
+		cpuSum / n, cpuMin, cpuMax, cpuSeconds * 1e6 / (double)(all.reads + all.writes), perThread.c_str()) ;
+	return line ;
+}
+
+// Every thread count from 1 to maxThreads (default: every allowed CPU)
+static int benchmarkScaling(const std::string& target, const JobSpec& job, const EngineOptions& eng, int maxThreads,
+	bool perThreadFiles, CsvOut& out){
+	std::vector<int> cpus = allowedCpus() ;
+	if(maxThreads <= 0) maxThreads = (int)cpus.size() ;
+	if(maxThreads > (int)cpus.size()) std::cerr << "more threads than CPUs; workers will share CPUs\n" ;
+	for(int t = 0; t < (perThreadFiles ? maxThreads : 1); t++){
+		if(!layoutFile(fileFor(target, t, perThreadFiles), job.span)) return 1 ;
+	}
+	out.emit(scaleHeader) ;
+	int failures = 0 ;
+	for(int threads = 1; threads <= maxThreads; threads++){
+		std::cerr << job.name << ": threads=" << threads << " qd/thread=" << job.qd << "\n" ;
+		std::vector<ScaleWorker> workers ;
+		if(!runScaling(target, job, eng, cpus, threads, perThreadFiles, workers)){
+			failures++ ;
+			continue ;
+		}
+		out.emit(scaleRow(job, eng, workers)) ;
+	}
+	return failures ? 1 : 0 ;
+}
+
+static const char* walHeader = "file,sync,committers,batch_max,window_us,record_bytes,commits_per_s,MB_s,syncs_per_s,avg_batch,"
+	"avg_lat_ns,p50_ns,p99_ns,p99.9_ns,max_ns\n" ;
+
+static std::string walRow(const std::string& file, SyncMethod m, int committers, uint64_t batchMax, uint64_t windowNs,
+	size_t record, const WalResult& r){
+	char line[1024] ;
+	std::snprintf(line, sizeof(line), "%s,%s,%d,%llu,%.10g,%zu,%.10g,%.10g,%.10g,%.4g,%.10g,%llu,%llu,%llu,%llu\n",
+		file.c_str(), syncMethodNames[m], committers, (unsigned long long)batchMax, (double)windowNs / 1000.0, record,
+		(double)r.commits / r.seconds, (double)(r.commits * record) / r.seconds / (1024.0 * 1024.0),
+		(double)r.batches / r.seconds, r.batches ? (double)r.commits / (double)r.batches : 0.0, r.lat.mean(),
+		(unsigned long long)r.lat.valueAt(0.5), (unsigned long long)r.lat.valueAt(0.99), (unsigned long long)r.lat.valueAt(0.999),
+		(unsigned long long)r.lat.max()) ;
+	return line ;
+}
+
+// Sync methods x batch sizes. Without a fixed committer count each point
+// runs batch_max committers, just enough to fill a batch.
+static int benchmarkWal(const std::string& target, const std::vector<int>& methods, const std::vector<size_t>& batchList,
+	int committers, size_t record, uint64_t span, uint64_t windowNs, double runtime, CsvOut& out){
+	if(!layoutFile(target, span)) return 1 ;
+	std::string file = target.substr(target.find_last_of('/') + 1) ;
+	out.emit(walHeader) ;
+	int failures = 0 ;
+	for(int mi : methods){
+		SyncMethod m = (SyncMethod)mi ;
+		for(size_t batch : batchList){
+			int n = committers > 0 ? committers : (int)batch ;
+			std::cerr << syncMethodNames[m] << ": batch_max=" << batch << " committers=" << n << "\n" ;
+			WalResult r = runWal(target, m, record, span, n, batch, windowNs, runtime) ;
+			if(!r.ok){
+				failures++ ;
+				continue ;
+			}
+			out.emit(walRow(file, m, n, batch, windowNs, record, r)) ;
+		}
+	}
+	return failures ? 1 : 0 ;
+}
+
+// ---- Trace replay ----
+// A trace is text, one I/O per line: timestamp_ns,offset,size,op with op R
+// or W; '#' lines are comments. `import` converts blkparse text output, so
+// a capture is
+//   blktrace -d /dev/nvme0n1 -o - | blkparse -i - > trace.txt
+//   StorageBench import --blkparse trace.txt --out trace.csv
+// Replay issues each I/O at its original offset from the trace start,
+// divided by --speed, from one thread driving one ring, like openloop: a
+// slow completion never holds back later sends, and up to --qd I/Os may be
+// outstanding. Offsets past the target wrap. Latency is kept per op from
+// actual submission and from the intended time, next to the issue
+// deviation (actual minus intended submission).
+
+struct TraceOp {
+	uint64_t ts ;		// ns from the first I/O
+	uint64_t offset ;
+	uint32_t size ;
+	bool write ;
+} ;
+
+static bool loadTrace(const std::string& path, std::vector<TraceOp>& ops){
+	std::ifstream in(path) ;
+	if(!in){
+		std::cerr << "cannot read " << path << "\n" ;
+		return false ;
+	}
+	std::string line ;
+	size_t lineNo = 0 ;
+	while(std::getline(in, line)){
+		lineNo++ ;
+		if(line.empty() || line[0] == '#') continue ;
+		unsigned long long ts, off, size ;
+		char op ;
+		if(std::sscanf(line.c_str(), "%llu,%llu,%llu,%c", &ts, &off, &size, &op) != 4 || size == 0 || size > UINT32_MAX || (op != 'R' && op != 'W')){
+			std::cerr << path << ":" << lineNo << ": expected timestamp_ns,offset,size,R|W with 0 < size < 4 GiB\n" ;
+			return false ;
+		}
+		ops.push_back({ts, off, (uint32_t)size, op == 'W'}) ;
+	}
+	std::stable_sort(ops.begin(), ops.end(), [](const TraceOp& a, const TraceOp& b){ return a.ts < b.ts ; }) ;
+	for(size_t i = 1; i < ops.size(); i++) ops[i].ts -= ops[0].ts ;
+	if(!ops.empty()) ops[0].ts = 0 ;
+	return !ops.empty() ;
+}
+
+// blkparse's default text format:
+//   8,0  3  1  0.000000000  697  D  W  223490 + 8 [kjournald]
+// Keeps one action (D, issued to the driver, by default) and reads and
+// writes only; sectors are 512 bytes.
+static int importBlkparse(const std::string& in, const std::string& outPath, char action){
+	std::ifstream src(in) ;
+	if(!src){
+		std::cerr << "cannot read " << in << "\n" ;
+		return 1 ;
+	}
+	// Traces run to millions of lines, so this writes straight to --out (or
+	// stdout) without CsvOut's per-row flush
+	std::ofstream file ;
+	if(!outPath.empty()){
+		file.open(outPath) ;
+		if(!file){
+			std::cerr << "cannot write " << outPath << "\n" ;
+			return 1 ;
+		}
+	}
+	std::ostream& out = outPath.empty() ? std::cout : file ;
+	out << "# timestamp_ns,offset,size,op\n" ;
+	std::string line ;
+	size_t kept = 0 ;
+	while(std::getline(src, line)){
+		char dev[32], act[8], rwbs[16] ;
+		unsigned cpu, pid ;
+		unsigned long long seq, sector, count ;
+		double secs ;
+		if(std::sscanf(line.c_str(), "%31s %u %llu %lf %u %7s %15s %llu + %llu", dev, &cpu, &seq, &secs, &pid, act, rwbs, &sector, &count) != 9) continue ;
+		if(act[0] != action || act[1] || count == 0) continue ;
+		bool write = std::strchr(rwbs, 'W') != nullptr ;
+		if(!write && !std::strchr(rwbs, 'R')) continue ;
+		char row[128] ;
+		std::snprintf(row, sizeof(row), "%llu,%llu,%llu,%c\n", (unsigned long long)std::llround(secs * 1e9),
+			sector * 512ull, count * 512ull, write ? 'W' : 'R') ;
+		out << row ;
+		kept++ ;
+	}
+	std::cerr << "imported " << kept << " I/Os (action " << action << ")\n" ;
+	return kept ? 0 : 1 ;
+}
+
+struct ReplayResult {
+	LatencyHistogram svc[2] ;	// submission -> completion, [0] reads [1] writes
+	LatencyHistogram lat[2] ;	// intended -> completion
+	LatencyHistogram dev ;		// intended -> submission
+	uint64_t bytes[2] = {0, 0} ;
+	uint64_t errors[2] = {0, 0} ;	// completions that failed or came back short
+	uint64_t align = 512 ;
+	double seconds = 0.0 ;
+	double traceSeconds = 0.0 ;
+	bool ok = false ;
+} ;
+
+static bool replayTrace(const std::string& target, const std::vector<TraceOp>& ops, uint64_t span, double speed,
+	unsigned qd, EngineOptions eng, ReplayResult& out){
+	// Trace offsets and sizes are in 512-byte sectors; the target may need
+	// more (4Kn devices, most filesystems under O_DIRECT), so every I/O is
+	// widened to its alignment
+	out.align = ioAlignment(target) ;
+	auto alignUp = [&](uint64_t v){ return (v + out.align - 1) / out.align * out.align ; } ;
+	uint64_t maxSize = 0 ;
+	for(const TraceOp& op : ops) maxSize = std::max(maxSize, alignUp(op.size)) ;
+	JobSpec job ;
+	job.name = "replay" ;
+	job.bs = maxSize ;
+	job.qd = qd ;
+	job.span = span ;
+	IoSession s ;
+	if(!s.open(target, job, eng)) return false ;
+	uint64_t targetBytes = std::min<uint64_t>(span, s.blocks * job.bs) ;
+	std::vector<unsigned> freeSlots ;
+	for(unsigned slot = qd; slot-- > 0;) freeSlots.push_back(slot) ;
+	std::vector<uint64_t> intendedAt(qd) ;
+	std::vector<uint32_t> issuedBytes(qd) ;
+	prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0) ;
+
+	uint64_t start = nowNs() ;
+	size_t next = 0 ;
+	unsigned inflight = 0 ;
+	bool failed = false ;
+	auto dueAt = [&](size_t i) -> uint64_t {
+		return speed > 0.0 ? start + (uint64_t)((double)ops[i].ts / speed) : start ;
+	} ;
+	for(;;){
+		uint64_t now = nowNs() ;
+		bool queued = false ;
+		while(!failed && next < ops.size() && dueAt(next) <= now && !freeSlots.empty()){
+			io_uring_sqe* sqe = s.ring.getSqe() ;
+			if(!sqe) break ;
+			const TraceOp& op = ops[next] ;
+			unsigned slot = freeSlots.back() ;
+			freeSlots.pop_back() ;
+			uint64_t size = alignUp(op.size) ;
+			uint64_t off = op.offset / out.align * out.align ;
+			if(off + size > targetBytes) off = off % (targetBytes - size + 1) / out.align * out.align ;
+			issuedBytes[slot] = (uint32_t)size ;
+			prepRw(sqe, op.write, s.fixedFile ? 0 : s.fd, s.bufs + slot * s.slotBytes, (unsigned)size, off,
+				s.fixedBufs ? (int)slot : -1, s.fixedFile) ;
+			sqe->user_data = slot | (uint64_t)next << 32 ;
+			intendedAt[slot] = dueAt(next) ;
+			s.issuedAt[slot] = nowNs() ;
+			out.dev.record(s.issuedAt[slot] - intendedAt[slot]) ;
+			inflight++ ;
+			queued = true ;
+			next++ ;
+		}
+		if(queued){
+			int r = s.ring.submit(0) ;
+			if(r < 0){
+				std::cerr << "io_uring_enter: " << std::strerror(-r) << "\n" ;
+				failed = true ;
+				break ;
+			}
+		}
+		bool reaped = false ;
+		io_uring_cqe* cqe ;
+		while((cqe = s.ring.peekCqe())){
+			uint64_t done = nowNs() ;
+			unsigned slot = (unsigned)(cqe->user_data & 0xffffffffu) ;
+			const TraceOp& op = ops[cqe->user_data >> 32] ;
+			int rc = cqe->res ;
+			s.ring.cqeSeen() ;
+			inflight-- ;
+			freeSlots.push_back(slot) ;
+			reaped = true ;
+			// a failed I/O is counted and the replay goes on, so one bad
+			// request does not cut the trace short
+			if(rc != (int)issuedBytes[slot]){
+				if(!out.errors[0] && !out.errors[1]){
+					std::cerr << "replay: I/O returned " << (rc < 0 ? std::strerror(-rc) : std::to_string(rc).c_str())
+						<< "; counting failed I/Os and continuing\n" ;
+				}
+				out.errors[op.write]++ ;
+				continue ;
+			}
+			out.svc[op.write].record(done - s.issuedAt[slot]) ;
+			out.lat[op.write].record(done - intendedAt[slot]) ;
+			out.bytes[op.write] += issuedBytes[slot] ;
+		}
+		bool moreDue = !failed && next < ops.size() ;
+		if(!moreDue && !inflight) break ;
+		if(reaped || queued) continue ;
+
+		now = nowNs() ;
+		uint64_t due = moreDue && !freeSlots.empty() ? dueAt(next) : UINT64_MAX ;
+		uint64_t wait = due == UINT64_MAX ? UINT64_MAX : due > now ? due - now : 0 ;
+		if(wait < 20000) continue ;
+		if(inflight) s.ring.waitCqeTimeout(wait == UINT64_MAX ? 1000000000ull : wait) ;
+		else {
+			timespec ts = {(time_t)(wait / 1000000000ull), (long)(wait % 1000000000ull)} ;
+			nanosleep(&ts, nullptr) ;
+		}
+	}
+	out.seconds = (double)(nowNs() - start) / 1e9 ;
+	out.traceSeconds = (double)ops.back().ts / 1e9 ;
+	out.ok = !failed ;
+	if(out.errors[0] || out.errors[1]){
+		std::cerr << "replay: " << out.errors[0] + out.errors[1] << " of " << ops.size() << " I/Os failed ("
+			<< out.errors[0] << " reads, " << out.errors[1] << " writes)\n" ;
+	}
+	return out.ok ;
+}
+
+// One row each for reads, writes and both; lat_* is from the intended
+// issue time, svc_* from actual submission, issue_dev_* the difference.
+// ios and bytes count successful I/Os only, errors the failed ones, and
+// align is the granularity every I/O was widened to.
+static const char* replayHeader = "file,op,speed,ios,bytes,iops,bw_MB_s,svc_avg_ns,svc_p50_ns,svc_p99_ns,svc_p99.9_ns,svc_max_ns,"
+	"lat_p50_ns,lat_p99_ns,lat_p99.9_ns,issue_dev_avg_ns,issue_dev_p50_ns,issue_dev_p99_ns,issue_dev_max_ns,trace_s,replay_s,errors,align\n" ;
+
+static std::string replayRow(const std::string& file, const char* op, double speed, const LatencyHistogram& svc,
+	const LatencyHistogram& lat, uint64_t bytes, uint64_t errors, const ReplayResult& r){
+	char line[1024] ;
+	std::snprintf(line, sizeof(line), "%s,%s,%.6g,%llu,%llu,%.10g,%.10g,%.10g,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.10g,%llu,%llu,%llu,%.6g,%.6g,%llu,%llu\n",
+		file.c_str(), op, speed, (unsigned long long)svc.count(), (unsigned long long)bytes, (double)svc.count() / r.seconds,
+		(double)bytes / r.seconds / (1024.0 * 1024.0), svc.mean(), (unsigned long long)svc.valueAt(0.5),
+		(unsigned long long)svc.valueAt(0.99), (unsigned long long)svc.valueAt(0.999), (unsigned long long)svc.max(),
+		(unsigned long long)lat.valueAt(0.5), (unsigned long long)lat.valueAt(0.99), (unsigned long long)lat.valueAt(0.999),
+		r.dev.mean(), (unsigned long long)r.dev.valueAt(0.5), (unsigned long long)r.dev.valueAt(0.99), (unsigned long long)r.dev.max(),
+		r.traceSeconds, r.seconds, (unsigned long long)errors, (unsigned long long)r.align) ;
+	return line ;
+}
+
+static int benchmarkReplay(const std::string& target, const std::string& tracePath, uint64_t span, double speed, unsigned qd,
+	const EngineOptions& eng, CsvOut& out, const std::string& curvesPath){
+	std::vector<TraceOp> ops ;
+	if(!loadTrace(tracePath, ops)) return 1 ;
+	uint64_t extent = 0 ;
+	for(const TraceOp& op : ops) extent = std::max<uint64_t>(extent, op.offset + op.size) ;
+	if(!span) span = extent ;
+	span = (span + 4095) & ~(uint64_t)4095 ;
+	for(const TraceOp& op : ops){
+		if(op.size > span){
+			std::cerr << "trace has a " << op.size << "-byte I/O, larger than --size\n" ;
+			return 1 ;
+		}
+	}
+	if(!layoutFile(target, span)) return 1 ;
+	std::cerr << "replaying " << ops.size() << " I/Os over " << (double)ops.back().ts / 1e9 << " s at speed " << speed
+		<< " (extent " << extent << " bytes, target span " << span << ")\n" ;
+	ReplayResult r ;
+	if(!replayTrace(target, ops, span, speed, qd, eng, r)) return 1 ;
+	LatencyHistogram svcAll, latAll ;
+	for(int w = 0; w < 2; w++){
+		svcAll.merge(r.svc[w]) ;
+		latAll.merge(r.lat[w]) ;
+	}
+	std::string file = tracePath.substr(tracePath.find_last_of('/') + 1) ;
+	out.emit(replayHeader) ;
+	if(r.svc[0].count() || r.errors[0]) out.emit(replayRow(file, "read", speed, r.svc[0], r.lat[0], r.bytes[0], r.errors[0], r)) ;
+	if(r.svc[1].count() || r.errors[1]) out.emit(replayRow(file, "write", speed, r.svc[1], r.lat[1], r.bytes[1], r.errors[1], r)) ;
+	out.emit(replayRow(file, "all", speed, svcAll, latAll, r.bytes[0] + r.bytes[1], r.errors[0] + r.errors[1], r)) ;
+	if(!curvesPath.empty()){
+		std::ofstream curves(curvesPath) ;
+		if(!curves){
+			std::cerr << "cannot write " << curvesPath << "\n" ;
+			return 1 ;
+		}
+		curves << "file,op,percentile,svc_ns,lat_ns\n" ;
+		const char* names[2] = {"read", "write"} ;
+		for(int w = 0; w < 2; w++){
+			if(!r.svc[w].count()) continue ;
+			for(const auto& pt : r.svc[w].curve()){
+				curves << file << "," << names[w] << "," << pt.first * 100.0 << "," << pt.second << "," << r.lat[w].valueAt(pt.first) << "\n" ;
+			}
+		}
+	}
+	return 0 ;
+}
+
+static bool parseRw(const std::string& rw, JobSpec& job){
+	if(rw == "randread"){ job.random = true ; job.readPct = 100 ; }
+	else if(rw == "randwrite"){ job.random = true ; job.readPct = 0 ; }
+	else if(rw == "randrw"){ job.random = true ; job.readPct = 50 ; }
+	else if(rw == "read"){ job.random = false ; job.readPct = 100 ; }
+	else if(rw == "write"){ job.random = false ; job.readPct = 0 ; }
+	else if(rw == "rw"){ job.random = false ; job.readPct = 50 ; }
+	else return false ;
+	return true ;
+}
+
+// "a,b,c" -> {"a", "b", "c"}
+static std::vector<std::string> splitList(const char* s){
+	std::vector<std::string> v ;
+	std::string item ;
+	for(const char* p = s; ; p++){
+		if(*p == ',' || !*p){
+			if(!item.empty()) v.push_back(item) ;
+			item.clear() ;
+			if(!*p) break ;
+		}
+		else item += *p ;
+	}
+	return v ;
+}
+
+static void usage(const char* pname){
+	std::cerr << "Usage: " << pname << " [mode] --target PATH [options]\n"
+		<< "Modes:\n"
+		<< "  job       one closed-loop job (default)\n"
+		<< "  sweep     every job of runFioSweeps.sh: QD1 baselines, bs 4k-256k, read mixes, QD 1-64, tail\n"
+		<< "  openloop  rate-scheduled I/O, latency from the intended send time, one row per offered rate\n"
+		<< "  scale     1..N pinned threads, each with its own ring and region/file, at --qd per thread\n"
+		<< "  access    file reads via pread, mmap (seq/random/huge advice), O_DIRECT pread and io_uring, warm and cold\n"
+		<< "  import    convert blkparse text (--blkparse FILE) to the replay trace format\n"
+		<< "  replay    replay a trace (--trace FILE) asynchronously at original or --speed-scaled timing\n"
+		<< "  wal       log appends made durable by fsync/fdatasync/O_DSYNC/sync_file_range/io_uring, group commit\n"
+		<< "Options:\n"
+		<< "  --target PATH     file or block device; files are created/filled to --size\n"
+		<< "  --size N          span exercised, e.g. 1g (job default 1g; sweep default per job, 1g/4g; wal log 64m)\n"
+		<< "  --runtime S       seconds per job, rate or run (default 30, access/wal 5)\n"
+		<< "  --rw KIND         randread|randwrite|randrw|read|write|rw (default randread)\n"
+		<< "  --mix PCT         read percentage for randrw/rw (fio rwmixread, default 50)\n"
+		<< "  --bs N            block size (default 4k; access: random read sizes, default 4k,16k,64k,256k,1m; wal: record)\n"
+		<< "  --qd N            queue depth; the outstanding-I/O cap in openloop/replay (default 1, openloop 64, replay 256,\n"
+		<< "                    access io_uring 16)\n"
+		<< "  --name NAME       job name for the file column\n"
+		<< "  --buffered        drop O_DIRECT\n"
+		<< "  --no-fixed        plain buffers and fd instead of registered ones\n"
+		<< "  --sqpoll          kernel SQ polling thread\n"
+		<< "  --rates LIST      openloop: offered IOPS, comma separated (default: fractions of the closed-loop peak)\n"
+		<< "  --arrival KIND    openloop: poisson|fixed inter-arrival times (default poisson)\n"
+		<< "  --curves FILE     openloop/replay: full percentile spectrum per rate or op, to p99.999\n"
+		<< "  --threads N       scale: highest thread count (default every allowed CPU)\n"
+		<< "  --files           scale: one file per thread (TARGET.0, TARGET.1, ...) instead of regions of TARGET\n"
+		<< "  --methods LIST    access: subset of pread,mmap_seq,mmap_random,mmap_huge,odirect,io_uring\n"
+		<< "  --cache KIND      access: warm|cold|both (default both)\n"
+		<< "  --sizes LIST|auto access: file sizes to sweep; auto = 0.25-1.5x RAM to cross the page cache\n"
+		<< "  --trace FILE      replay: timestamp_ns,offset,size,R|W per line\n"
+		<< "  --speed X         replay: divide trace timing by X; 0 replays back to back (default 1)\n"
+		<< "  --blkparse FILE   import: blkparse text output\n"
+		<< "  --action A        import: blktrace action to keep, D (driver issue) or Q (queued) (default D)\n"
+		<< "  --sync LIST       wal: subset of fsync,fdatasync,odsync,sync_file_range,io_uring\n"
+		<< "  --batches LIST    wal: group-commit batch sizes (default 1,2,4,8,16,32,64)\n"
+		<< "  --committers N    wal: committer threads (default: the batch size)\n"
+		<< "  --window US       wal: how long a leader waits for its batch to fill (default 100)\n"
+		<< "  --out FILE        write the CSV to FILE as well as stdout\n"
+		<< "  --repeats N       job/sweep: run every job N times, one summary row each (default 1)\n"
+		<< "  --results FILE    job/sweep only (other modes reject it): append IOPS and mean latency, one sample per repeat, in the shared result\n"
+		<< "                    schema (Common/BenchResult.h), for Common/compareResults.py; that needs --repeats 5 or more\n"
+		<< "Examples:\n"
+		<< "  " << pname << " job --target /mnt/scratch/test.bin --rw randread --bs 4k --qd 32 --runtime 10\n"
+		<< "  " << pname << " sweep --target /dev/shm/test.bin --size 256m --runtime 5 --out summary.csv\n"
+		<< "  " << pname << " sweep --target /mnt/scratch/test.bin --repeats 5 --results nightly.jsonl\n"
+		<< "  " << pname << " openloop --target /mnt/scratch/test.bin --runtime 20 --out openloop.csv --curves curves.csv\n"
+		<< "  " << pname << " scale --target /dev/nvme0n1 --qd 32 --runtime 10 --out scale.csv\n"
+		<< "  " << pname << " access --target /mnt/scratch/test.bin --size 4g --bs 4k,1m --out access.csv\n"
+		<< "  " << pname << " import --blkparse trace.txt --out trace.csv\n"
+		<< "  " << pname << " replay --target /mnt/scratch/test.bin --trace trace.csv --speed 2\n"
+		<< "  " << pname << " wal --target /mnt/scratch/wal.log --bs 4k --window 200 --out wal.csv\n" ;
+}
+
+int main(int argc, char** argv){
+	std::string mode = "job" ;
+	int first = 1 ;
+	if(argc > 1 && argv[1][0] != '-'){
+		mode = argv[1] ;
+		first = 2 ;
+	}
+	std::string target, outPath, curvesPath, resultsPath, rw = "randread", name ;
+	JobSpec job ;
+	EngineOptions eng ;
+	size_t span = 0 ;
+	int mix = -1 ;
+	bool qdSet = false, poisson = true, runtimeSet = false, perThreadFiles = false ;
+	int maxThreads = 0, committers = 0, repeats = 1 ;
+	uint64_t windowNs = 100000 ;
+	std::string tracePath, blkparsePath ;
+	double speed = 1.0 ;
+	char action = 'D' ;
+	std::vector<int> syncMethods ;
+	for(int k = 0; k < SM_COUNT; k++) syncMethods.push_back(k) ;
+	std::vector<size_t> batchList = {1, 2, 4, 8, 16, 32, 64} ;
+	std::vector<double> rates ;
+	std::vector<size_t> bsList, sizes ;
+	std::vector<int> methods ;
+	for(int k = 0; k < RM_COUNT; k++) methods.push_back(k) ;
+	std::vector<bool> caches = {true, false} ;
+	for(int i = first; i < argc; i++){
+		if(std::strcmp(argv[i], "--target") == 0 && i+1 < argc) target = argv[++i] ;
+		else if(std::strcmp(argv[i], "--size") == 0 && i+1 < argc) span = parseSize(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--runtime") == 0 && i+1 < argc){ job.runtime = std::atof(argv[++i]) ; runtimeSet = true ; }
+		else if(std::strcmp(argv[i], "--rw") == 0 && i+1 < argc) rw = argv[++i] ;
+		else if(std::strcmp(argv[i], "--mix") == 0 && i+1 < argc) mix = std::atoi(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--bs") == 0 && i+1 < argc){
+			bsList.clear() ;
+			for(const std::string& b : splitList(argv[++i])) bsList.push_back(parseSize(b.c_str())) ;
+			if(!bsList.empty()) job.bs = bsList[0] ;
+		}
+		else if(std::strcmp(argv[i], "--qd") == 0 && i+1 < argc){ job.qd = (unsigned)std::max(1, std::atoi(argv[++i])) ; qdSet = true ; }
+		else if(std::strcmp(argv[i], "--name") == 0 && i+1 < argc) name = argv[++i] ;
+		else if(std::strcmp(argv[i], "--out") == 0 && i+1 < argc) outPath = argv[++i] ;
+		else if(std::strcmp(argv[i], "--results") == 0 && i+1 < argc) resultsPath = argv[++i] ;
+		else if(std::strcmp(argv[i], "--repeats") == 0 && i+1 < argc) repeats = std::max(1, std::atoi(argv[++i])) ;
+		else if(std::strcmp(argv[i], "--curves") == 0 && i+1 < argc) curvesPath = argv[++i] ;
+		else if(std::strcmp(argv[i], "--rates") == 0 && i+1 < argc){
+			for(const std::string& r : splitList(argv[++i])) rates.push_back(std::atof(r.c_str())) ;
+		}
+		else if(std::strcmp(argv[i], "--methods") == 0 && i+1 < argc){
+			methods.clear() ;
+			for(const std::string& m : splitList(argv[++i])){
+				int found = -1 ;
+				for(int k = 0; k < RM_COUNT; k++) if(m == readMethodNames[k]) found = k ;
+				if(found < 0){ std::cerr << "Unknown method: " << m << "\n" ; usage(argv[0]) ; return 1 ; }
+				methods.push_back(found) ;
+			}
+		}
+		else if(std::strcmp(argv[i], "--cache") == 0 && i+1 < argc){
+			std::string c = argv[++i] ;
+			if(c == "warm") caches = {true} ;
+			else if(c == "cold") caches = {false} ;
+			else if(c == "both") caches = {true, false} ;
+			else { std::cerr << "Unknown cache mode: " << c << "\n" ; usage(argv[0]) ; return 1 ; }
+		}
+		else if(std::strcmp(argv[i], "--sizes") == 0 && i+1 < argc){
+			std::string v = argv[++i] ;
+			if(v == "auto") sizes = autoFileSizes() ;
+			else for(const std::string& z : splitList(v.c_str())) sizes.push_back(parseSize(z.c_str())) ;
+		}
+		else if(std::strcmp(argv[i], "--arrival") == 0 && i+1 < argc){
+			std::string a = argv[++i] ;
+			if(a == "poisson") poisson = true ;
+			else if(a == "fixed") poisson = false ;
+			else { std::cerr << "Unknown arrival: " << a << "\n" ; usage(argv[0]) ; return 1 ; }
+		}
+		else if(std::strcmp(argv[i], "--threads") == 0 && i+1 < argc) maxThreads = std::atoi(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--trace") == 0 && i+1 < argc) tracePath = argv[++i] ;
+		else if(std::strcmp(argv[i], "--speed") == 0 && i+1 < argc) speed = std::atof(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--blkparse") == 0 && i+1 < argc) blkparsePath = argv[++i] ;
+		else if(std::strcmp(argv[i], "--action") == 0 && i+1 < argc) action = argv[++i][0] ;
+		else if(std::strcmp(argv[i], "--committers") == 0 && i+1 < argc) committers = std::atoi(argv[++i]) ;
+		else if(std::strcmp(argv[i], "--window") == 0 && i+1 < argc) windowNs = (uint64_t)(std::atof(argv[++i]) * 1000.0) ;
+		else if(std::strcmp(argv[i], "--batches") == 0 && i+1 < argc){
+			batchList.clear() ;
+			for(const std::string& b : splitList(argv[++i])) batchList.push_back((size_t)std::max(1, std::atoi(b.c_str()))) ;
+		}
+		else if(std::strcmp(argv[i], "--sync") == 0 && i+1 < argc){
+			syncMethods.clear() ;
+			for(const std::string& m : splitList(argv[++i])){
+				int found = -1 ;
+				for(int k = 0; k < SM_COUNT; k++) if(m == syncMethodNames[k]) found = k ;
+				if(found < 0){ std::cerr << "Unknown sync method: " << m << "\n" ; usage(argv[0]) ; return 1 ; }
+				syncMethods.push_back(found) ;
+			}
+		}
+		else if(std::strcmp(argv[i], "--files") == 0) perThreadFiles = true ;
+		else if(std::strcmp(argv[i], "--buffered") == 0) eng.direct = false ;
+		else if(std::strcmp(argv[i], "--no-fixed") == 0) eng.fixed = false ;
+		else if(std::strcmp(argv[i], "--sqpoll") == 0) eng.sqpoll = true ;
+		else { std::cerr << "Unknown arg: " << argv[i] << "\n" ; usage(argv[0]) ; return 1 ; }
+	}
+	// Only job and sweep write result records; elsewhere the file would stay empty
+	if(!resultsPath.empty() && mode != "job" && mode != "sweep"){
+		std::cerr << "--results is supported in job and sweep modes, not " << mode << "\n" ;
+		return 1 ;
+	}
+	if(mode == "import"){
+		if(blkparsePath.empty()){
+			std::cerr << "--blkparse is required\n" ;
+			usage(argv[0]) ;
+			return 1 ;
+		}
+		return importBlkparse(blkparsePath, outPath, action) ;
+	}
+	benchClockInit() ;
+	if(target.empty()){
+		std::cerr << "--target is required\n" ;
+		usage(argv[0]) ;
+		return 1 ;
+	}
+	for(size_t bs : bsList.empty() ? std::vector<size_t>{job.bs} : bsList){
+		if(bs == 0 || bs % 512 != 0){
+			std::cerr << "block size must be a multiple of 512\n" ;
+			return 1 ;
+		}
+	}
+
+	if(mode == "replay"){
+		if(tracePath.empty()){
+			std::cerr << "--trace is required\n" ;
+			usage(argv[0]) ;
+			return 1 ;
+		}
+		CsvOut out ;
+		if(!out.open(outPath)) return 1 ;
+		return benchmarkReplay(target, tracePath, span, speed, qdSet ? job.qd : 256, eng, out, curvesPath) ;
+	}
+
+	if(mode == "wal"){
+		CsvOut out ;
+		if(!out.open(outPath)) return 1 ;
+		return benchmarkWal(target, syncMethods, batchList, committers, job.bs, span ? span : (uint64_t)64 << 20, windowNs,
+			runtimeSet ? job.runtime : 5.0, out) ;
+	}
+
+	if(mode == "access"){
+		CsvOut out ;
+		if(!out.open(outPath)) return 1 ;
+		if(sizes.empty()) sizes.push_back(span ? span : job.span) ;
+		if(bsList.empty()) bsList = {4096, 16384, 65536, 262144, 1048576} ;
+		return benchmarkAccess(target, sizes, bsList, methods, caches, qdSet ? job.qd : 16, runtimeSet ? job.runtime : 5.0, out) ;
+	}
+
+	std::vector<JobSpec> jobs ;
+	if(mode == "job" || mode == "openloop" || mode == "scale"){
+		if(!parseRw(rw, job)){
+			std::cerr << "Unknown rw: " << rw << "\n" ;
+			return 1 ;
+		}
+		if(mix >= 0 && (rw == "randrw" || rw == "rw")) job.readPct = std::min(100, mix) ;
+		if(span) job.span = span ;
+		if(mode == "openloop" && !qdSet) job.qd = 64 ;
+		std::string base = rw + "_" + std::to_string(job.bs >> 10) + "k" ;
+		job.name = !name.empty() ? name : mode == "job" ? base + "_qd" + std::to_string(job.qd) : mode + "_" + base ;
+		jobs.push_back(job) ;
+	}
+	else if(mode == "sweep") jobs = fioSweepJobs(span, job.runtime) ;
+	else {
+		std::cerr << "Unknown mode: " << mode << "\n" ;
+		usage(argv[0]) ;
+		return 1 ;
+	}
+
+	if(mode == "scale"){
+		CsvOut out ;
+		if(!out.open(outPath)) return 1 ;
+		return benchmarkScaling(target, job, eng, maxThreads, perThreadFiles, out) ;
+	}
+
+	uint64_t need = 0 ;
+	for(const JobSpec& j : jobs) need = std::max<uint64_t>(need, j.span) ;
+	if(!layoutFile(target, need)) return 1 ;
+
+	CsvOut out ;
+	if(!out.open(outPath)) return 1 ;
+	bench_results_t results = {} ;
+	if(!resultsPath.empty() && benchResultsOpen(&results, resultsPath.c_str()) != 0) return 1 ;
+	if(mode == "openloop") return benchmarkOpenLoop(target, job, eng, rates, poisson, out, curvesPath) ;
+
+	out.emit(summaryHeader) ;
+	int failures = 0 ;
+	for(const JobSpec& j : jobs){
+		std::cerr << j.name << ": bs=" << j.bs << " qd=" << j.qd << " read=" << j.readPct << "% "
+			<< (j.random ? "random" : "sequential") << " " << j.runtime << "s" << (repeats > 1 ? " x " + std::to_string(repeats) : "") << "\n" ;
+		std::vector<JobResult> runs ;
+		for(int r = 0; r < repeats; r++){
+			JobResult res = runJob(target, j, eng) ;
+			if(!res.ok){
+				failures++ ;
+				continue ;
+			}
+			out.emit(summaryRow(j, eng, res)) ;
+			runs.push_back(res) ;
+		}
+		if(!runs.empty()) jobResults(results, j, eng, runs) ;
+	}
+	benchResultsClose(&results) ;
+	return failures ? 1 : 0 ;
+}
+
+#else
+
+int main(){
+	std::cerr << "StorageBench needs Linux io_uring\n" ;
+	return 1 ;
+}
+
+#endif
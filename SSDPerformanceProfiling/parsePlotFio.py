@@ -1,18 +1,25 @@
 #!/usr/bin/env python3
-import json, glob, os
+import json, glob, os, sys
 import pandas as pd
 import matplotlib.pyplot as plt
 
-RESULT_DIRS = sorted(glob.glob("fio_results_*"))
-if not RESULT_DIRS:
-    print("No fio_results_* directories found. Run run_fio_sweeps.sh first.")
-    exit(1)
-
-RESULT_DIR = RESULT_DIRS[-1]
-print("Reading results from:", RESULT_DIR)
+# A summary CSV given on the command line (e.g. StorageBench sweep --out) is
+# plotted as is, next to the file; otherwise the newest fio_results_* is parsed
+CSV_IN = sys.argv[1] if len(sys.argv) > 1 and sys.argv[1].endswith(".csv") else None
+
+if CSV_IN:
+    RESULT_DIR = os.path.dirname(os.path.abspath(CSV_IN))
+    print("Reading summary from:", CSV_IN)
+else:
+    RESULT_DIRS = sorted(glob.glob("fio_results_*"))
+    if not RESULT_DIRS:
+        print("No fio_results_* directories found. Run run_fio_sweeps.sh first.")
+        exit(1)
+    RESULT_DIR = RESULT_DIRS[-1]
+    print("Reading results from:", RESULT_DIR)
 
 rows = []
-for fn in sorted(glob.glob(os.path.join(RESULT_DIR, "*.json"))):
+for fn in ([] if CSV_IN else sorted(glob.glob(os.path.join(RESULT_DIR, "*.json")))):
     with open(fn, "r") as f:
         data = json.load(f)
     job = data.get("jobs", [None])[0]
@@ -77,10 +84,13 @@ for fn in sorted(glob.glob(os.path.join(RESULT_DIR, "*.json"))):
         "p99.9_ns": p999,
     })
 
-df = pd.DataFrame(rows)
-csv_out = os.path.join(RESULT_DIR, "summary.csv")
-df.to_csv(csv_out, index=False)
-print("Summary CSV written to", csv_out)
+if CSV_IN:
+    df = pd.read_csv(CSV_IN)
+else:
+    df = pd.DataFrame(rows)
+    csv_out = os.path.join(RESULT_DIR, "summary.csv")
+    df.to_csv(csv_out, index=False)
+    print("Summary CSV written to", csv_out)
 print(df[["file","bw_MB_s","iops","avg_lat_ns","p95_ns","p99_ns","p99.9_ns"]])
 
 # ---- Example plots (block-size & QD sweep) ----
@@ -128,13 +138,6 @@ if not qd_rows.empty:
     plt.savefig(os.path.join(RESULT_DIR, 'qd_sweep.png'))
     print("Saved:", os.path.join(RESULT_DIR, 'qd_sweep.png'))
 
-    # throughput vs latency
-    plt.figure(figsize=(8,5))
-    plt.plot(qd_rows['bw_MB_s'], qd_rows['avg_lat_ns'].astype(float)/1000.0,
-             marker='o')
-    plt.xlabel('Throughput (MB/s)')
-    plt.ylabel('Avg latency (us)')
-    plt.title('Throughput vs latency (QD sweep)')
-    plt.grid(True)
-    plt.savefig(os.path.join(RESULT_DIR, 'throughput_vs_latency.png'))
-    print("Saved:", os.path.join(RESULT_DIR, 'throughput_vs_latency.png'))
+    # Latency against load now comes from the open-loop runs, which do not
+    # hide queueing the way this closed-loop QD sweep does:
+    # StorageBench openloop ... then plotOpenLoop.py -> latency_vs_offered_load.png
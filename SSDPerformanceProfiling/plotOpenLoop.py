@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+# Plots StorageBench openloop output. Replaces the closed-loop
+# throughput_vs_latency.png from parsePlotFio.py with latency percentiles
+# (from the intended send time) against offered load, and, when the --curves
+# file is given too, the full percentile spectrum per offered rate.
+#
+# Usage: python3 plotOpenLoop.py openloop.csv [curves.csv]
+import math, os, sys
+import pandas as pd
+import matplotlib.pyplot as plt
+
+if len(sys.argv) < 2:
+    print("Usage: plotOpenLoop.py openloop.csv [curves.csv]")
+    exit(1)
+
+OUT_DIR = os.path.dirname(os.path.abspath(sys.argv[1]))
+df = pd.read_csv(sys.argv[1]).sort_values("offered_iops")
+
+# ---- latency vs offered load ----
+plt.figure(figsize=(8,5))
+for col, label in (("p50_ns", "p50"), ("p99_ns", "p99"), ("p99.9_ns", "p99.9"),
+                   ("p99.99_ns", "p99.99"), ("p99.999_ns", "p99.999")):
+    plt.plot(df["offered_iops"], df[col] / 1000.0, marker="o", label=label)
+plt.plot(df["offered_iops"], df["svc_p99_ns"] / 1000.0, ls="--", color="gray", label="p99 service (closed-loop view)")
+plt.yscale("log")
+plt.xlabel("Offered load (IOPS)")
+plt.ylabel("Latency from intended send (us)")
+plt.title("Latency vs offered load (open loop, %s arrivals)" % df["arrival"].iloc[0])
+plt.legend()
+plt.grid(True, which="both", ls="--")
+out = os.path.join(OUT_DIR, "latency_vs_offered_load.png")
+plt.savefig(out)
+print("Saved:", out)
+
+# ---- percentile spectrum ----
+if len(sys.argv) > 2:
+    curves = pd.read_csv(sys.argv[2])
+    plt.figure(figsize=(8,5))
+    for rate, g in curves.groupby("offered_iops"):
+        g = g[g["percentile"] < 100.0]
+        # x = number of nines, so p99.999 sits at 5
+        nines = -(1.0 - g["percentile"] / 100.0).apply(math.log10)
+        plt.plot(nines, g["lat_ns"] / 1000.0, label="%.0f IOPS" % rate)
+    ticks = [0.30103, 1, 2, 3, 4, 5]
+    plt.xticks(ticks, ["p50", "p90", "p99", "p99.9", "p99.99", "p99.999"])
+    plt.yscale("log")
+    plt.xlabel("Percentile")
+    plt.ylabel("Latency from intended send (us)")
+    plt.title("Latency percentile spectrum per offered load")
+    plt.legend(fontsize="small")
+    plt.grid(True, which="both", ls="--")
+    out = os.path.join(OUT_DIR, "latency_percentiles.png")
+    plt.savefig(out)
+    print("Saved:", out)